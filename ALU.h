@@ -2,9 +2,12 @@
 #define __ALU_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
 
 #include <cassert>
 
+SIMULATOR_NAMESPACE_BEGIN
+
 class ALU : public DigitalCircuit {
 
   public:
@@ -56,6 +59,11 @@ class ALU : public DigitalCircuit {
       *_oZero = (result == 0) ? 1 : 0;
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iALUControl, _iInput0, _iInput1 });
+      outputs.insert(outputs.end(), { _oOutput, _oZero });
+    }
+
   private:
 
     const Wire<4> *_iALUControl;
@@ -66,5 +74,7 @@ class ALU : public DigitalCircuit {
 
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
 
@@ -2,9 +2,12 @@
 #define __ALU_CONTROL_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
 
 #include <cassert>
 
+SIMULATOR_NAMESPACE_BEGIN
+
 class ALUControl : public DigitalCircuit {
 
   public:
@@ -23,7 +26,7 @@ class ALUControl : public DigitalCircuit {
       uint8_t controlSignal = 0b0000; // Default to AND
 
       switch (aluOp) {
-          case 0x0: // lw, sw
+          case 0x0: // lw, sw, addi
             controlSignal = 0b0010; // ADD
             break;
           case 0x1: // beq
@@ -52,6 +55,11 @@ class ALUControl : public DigitalCircuit {
       *_oOperation = std::bitset<4>(controlSignal);
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iALUOp, _iFunct });
+      outputs.insert(outputs.end(), { _oOperation });
+    }
+
   private:
 
     const Wire<2> *_iALUOp;
@@ -60,5 +68,7 @@ class ALUControl : public DigitalCircuit {
 
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
 
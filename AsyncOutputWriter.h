@@ -0,0 +1,219 @@
+#ifndef __ASYNC_OUTPUT_WRITER_H__
+#define __ASYNC_OUTPUT_WRITER_H__
+
+#include "OutputRecord.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef ASYNC_OUTPUT_BUFFER_WORDS
+#define ASYNC_OUTPUT_BUFFER_WORDS (1 << 20) // <-- the capacity of the record ring buffer in 32-bit words (a power of two)
+#endif
+
+#ifndef ASYNC_OUTPUT_FLUSH_BYTES
+#define ASYNC_OUTPUT_FLUSH_BYTES (64 * 1024) // <-- the bytes of text formatted before a write to the file
+#endif
+
+class AsyncOutputWriter {
+
+  public:
+
+    typedef std::function<void(OutputRecordReader &, std::string &)> Formatter;
+
+    // AsyncOutputWriter::AsyncOutputWriter()
+    //   - the simulation thread pushes records into a single-producer,
+    //     single-consumer ring buffer without taking any lock, and a
+    //     background thread formats them with 'formatter' and writes the
+    //     text into 'file' in the order the records were pushed
+    AsyncOutputWriter(FILE *file, const Formatter &formatter,
+                      const size_t capacity = ASYNC_OUTPUT_BUFFER_WORDS) {
+      assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+      _file = file;
+      _formatter = formatter;
+      _ring.resize(capacity);
+      _mask = capacity - 1;
+      _head = 0;
+      _tail = 0;
+      _numPushed = 0;
+      _numWritten = 0;
+      _producerWaiting = false;
+      _stop = false;
+      _thread = std::thread(&AsyncOutputWriter::_run, this);
+    }
+
+    // void AsyncOutputWriter::push()
+    //   - copies 'record' into the ring buffer; the caller only waits when
+    //     the ring buffer is full, i.e., when the formatting falls behind,
+    //     and then blocks (rather than spins) until the background thread
+    //     takes a record out, so the simulation is throttled to the speed
+    //     of the formatting without taking a core from it
+    //   - a record larger than the free space (even one larger than the
+    //     whole ring, e.g., the PVS of a program with a big data memory)
+    //     goes through the ring in pieces, each published as soon as it is
+    //     copied so the background thread can take it out
+    void push(const OutputRecord &record) {
+      std::uint64_t head = _head.load(std::memory_order_relaxed);
+      std::uint64_t numFree = _waitForSpace(head);
+      _ring[head & _mask] = (std::uint32_t)record.size();
+      head += 1;
+      numFree -= 1;
+      for (size_t i = 0; i < record.size(); ) {
+        if (numFree == 0) {
+          _head.store(head, std::memory_order_release);
+          numFree = _waitForSpace(head);
+        }
+        const size_t n = std::min<std::uint64_t>(numFree, record.size() - i);
+        for (size_t j = 0; j < n; j++) {
+          _ring[(head + j) & _mask] = record[i + j];
+        }
+        head += n;
+        numFree -= n;
+        i += n;
+      }
+      _head.store(head, std::memory_order_release);
+      _numPushed += 1;
+    }
+
+    // void AsyncOutputWriter::drain()
+    //   - waits until every pushed record has been written, e.g., before
+    //     the simulation thread prints something by itself
+    void drain() {
+      _block([this]() { return _numWritten.load(std::memory_order_acquire) == _numPushed; });
+      fflush(_file);
+    }
+
+    ~AsyncOutputWriter() {
+      drain();
+      _stop.store(true, std::memory_order_release);
+      _thread.join();
+    }
+
+  private:
+
+    void _run() {
+      OutputRecord record;
+      std::string text;
+      std::uint64_t numFormatted = 0;
+      while (true) {
+        const std::uint64_t tail = _tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = _head.load(std::memory_order_acquire);
+        if (tail == head) {
+          if (numFormatted != _numWritten.load(std::memory_order_relaxed)) {
+            _write(text, numFormatted);
+            continue;
+          }
+          if (_stop.load(std::memory_order_acquire)) {
+            break;
+          }
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+          continue;
+        }
+
+        // the record is copied out first, so that its space is handed back
+        // to the producer before the (slower) formatting; a record the
+        // producer is still pushing in pieces is taken out as they come
+        const size_t n = _ring[tail & _mask];
+        std::uint64_t next = tail + 1;
+        record.resize(n);
+        for (size_t i = 0; i < n; ) {
+          const std::uint64_t numReady = _head.load(std::memory_order_acquire) - next;
+          if (numReady == 0) {
+            _tail.store(next, std::memory_order_release);
+            _wakeProducer();
+            std::this_thread::yield();
+            continue;
+          }
+          const size_t m = std::min<std::uint64_t>(numReady, n - i);
+          for (size_t j = 0; j < m; j++) {
+            record[i + j] = _ring[(next + j) & _mask];
+          }
+          next += m;
+          i += m;
+        }
+        _tail.store(next, std::memory_order_release);
+        _wakeProducer();
+
+        OutputRecordReader reader(record.data());
+        _formatter(reader, text);
+        numFormatted += 1;
+        if (text.size() >= ASYNC_OUTPUT_FLUSH_BYTES) {
+          _write(text, numFormatted);
+        }
+      }
+    }
+
+    // the words free in the ring from 'head' on, once there is at least one
+    std::uint64_t _waitForSpace(std::uint64_t head) {
+      std::uint64_t numFree = 0;
+      _block([&]() {
+        numFree = _ring.size() - (head - _tail.load(std::memory_order_acquire));
+        return numFree > 0;
+      });
+      return numFree;
+    }
+
+    // blocks the producer until 'done' holds; the producer announces that
+    // it waits before it checks 'done' and the consumer publishes its
+    // progress before it checks the announcement (each with a full fence
+    // in between), so the wake-up cannot fall between the two
+    template <typename Predicate>
+    void _block(const Predicate &done) {
+      if (done()) {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(_mutex);
+      _producerWaiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      _progress.wait(lock, done);
+      _producerWaiting.store(false, std::memory_order_relaxed);
+    }
+
+    void _wakeProducer() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_producerWaiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _progress.notify_one();
+      }
+    }
+
+    void _write(std::string &text, std::uint64_t numFormatted) {
+      fwrite(text.data(), 1, text.size(), _file);
+      text.clear();
+      _numWritten.store(numFormatted, std::memory_order_release);
+      _wakeProducer();
+    }
+
+    FILE *_file;
+    Formatter _formatter;
+
+    std::vector<std::uint32_t> _ring; // each record is its length followed by its words
+    std::uint64_t _mask;
+    std::atomic<std::uint64_t> _head; // the next word to be pushed, owned by the producer
+    std::atomic<std::uint64_t> _tail; // the next word to be formatted, owned by the consumer
+
+    std::uint64_t _numPushed; // the number of records pushed (producer only)
+    std::atomic<std::uint64_t> _numWritten; // the number of records whose text has been written
+    std::atomic<bool> _producerWaiting; // true while the producer blocks in push() or drain()
+    std::mutex _mutex; // guards the producer's sleep on '_progress'
+    std::condition_variable _progress; // signalled when space is freed or records are written
+    std::atomic<bool> _stop;
+    std::thread _thread;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef __CLOCK_DOMAIN_H__
+#define __CLOCK_DOMAIN_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef CLOCK_CORE_PERIOD
+#define CLOCK_CORE_PERIOD 2 // <-- the ticks of the timeline between two edges of the core clock
+#endif
+
+#ifndef CLOCK_MEM_PERIOD
+#define CLOCK_MEM_PERIOD 4 // <-- the ticks between two edges of the data memory clock (4 = half the core frequency)
+#endif
+
+#ifndef CLOCK_MEM_PHASE
+#define CLOCK_MEM_PHASE 0 // <-- the tick of the first edge of the data memory clock
+#endif
+
+// ClockDomain
+//   - a clock with its own period and phase on the timeline of a
+//     ClockScheduler, i.e., its edges are at phase, phase + period, ...;
+//     the ratio of two domains is the ratio of their periods
+//   - the components and the stage groups added to a domain are evaluated
+//     on its edges only, in the order they were added
+//   - a signal from another domain is read through a synchronizing latch
+//     (see SyncLatch) added with addSync(), which samples it on the edges
+//     of this domain
+class ClockDomain {
+
+  public:
+
+    typedef std::function<void()> Member;
+
+    ClockDomain(const std::string &name, const std::uint64_t period, const std::uint64_t phase = 0) {
+      assert(period > 0);
+      _name = name;
+      _period = period;
+      _phase = phase;
+      _numCycles = 0;
+    }
+
+    const std::string &getName() const {
+      return _name;
+    }
+
+    std::uint64_t getPeriod() const {
+      return _period;
+    }
+
+    std::uint64_t getPhase() const {
+      return _phase;
+    }
+
+    // std::uint64_t ClockDomain::getNumCycles()
+    //   - the edges the domain has had
+    std::uint64_t getNumCycles() const {
+      return _numCycles;
+    }
+
+    void add(const Member &member) {
+      _members.push_back(member);
+    }
+
+    void add(DigitalCircuit *component) {
+      _members.push_back([component]() { component->advanceCycle(); });
+    }
+
+    void addSync(DigitalCircuit *latch) {
+      _syncs.push_back(latch);
+    }
+
+    // std::uint64_t ClockDomain::nextEdge()
+    //   - the tick of the first edge at or after 'tick'
+    std::uint64_t nextEdge(const std::uint64_t tick) const {
+      if (tick <= _phase) {
+        return _phase;
+      }
+      return _phase + (tick - _phase + _period - 1) / _period * _period;
+    }
+
+    void reset() {
+      _numCycles = 0;
+    }
+
+  private:
+
+    friend class ClockScheduler;
+
+    std::string _name;
+    std::uint64_t _period;
+    std::uint64_t _phase;
+    std::uint64_t _numCycles;
+    std::vector<Member> _members;
+    std::vector<DigitalCircuit *> _syncs;
+
+};
+
+// ClockScheduler
+//   - advances a global timeline from one edge to the next; at a tick where
+//     several domains have an edge, every synchronizing latch of those
+//     domains samples first, so a signal crossing between two domains that
+//     share the edge is seen as it was before the edge, as a flip-flop would
+class ClockScheduler {
+
+  public:
+
+    ClockScheduler() {
+      _nextTick = 0;
+      _currTick = 0;
+    }
+
+    void addDomain(ClockDomain *domain) {
+      _domains.push_back(domain);
+    }
+
+    // std::uint64_t ClockScheduler::getTime()
+    //   - the tick of the last edge evaluated
+    std::uint64_t getTime() const {
+      return _currTick;
+    }
+
+    // void ClockScheduler::step()
+    //   - evaluates the domains that have the next edge on the timeline
+    void step() {
+      assert(!_domains.empty());
+      std::uint64_t tick = UINT64_MAX;
+      for (const ClockDomain *domain : _domains) {
+        tick = std::min(tick, domain->nextEdge(_nextTick));
+      }
+      std::vector<ClockDomain *> active;
+      for (ClockDomain *domain : _domains) {
+        if (domain->nextEdge(tick) == tick) {
+          active.push_back(domain);
+        }
+      }
+      for (ClockDomain *domain : active) {
+        for (DigitalCircuit *latch : domain->_syncs) {
+          latch->advanceCycle();
+        }
+      }
+      for (ClockDomain *domain : active) {
+        domain->_numCycles += 1;
+        for (const ClockDomain::Member &member : domain->_members) {
+          member();
+        }
+      }
+      _currTick = tick;
+      _nextTick = tick + 1;
+    }
+
+    // void ClockScheduler::runUntil()
+    //   - steps until 'domain' has had its next edge (the other domains
+    //     have their edges up to and including that tick)
+    void runUntil(const ClockDomain *domain) {
+      const std::uint64_t numCycles = domain->getNumCycles();
+      while (domain->getNumCycles() == numCycles) {
+        step();
+      }
+    }
+
+    void reset() {
+      _nextTick = 0;
+      _currTick = 0;
+      for (ClockDomain *domain : _domains) {
+        domain->reset();
+      }
+    }
+
+    void printStats() {
+      printf("Clock Domain Statistics (%lu ticks):\n", (unsigned long)_currTick);
+      for (const ClockDomain *domain : _domains) {
+        printf("  %-18s = %lu cycles (period %lu, phase %lu)\n", domain->getName().c_str(),
+               (unsigned long)domain->getNumCycles(), (unsigned long)domain->getPeriod(),
+               (unsigned long)domain->getPhase());
+      }
+    }
+
+  private:
+
+    std::vector<ClockDomain *> _domains;
+    std::uint64_t _nextTick; // the first tick not evaluated yet
+    std::uint64_t _currTick;
+
+};
+
+// SyncLatch
+//   - a synchronizing latch at a clock domain crossing: it samples 'input',
+//     driven in one domain, on the edges of the domain it is added to (with
+//     ClockDomain::addSync()), and holds it for that domain until the next
+//     edge
+template<typename T>
+class SyncLatch : public DigitalCircuit {
+
+  public:
+
+    SyncLatch(const std::string &name, const T *input)
+      : DigitalCircuit(name) {
+      _input = input;
+      _output = T();
+    }
+
+    const T &getOutput() const {
+      return _output;
+    }
+
+    void reset() {
+      _output = T();
+    }
+
+    virtual void advanceCycle() {
+      _output = *_input;
+    }
+
+  private:
+
+    const T *_input;
+    T _output;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
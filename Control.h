@@ -2,6 +2,9 @@
 #define __CONTROL_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+SIMULATOR_NAMESPACE_BEGIN
 
 class Control : public DigitalCircuit {
 
@@ -55,6 +58,16 @@ class Control : public DigitalCircuit {
           *_oBranch = 0;
           *_oALUOp = 0b00;
           break;
+        case 0b001000: // addi
+          *_oRegDst = 0;
+          *_oALUSrc = 1;
+          *_oMemToReg = 0;
+          *_oRegWrite = 1;
+          *_oMemRead = 0;
+          *_oMemWrite = 0;
+          *_oBranch = 0;
+          *_oALUOp = 0b00;
+          break;
         case 0b101011: // sw
           *_oRegDst = 0; 
           *_oALUSrc = 1;
@@ -88,6 +101,11 @@ class Control : public DigitalCircuit {
       }
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iOpcode });
+      outputs.insert(outputs.end(), { _oRegDst, _oALUSrc, _oMemToReg, _oRegWrite, _oMemRead, _oMemWrite, _oBranch, _oALUOp });
+    }
+
   private:
 
     const Wire<6> *_iOpcode;
@@ -102,5 +120,7 @@ class Control : public DigitalCircuit {
 
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
 
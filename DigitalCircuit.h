@@ -1,11 +1,16 @@
 #ifndef __DIGITAL_CIRCUIT_H__
 #define __DIGITAL_CIRCUIT_H__
 
+#include "SimulatorNamespace.h"
+
 #include <string>
 #include <bitset>
+#include <vector>
 
 #include <cstdio>
 
+SIMULATOR_NAMESPACE_BEGIN
+
 class DigitalCircuit {
 
   public:
@@ -16,6 +21,14 @@ class DigitalCircuit {
       _name = name;
     }
 
+    // virtual, so that deleting a circuit through a pointer to one of its
+    // base classes runs its whole destructor
+    virtual ~DigitalCircuit() {}
+
+    const std::string &getName() const {
+      return _name;
+    }
+
     void printName() {
       fprintf(stderr, "[%s] this = %p, this->_name = %s\n", __func__, this,
         _name.c_str());
@@ -27,6 +40,15 @@ class DigitalCircuit {
     //     values
     virtual void advanceCycle() = 0;
 
+    // void DigitalCircuit::getPorts()
+    //   - appends the wires the circuit reads to 'inputs' and those it drives
+    //     to 'outputs' (e.g., for the TimingModel to connect it to the other
+    //     circuits); a circuit that does not list them has none
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      (void)inputs;
+      (void)outputs;
+    }
+
   private:
 
     std::string _name;
@@ -64,5 +86,7 @@ void printWire(const std::string &name, const Wire<N> *wire) {
   printWire(name, *wire);
 }
 
+SIMULATOR_NAMESPACE_END
+
 #endif
 
@@ -0,0 +1,309 @@
+#ifndef __FETCH_UNIT_H__
+#define __FETCH_UNIT_H__
+
+#include "DigitalCircuit.h"
+#include "Memory.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef FETCH_WIDTH
+#define FETCH_WIDTH 2 // <-- the most instructions fetched per cycle (from one line)
+#endif
+
+#ifndef FETCH_QUEUE_SIZE
+#define FETCH_QUEUE_SIZE 8 // <-- the number of instruction queue entries between fetch and decode
+#endif
+
+#ifndef FETCH_LINE_WORDS
+#define FETCH_LINE_WORDS 4 // <-- the instructions per line of the instruction memory (a power of two)
+#endif
+
+#ifndef FETCH_LINE_LATENCY
+#define FETCH_LINE_LATENCY 2 // <-- the cycles it takes to read one line from the instruction memory
+#endif
+
+#ifndef FETCH_NEXT_LINE_PREFETCH
+#define FETCH_NEXT_LINE_PREFETCH 1 // <-- 1 to read the next sequential line while the current one is fetched from
+#endif
+
+class FetchUnit : public DigitalCircuit {
+
+  public:
+
+    typedef struct {
+      std::uint32_t pc; // the address of the instruction
+      std::uint32_t instruction;
+    } Entry;
+
+    // FetchUnit::FetchUnit()
+    //   - fetches up to 'width' consecutive instructions per cycle from the
+    //     line buffers into an instruction queue, which decode takes them
+    //     from one at a time; the fetch goes on while decode is stalled, as
+    //     long as the queue has room
+    //   - the line buffers hold two lines of 'lineWords' instructions, read
+    //     from 'memory' in 'lineLatency' cycles, one read at a time; with
+    //     'prefetch', the line after the one being fetched from is read
+    //     ahead whenever the read port is free
+    //   - 'oPC' is the address of the next instruction to fetch
+    FetchUnit(const std::string &name,
+              const Memory *memory,
+              Wire<32> *oPC,
+              const std::uint32_t pc,
+              const size_t width = FETCH_WIDTH,
+              const size_t queueSize = FETCH_QUEUE_SIZE,
+              const size_t lineWords = FETCH_LINE_WORDS,
+              const size_t lineLatency = FETCH_LINE_LATENCY,
+              const bool prefetch = FETCH_NEXT_LINE_PREFETCH)
+      : DigitalCircuit(name) {
+      _memory = memory;
+      _oPC = oPC;
+
+      assert(width > 0);
+      assert(queueSize > 0);
+      assert(lineWords > 0 && (lineWords & (lineWords - 1)) == 0);
+      assert(lineLatency > 0);
+      _width = width;
+      _queueSize = queueSize;
+      _lineWords = lineWords;
+      _lineLatency = lineLatency;
+      _prefetch = prefetch;
+
+      reset(pc);
+    }
+
+    // void FetchUnit::reset()
+    //   - empties the queue and the line buffers, drops the statistics, and
+    //     restarts the fetch from 'pc'
+    void reset(const std::uint32_t pc) {
+      _fetchPC = pc;
+      *_oPC = _fetchPC;
+      _queue.clear();
+      _numDelaySlotsLeft = 0;
+      _target = 0;
+      for (size_t i = 0; i < 2; i++) {
+        _lines[i] = { 0, false, false, 0 };
+      }
+      _readValid = false;
+      _readPrefetch = false;
+      _readLine = 0;
+      _readCyclesLeft = 0;
+      _numFetchedLastCycle = 0;
+      _currCycle = 0;
+
+      _numFetched = 0;
+      _numSquashed = 0;
+      _numDemandReads = 0;
+      _numPrefetches = 0;
+      _numPrefetchHits = 0;
+      _numLineWaitCycles = 0;
+      _numQueueFullCycles = 0;
+      _numStarvedCycles = 0;
+      _maxOccupancy = 0;
+      _occupancyHistogram.assign(_queueSize + 1, 0);
+    }
+
+    // size_t FetchUnit::redirect()
+    //   - a taken branch: the fetch goes to 'target' once 'numDelaySlots'
+    //     more instructions (counted from the oldest one in the queue) have
+    //     been fetched; the younger ones in the queue are squashed, and
+    //     their number is returned
+    size_t redirect(const std::uint32_t target, const size_t numDelaySlots) {
+      const size_t numKept = std::min(numDelaySlots, _queue.size());
+      const size_t numSquashed = _queue.size() - numKept;
+      _queue.resize(numKept);
+      _numSquashed += numSquashed;
+      if (numKept < numDelaySlots) {
+        _numDelaySlotsLeft = numDelaySlots - numKept;
+        _target = target;
+      } else {
+        _numDelaySlotsLeft = 0;
+        _fetchPC = target;
+        *_oPC = _fetchPC;
+      }
+      return numSquashed;
+    }
+
+    // bool FetchUnit::dequeue()
+    //   - decode takes the oldest instruction, if there is one
+    bool dequeue(Entry &entry) {
+      if (_queue.empty()) {
+        _numStarvedCycles += 1;
+        return false;
+      }
+      entry = _queue.front();
+      _queue.pop_front();
+      return true;
+    }
+
+    const std::deque<Entry> &getQueue() const {
+      return _queue;
+    }
+
+    // size_t FetchUnit::getNumFetchedLastCycle()
+    //   - the instructions the last advanceCycle() appended to the queue
+    size_t getNumFetchedLastCycle() const {
+      return _numFetchedLastCycle;
+    }
+
+    void printStats() {
+      std::uint64_t cycles = 0, occupancySum = 0;
+      for (size_t i = 0; i <= _queueSize; i++) {
+        cycles += _occupancyHistogram[i];
+        occupancySum += _occupancyHistogram[i] * i;
+      }
+      printf("Fetch Unit Statistics (width %lu, %lu queue entries, %lu-instruction lines, line latency %lu, prefetch %s):\n",
+             (unsigned long)_width, (unsigned long)_queueSize, (unsigned long)_lineWords,
+             (unsigned long)_lineLatency, _prefetch ? "on" : "off");
+      printf("  fetched            = %lu\n", (unsigned long)_numFetched);
+      printf("  squashed           = %lu\n", (unsigned long)_numSquashed);
+      printf("  demandReads        = %lu\n", (unsigned long)_numDemandReads);
+      printf("  prefetches         = %lu\n", (unsigned long)_numPrefetches);
+      printf("  prefetchHits       = %lu\n", (unsigned long)_numPrefetchHits);
+      printf("  lineWaitCycles     = %lu\n", (unsigned long)_numLineWaitCycles);
+      printf("  queueFullCycles    = %lu\n", (unsigned long)_numQueueFullCycles);
+      printf("  starvedCycles      = %lu\n", (unsigned long)_numStarvedCycles);
+      printf("  avgOccupancy       = %.2f\n",
+             cycles == 0 ? 0.0 : (double)occupancySum / (double)cycles);
+      printf("  maxOccupancy       = %lu\n", (unsigned long)_maxOccupancy);
+      for (size_t i = 0; i <= _queueSize; i++) {
+        printf("  occupancy[%2lu]      = %lu cycles\n", (unsigned long)i,
+               (unsigned long)_occupancyHistogram[i]);
+      }
+    }
+
+    virtual void advanceCycle() {
+      _currCycle += 1;
+      _numFetchedLastCycle = 0;
+      _occupancyHistogram[_queue.size()] += 1;
+
+      // the line being read arrives in the buffer not used for the longest time
+      if (_readValid) {
+        _readCyclesLeft -= 1;
+        if (_readCyclesLeft == 0) {
+          Line &victim = (_lines[0].lastUse <= _lines[1].lastUse) ? _lines[0] : _lines[1];
+          victim = { _readLine, true, _readPrefetch, _currCycle };
+          _readValid = false;
+        }
+      }
+
+      const std::uint32_t line = _lineOf(_fetchPC);
+      Line *buffer = _findLine(line);
+      if (buffer == nullptr) {
+        // a demand read replaces a prefetch of another line
+        _numLineWaitCycles += 1;
+        if (!_readValid || _readLine != line) {
+          _read(line, false);
+        }
+        return;
+      }
+      if (buffer->prefetched) {
+        buffer->prefetched = false;
+        _numPrefetchHits += 1;
+      }
+      buffer->lastUse = _currCycle;
+
+      while (_numFetchedLastCycle < _width && _queue.size() < _queueSize && _lineOf(_fetchPC) == line) {
+        Entry entry = { _fetchPC, _memory->readWord(_fetchPC) };
+        _queue.push_back(entry);
+        _numFetchedLastCycle += 1;
+        _numFetched += 1;
+        _fetchPC += 4;
+        if (_numDelaySlotsLeft > 0) {
+          _numDelaySlotsLeft -= 1;
+          if (_numDelaySlotsLeft == 0) {
+            _fetchPC = _target;
+            break;
+          }
+        }
+      }
+      if (_numFetchedLastCycle < _width && _queue.size() == _queueSize) {
+        _numQueueFullCycles += 1; // the fetch was cut short by the queue
+      }
+      _maxOccupancy = std::max(_maxOccupancy, _queue.size());
+      *_oPC = _fetchPC;
+
+      if (_prefetch && !_readValid && _findLine(line + 1) == nullptr) {
+        _read(line + 1, true);
+      }
+    }
+
+  private:
+
+    typedef struct {
+      std::uint32_t line; // the line number, i.e., the address divided by the line size
+      bool valid;
+      bool prefetched; // true until a prefetched line is first fetched from
+      std::uint64_t lastUse; // the cycle the line was last fetched from
+    } Line;
+
+    std::uint32_t _lineOf(const std::uint32_t address) const {
+      return address / (4 * _lineWords);
+    }
+
+    Line *_findLine(const std::uint32_t line) {
+      for (size_t i = 0; i < 2; i++) {
+        if (_lines[i].valid && _lines[i].line == line) {
+          return &_lines[i];
+        }
+      }
+      return nullptr;
+    }
+
+    void _read(const std::uint32_t line, const bool prefetch) {
+      _readValid = true;
+      _readPrefetch = prefetch;
+      _readLine = line;
+      _readCyclesLeft = _lineLatency;
+      if (prefetch) {
+        _numPrefetches += 1;
+      } else {
+        _numDemandReads += 1;
+      }
+    }
+
+    const Memory *_memory;
+    Wire<32> *_oPC;
+
+    size_t _width;
+    size_t _queueSize;
+    size_t _lineWords;
+    size_t _lineLatency;
+    bool _prefetch;
+
+    std::uint32_t _fetchPC; // the address of the next instruction to fetch
+    std::deque<Entry> _queue; // the instruction queue, oldest instruction first
+    size_t _numDelaySlotsLeft; // the instructions still fetched before the jump to '_target'
+    std::uint32_t _target;
+    Line _lines[2]; // the line buffers
+    bool _readValid; // true while a line is being read
+    bool _readPrefetch;
+    std::uint32_t _readLine;
+    size_t _readCyclesLeft;
+    size_t _numFetchedLastCycle;
+    std::uint64_t _currCycle;
+
+    // Statistics
+    std::uint64_t _numFetched;
+    std::uint64_t _numSquashed;
+    std::uint64_t _numDemandReads;
+    std::uint64_t _numPrefetches;
+    std::uint64_t _numPrefetchHits;
+    std::uint64_t _numLineWaitCycles;
+    std::uint64_t _numQueueFullCycles;
+    std::uint64_t _numStarvedCycles;
+    size_t _maxOccupancy;
+    std::vector<std::uint64_t> _occupancyHistogram;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
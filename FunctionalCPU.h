@@ -0,0 +1,327 @@
+#ifndef __FUNCTIONAL_CPU_H__
+#define __FUNCTIONAL_CPU_H__
+
+#include "DigitalCircuit.h"
+#include "Memory.h"
+#include "SimulatorNamespace.h"
+#ifdef ENABLE_MULT_DIV
+#include "MulDivUnit.h"
+#endif
+#ifdef ENABLE_JUMPS
+#include "JumpPredictor.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#define FUNCTIONAL_BRANCH_DELAY_SLOTS 2 // <-- the instructions after a taken beq that PipelinedCPU still executes
+
+// FunctionalCPU
+//   - executes one instruction per advanceCycle() with the same semantics as
+//     the datapath of PipelinedCPU (the ALU, ALUControl, and Control units),
+//     including the two branch delay slots, but without modeling any timing
+//   - the memories are sparse, so a FunctionalCPU is cheap to create and can
+//     run far more instructions per second than the detailed model
+class FunctionalCPU : public DigitalCircuit {
+
+  public:
+
+    FunctionalCPU(const std::string &name,
+                  const std::uint32_t initialPC,
+                  const Memory::Endianness memoryEndianness,
+                  const char *regFileName,
+                  const char *instMemFileName,
+                  const char *dataMemFileName) : DigitalCircuit(name) {
+      _endianness = memoryEndianness;
+      // PipelinedCPU fetches its first instruction from initialPC + 4
+      _pc = initialPC + 4;
+
+      for (size_t i = 0; i < 32; i++) {
+        _registers[i] = 0;
+      }
+      if (regFileName != nullptr) {
+        FILE *initFile = fopen(regFileName, "r");
+        if (initFile == NULL) {
+          fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, regFileName);
+          assert(false);
+        }
+        std::uint32_t reg, val;
+        while (fscanf(initFile, " %u %x", &reg, &val) == 2) {
+          if (reg != 0 && reg < 32) {
+            _registers[reg] = val;
+          }
+        }
+        fclose(initFile);
+      }
+      _loadMemory(_instMemory, instMemFileName);
+      _loadMemory(_dataMemory, dataMemFileName);
+    }
+
+    // void FunctionalCPU::advanceCycle()
+    //   - executes the instruction at the PC
+    virtual void advanceCycle() {
+      const std::uint32_t pc = _pc;
+      const std::uint32_t instruction = _readWord(_instMemory, pc);
+      const unsigned opcode = instruction >> 26;
+      const unsigned rs = (instruction >> 21) & 0x1F;
+      const unsigned rt = (instruction >> 16) & 0x1F;
+      const unsigned rd = (instruction >> 11) & 0x1F;
+      const std::uint32_t immediate = (std::uint32_t)(std::int32_t)(std::int16_t)(instruction & 0xFFFF);
+
+#ifdef ENABLE_JUMPS
+      const JumpPredictor::Op jumpOp = JumpPredictor::decode(instruction);
+#endif
+#ifdef ENABLE_MULT_DIV
+      const MulDivUnit::Op mulDivOp = MulDivUnit::decode(instruction);
+#endif
+#ifdef ENABLE_JUMPS
+      // a jump goes after the same delay slots as a taken beq, and a jal
+      // links to the instruction after them
+      if (jumpOp != JumpPredictor::None) {
+        if (jumpOp == JumpPredictor::Jal) {
+          _writeRegister(31, JumpPredictor::returnAddress(pc, FUNCTIONAL_BRANCH_DELAY_SLOTS));
+        }
+        _redirects.push_back(std::make_pair(_numRetired + 1 + FUNCTIONAL_BRANCH_DELAY_SLOTS,
+                                            JumpPredictor::isIndirect(jumpOp) ? _registers[rs]
+                                                                              : JumpPredictor::directTarget(pc, instruction)));
+      } else
+#endif
+#ifdef ENABLE_MULT_DIV
+      if (MulDivUnit::isMulDiv(mulDivOp)) {
+        MulDivUnit::compute(mulDivOp, _registers[rs], _registers[rt], _hi, _lo);
+      } else if (mulDivOp == MulDivUnit::Mfhi || mulDivOp == MulDivUnit::Mflo) {
+        _writeRegister(rd, mulDivOp == MulDivUnit::Mfhi ? _hi : _lo);
+      } else
+#endif
+      if (opcode == 0b000000) { // R-format
+        std::uint32_t result;
+        switch (instruction & 0xF) {
+          case 0x0: result = _registers[rs] + _registers[rt]; break;
+          case 0x2: result = _registers[rs] - _registers[rt]; break;
+          case 0x5: result = _registers[rs] | _registers[rt]; break;
+          case 0xa: result = (_registers[rs] < _registers[rt]) ? 1 : 0; break;
+          default: result = _registers[rs] & _registers[rt]; break; // ALUControl defaults to AND
+        }
+        _writeRegister(rd, result);
+      } else if (opcode == 0b001000) { // addi
+        _writeRegister(rt, _registers[rs] + immediate);
+      } else if (opcode == 0b100011) { // lw
+        _writeRegister(rt, _readWord(_dataMemory, _registers[rs] + immediate));
+      } else if (opcode == 0b101011) { // sw
+        _writeWord(_dataMemory, _registers[rs] + immediate, _registers[rt]);
+      } else if (opcode == 0b000100) { // beq
+        if (_registers[rs] == _registers[rt]) {
+          _redirects.push_back(std::make_pair(_numRetired + 1 + FUNCTIONAL_BRANCH_DELAY_SLOTS,
+                                              pc + 4 + (immediate << 2)));
+        }
+      }
+      // any other opcode does nothing, as the Control unit turns it into a bubble
+
+      _numRetired += 1;
+      _pc = pc + 4;
+      if (!_redirects.empty() && _redirects.front().first == _numRetired) {
+        _pc = _redirects.front().second;
+        _redirects.pop_front();
+      }
+    }
+
+    // std::uint32_t FunctionalCPU::getPC()
+    //   - the address of the next instruction to execute
+    std::uint32_t getPC() const {
+      return _pc;
+    }
+
+    std::uint64_t getNumRetired() const {
+      return _numRetired;
+    }
+
+    // bool FunctionalCPU::isBranchPending()
+    //   - true while a taken branch still has delay slots to execute; a
+    //     checkpoint taken then would lose the redirection
+    bool isBranchPending() const {
+      return !_redirects.empty();
+    }
+
+    // FunctionalCPU::Checkpoint_t
+    //   - the architectural state between two instructions, kept in memory:
+    //     the PC of the next instruction, the registers, and the nonzero
+    //     words of the data memory, in the order of their addresses
+    typedef struct {
+      std::uint32_t pc;
+      std::uint32_t registers[32];
+      std::vector<std::pair<std::uint32_t, std::uint32_t>> dataWords; // (address, word)
+    } Checkpoint_t;
+
+    // void FunctionalCPU::takeCheckpoint()
+    //   - the same state as writeCheckpoint(), without the files; the words
+    //     are as the initialization files hold them, so they can be written
+    //     into a reset PipelinedCPU with writeDataMemory()
+    void takeCheckpoint(Checkpoint_t &checkpoint) const {
+      assert(!isBranchPending());
+      checkpoint.pc = _pc;
+      for (size_t i = 0; i < 32; i++) {
+        checkpoint.registers[i] = _registers[i];
+      }
+      checkpoint.dataWords = _wordsOf(_dataMemory);
+    }
+
+    // std::vector<...> FunctionalCPU::getInstructionWords()
+    //   - the words of the instruction memory, which no checkpoint holds
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> getInstructionWords() const {
+      return _wordsOf(_instMemory);
+    }
+
+    // void FunctionalCPU::restoreCheckpoint()
+    //   - resets 'cpu' (a PipelinedCPU) to start from 'checkpoint', with
+    //     the instruction memory 'instructionWords' (see
+    //     getInstructionWords())
+    template<typename CPU>
+    static void restoreCheckpoint(CPU *cpu, const Checkpoint_t &checkpoint,
+                                  const std::vector<std::pair<std::uint32_t, std::uint32_t>> &instructionWords) {
+      cpu->reset(checkpoint.pc - 4);
+      for (const std::pair<std::uint32_t, std::uint32_t> &word : instructionWords) {
+        cpu->writeInstMemory(word.first, word.second);
+      }
+      for (const std::pair<std::uint32_t, std::uint32_t> &word : checkpoint.dataWords) {
+        cpu->writeDataMemory(word.first, word.second);
+      }
+      for (size_t i = 1; i < 32; i++) {
+        cpu->setRegister(i, checkpoint.registers[i]);
+      }
+    }
+
+    // void FunctionalCPU::writeCheckpoint()
+    //   - writes the registers and the data memory into '<prefix>_regFile'
+    //     and '<prefix>_dataMemFile', in the formats the constructors of
+    //     PipelinedCPU and FunctionalCPU read; the instruction memory never
+    //     changes, so the original file can be used with the checkpoint
+    //   - HI and LO (ENABLE_MULT_DIV) have no place in those files, so a
+    //     checkpoint is only exact where the program does not read them back
+    void writeCheckpoint(const std::string &prefix) const {
+      assert(!isBranchPending());
+
+      std::string fileName = prefix + "_regFile";
+      FILE *file = fopen(fileName.c_str(), "w");
+      if (file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName.c_str());
+        assert(false);
+      }
+      for (size_t i = 1; i < 32; i++) {
+        if (_registers[i] != 0) {
+          fprintf(file, "%lu %08lx\n", (unsigned long)i, (unsigned long)_registers[i]);
+        }
+      }
+      fclose(file);
+
+      fileName = prefix + "_dataMemFile";
+      file = fopen(fileName.c_str(), "w");
+      if (file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName.c_str());
+        assert(false);
+      }
+      for (const std::pair<std::uint32_t, std::uint32_t> &word : _wordsOf(_dataMemory)) {
+        fprintf(file, "%lx %08lx\n", (unsigned long)word.first, (unsigned long)word.second);
+      }
+      fclose(file);
+    }
+
+    void printRegisters() const {
+      for (size_t i = 0; i < 32; i++) {
+        if (_registers[i] != 0) {
+          printf("  $%02lu = 0x%08lx\n", i, (unsigned long)_registers[i]);
+        }
+      }
+#ifdef ENABLE_MULT_DIV
+      printf("  HI = 0x%08lx\n", (unsigned long)_hi);
+      printf("  LO = 0x%08lx\n", (unsigned long)_lo);
+#endif
+    }
+
+  private:
+
+    typedef std::unordered_map<std::uint32_t, std::uint8_t> SparseMemory;
+
+    // the same format as the initialization files of Memory
+    void _loadMemory(SparseMemory &memory, const char *fileName) {
+      if (fileName == nullptr) {
+        return;
+      }
+      FILE *initFile = fopen(fileName, "r");
+      if (initFile == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName);
+        assert(false);
+      }
+      std::uint32_t addr, value;
+      while (fscanf(initFile, " %x %x", &addr, &value) == 2) {
+        _writeWord(memory, addr, value);
+      }
+      fclose(initFile);
+    }
+
+    std::uint32_t _readWord(const SparseMemory &memory, std::uint32_t address) const {
+      std::uint32_t data = 0;
+      for (int i = 0; i < 4; ++i) {
+        auto byte = memory.find(address + i);
+        std::uint32_t value = (byte == memory.end()) ? 0 : byte->second;
+        data |= value << ((_endianness == Memory::LittleEndian ? i : 3 - i) * 8);
+      }
+      return data;
+    }
+
+    void _writeWord(SparseMemory &memory, std::uint32_t address, std::uint32_t data) {
+      for (int i = 0; i < 4; ++i) {
+        memory[address + i] = (data >> ((_endianness == Memory::LittleEndian ? i : 3 - i) * 8)) & 0xFF;
+      }
+    }
+
+    // the words of 'memory' with a nonzero byte, by address
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _wordsOf(const SparseMemory &memory) const {
+      std::vector<std::uint32_t> addresses;
+      for (auto &byte : memory) {
+        if (byte.second != 0) {
+          addresses.push_back(byte.first & ~3u);
+        }
+      }
+      std::sort(addresses.begin(), addresses.end());
+      addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+      std::vector<std::pair<std::uint32_t, std::uint32_t>> words;
+      for (std::uint32_t address : addresses) {
+        words.push_back(std::make_pair(address, _readWord(memory, address)));
+      }
+      return words;
+    }
+
+    void _writeRegister(unsigned reg, std::uint32_t value) {
+      if (reg != 0) {
+        _registers[reg] = value;
+      }
+    }
+
+    Memory::Endianness _endianness;
+    std::uint32_t _pc; // the address of the next instruction
+    std::uint32_t _registers[32];
+#ifdef ENABLE_MULT_DIV
+    std::uint32_t _hi = 0;
+    std::uint32_t _lo = 0;
+#endif
+    SparseMemory _instMemory;
+    SparseMemory _dataMemory;
+    std::uint64_t _numRetired = 0;
+    // the taken branches in their delay slots: the number of retired
+    // instructions after which the PC is redirected, and the target
+    std::deque<std::pair<std::uint64_t, std::uint32_t>> _redirects;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
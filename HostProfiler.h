@@ -0,0 +1,209 @@
+#ifndef __HOST_PROFILER_H__
+#define __HOST_PROFILER_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef HOST_PROFILE_PERIOD
+#define HOST_PROFILE_PERIOD 16 // <-- the host profiler times one simulated cycle in this many
+#endif
+
+// HostProfiler
+//   - where the simulator itself spends host time: the stages and the
+//     components are timed with the time stamp counter (or steady_clock on
+//     hosts without one) in one simulated cycle out of 'period', and the
+//     times are reported per cycle
+//   - the stages and the components are told apart by their names, so the
+//     instances of a component (e.g., the memories of several threads) are
+//     added up
+class HostProfiler {
+
+  private:
+
+    struct Entry {
+      std::string name;
+      bool component; // true for a component, false for a stage
+      bool inCycle; // true if the stage is part of advanceCycle()
+      std::uint64_t ticks;
+      std::uint64_t calls;
+    };
+
+  public:
+
+    // HostProfiler::Scope
+    //   - times its own lifetime, if the current cycle is sampled, as the
+    //     stage 'name' or as the advanceCycle() of 'component'
+    class Scope {
+      public:
+        Scope(HostProfiler &profiler, const char *name) {
+          _entry = profiler._sampling ? profiler._entryOf(name, name, false) : nullptr;
+          _start = _entry != nullptr ? now() : 0;
+        }
+        Scope(HostProfiler &profiler, const DigitalCircuit *component) {
+          _entry = profiler._sampling ? profiler._entryOf(component, component->getName(), true) : nullptr;
+          _start = _entry != nullptr ? now() : 0;
+        }
+        ~Scope() {
+          if (_entry != nullptr) {
+            _entry->ticks += now() - _start;
+            _entry->calls += 1;
+          }
+        }
+      private:
+        Entry *_entry;
+        std::uint64_t _start;
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    HostProfiler(const std::uint64_t period = HOST_PROFILE_PERIOD) {
+      _period = period > 0 ? period : 1;
+      _startTicks = now();
+      _startTime = std::chrono::steady_clock::now();
+    }
+
+    static std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // void HostProfiler::beginCycle(), endCycle()
+    //   - bracket a simulated cycle, and decide whether it is sampled
+    void beginCycle() {
+      _sampling = (_numCycles % _period == 0);
+      _numCycles += 1;
+      if (_sampling) {
+        _numSampledCycles += 1;
+        _inCycle = true;
+        _cycleStart = now();
+      }
+    }
+
+    void endCycle() {
+      if (_sampling) {
+        _cycleTicks += now() - _cycleStart;
+        _inCycle = false;
+      }
+    }
+
+    void printReport() const {
+      const double nsPerTick = _nsPerTick();
+      const double sampled = _numSampledCycles == 0 ? 1.0 : (double)_numSampledCycles;
+      const double cycleNs = _cycleTicks * nsPerTick / sampled;
+      printf("Host Profile (1 in %lu cycles sampled, %lu of %lu cycles):\n",
+             (unsigned long)_period, (unsigned long)_numSampledCycles, (unsigned long)_numCycles);
+      printf("  %-23s = %10.1f ns/cycle\n", "advanceCycle", cycleNs);
+      std::uint64_t stageTicks = 0;
+      for (const Entry &entry : _entries) {
+        if (!entry.component && entry.inCycle) {
+          _printEntry(entry, nsPerTick, sampled, cycleNs);
+          stageTicks += entry.ticks;
+        }
+      }
+      if (stageTicks > 0) {
+        const Entry rest = { "(rest)", false, true, _cycleTicks - std::min(stageTicks, _cycleTicks), 0 };
+        _printEntry(rest, nsPerTick, sampled, cycleNs);
+      }
+      for (const Entry &entry : _entries) {
+        if (!entry.component && !entry.inCycle) {
+          printf("  %-23s = %10.1f ns/cycle\n", entry.name.c_str(), entry.ticks * nsPerTick / sampled);
+        }
+      }
+      std::vector<const Entry *> components;
+      for (const Entry &entry : _entries) {
+        if (entry.component) {
+          components.push_back(&entry);
+        }
+      }
+      std::sort(components.begin(), components.end(), [](const Entry *a, const Entry *b) {
+        return a->ticks > b->ticks;
+      });
+      if (!components.empty()) {
+        printf("  Components (included in the stages above):\n");
+      }
+      for (const Entry *entry : components) {
+        _printEntry(*entry, nsPerTick, sampled, cycleNs);
+      }
+      printf("  %-23s = %10.3f ms for %lu cycles\n", "estimated time",
+             cycleNs * _numCycles / 1e6, (unsigned long)_numCycles);
+    }
+
+  private:
+
+    // the entry of a stage or a component, created when it is first timed;
+    // only sampled cycles look it up, so the other ones stay cheap
+    Entry *_entryOf(const void *key, const std::string &name, bool component) {
+      auto it = _index.find(key);
+      if (it != _index.end()) {
+        return &_entries[it->second];
+      }
+      size_t i = 0;
+      while (i < _entries.size() && !(_entries[i].name == name && _entries[i].component == component)) {
+        i++;
+      }
+      if (i == _entries.size()) {
+        const Entry entry = { name, component, _inCycle, 0, 0 };
+        _entries.push_back(entry);
+      }
+      _index[key] = i;
+      return &_entries[i];
+    }
+
+    double _nsPerTick() const {
+#if defined(__x86_64__) || defined(__i386__)
+      const std::uint64_t ticks = now() - _startTicks;
+      const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _startTime).count();
+      return ticks == 0 ? 0.0 : ns / (double)ticks;
+#else
+      return 1.0;
+#endif
+    }
+
+    static void _printEntry(const Entry &entry, double nsPerTick, double sampled, double cycleNs) {
+      const double ns = entry.ticks * nsPerTick / sampled;
+      printf("    %-21s = %10.1f ns/cycle (%5.1f%%)", entry.name.c_str(), ns,
+             cycleNs == 0.0 ? 0.0 : 100.0 * ns / cycleNs);
+      if (entry.component) {
+        printf(", %.2f calls/cycle", entry.calls / sampled);
+      }
+      printf("\n");
+    }
+
+    std::uint64_t _period;
+    bool _sampling = false; // true while a sampled cycle (or what follows it) runs
+    bool _inCycle = false; // true between beginCycle() and endCycle() of a sampled cycle
+    std::uint64_t _numCycles = 0;
+    std::uint64_t _numSampledCycles = 0;
+    std::uint64_t _cycleStart = 0;
+    std::uint64_t _cycleTicks = 0; // the time of the sampled cycles
+    std::deque<Entry> _entries; // the stages and the components, in the order they were first timed
+    std::unordered_map<const void *, size_t> _index; // the entry of each stage name and component
+    std::uint64_t _startTicks;
+    std::chrono::steady_clock::time_point _startTime;
+
+    HostProfiler(const HostProfiler &) = delete;
+    HostProfiler &operator=(const HostProfiler &) = delete;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef __JUMP_PREDICTOR_H__
+#define __JUMP_PREDICTOR_H__
+
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef JUMP_RAS_DEPTH
+#define JUMP_RAS_DEPTH 8 // <-- the entries of the return-address stack (a push onto a full stack overwrites the oldest)
+#endif
+
+#ifndef JUMP_ITC_ENTRIES
+#define JUMP_ITC_ENTRIES 16 // <-- the entries of the direct-mapped indirect target cache
+#endif
+
+// JumpPredictor
+//   - the jumps (j, jal, jr) and, with ENABLE_JUMP_PREDICTION, the
+//     prediction of their targets at fetch: j and jal have theirs in the
+//     instruction itself, a jr $ra takes the top of a return-address stack
+//     that every jal pushes (none if the stack is empty), and any other jr
+//     takes the target it had the last time, from a small indirect target
+//     cache
+//   - a jump jumps after the same delay slots as a taken beq, so a jal
+//     links to the first instruction after its delay slots
+//   - the stack is kept twice: the speculative one, which the fetch updates,
+//     and the committed one, which the jumps update in order when they
+//     resolve in MEM; a wrong prediction (or any other redirect) squashes
+//     the instructions fetched after the delay slots, so recover() copies
+//     the committed stack over the speculative one, and replay() puts back
+//     the instructions still in flight
+class JumpPredictor {
+
+  public:
+
+    enum Op { None, J, Jal, Jr, JrRa };
+
+    // JumpPredictor::Op JumpPredictor::decode()
+    //   - the jump an instruction is, if any (JrRa is a jr $31, a return)
+    static Op decode(const std::uint32_t instruction) {
+      const unsigned opcode = instruction >> 26;
+      if (opcode == 0b000010) {
+        return J;
+      }
+      if (opcode == 0b000011) {
+        return Jal;
+      }
+      if (opcode == 0b000000 && (instruction & 0x3F) == 0x08) {
+        return ((instruction >> 21) & 0x1F) == 31 ? JrRa : Jr;
+      }
+      return None;
+    }
+
+    static bool isIndirect(const Op op) {
+      return op == Jr || op == JrRa;
+    }
+
+    // std::uint32_t JumpPredictor::directTarget()
+    //   - the target of a j/jal at 'pc': its 26-bit field in the 256MB region of PC+4
+    static std::uint32_t directTarget(const std::uint32_t pc, const std::uint32_t instruction) {
+      return ((pc + 4) & 0xF0000000) | ((instruction & 0x03FFFFFF) << 2);
+    }
+
+    // std::uint32_t JumpPredictor::returnAddress()
+    //   - the address a jal at 'pc' links to, after its delay slots
+    static std::uint32_t returnAddress(const std::uint32_t pc, const size_t numDelaySlots) {
+      return pc + 4 * (1 + numDelaySlots);
+    }
+
+    JumpPredictor(const size_t numDelaySlots,
+                  const size_t rasDepth = JUMP_RAS_DEPTH,
+                  const size_t itcEntries = JUMP_ITC_ENTRIES) {
+      assert(rasDepth > 0);
+      assert(itcEntries > 0);
+      _numDelaySlots = numDelaySlots;
+      _committed.entries.resize(rasDepth);
+      _itc.resize(itcEntries);
+      reset();
+    }
+
+    // void JumpPredictor::resize()
+    //   - gives the stacks 'rasDepth' entries and the cache 'itcEntries',
+    //     and resets the predictor
+    void resize(const size_t rasDepth, const size_t itcEntries) {
+      assert(rasDepth > 0);
+      assert(itcEntries > 0);
+      _committed.entries.resize(rasDepth);
+      _itc.resize(itcEntries);
+      reset();
+    }
+
+    // void JumpPredictor::reset()
+    //   - empties the stacks and the cache, and drops the statistics
+    void reset() {
+      _committed.top = 0;
+      _committed.count = 0;
+      for (std::uint32_t &entry : _committed.entries) {
+        entry = 0;
+      }
+      _speculative = _committed;
+      for (ITCEntry &entry : _itc) {
+        entry = ITCEntry();
+      }
+      _numDirectJumps = 0;
+      _numReturns = 0;
+      _numRASPredictions = 0;
+      _numRASHits = 0;
+      _numRASOverflows = 0;
+      _numIndirectJumps = 0;
+      _numITCPredictions = 0;
+      _numITCHits = 0;
+      _numMispredictions = 0;
+      _numRecoveries = 0;
+    }
+
+    // bool JumpPredictor::predict()
+    //   - at the fetch of 'instruction' from 'pc': true with its 'target' if
+    //     it is a jump that can be predicted, and the speculative stack is
+    //     pushed (jal) or popped (jr $ra)
+    bool predict(const std::uint32_t pc, const std::uint32_t instruction, std::uint32_t &target) {
+      const Op op = decode(instruction);
+      switch (op) {
+        case J:
+        case Jal:
+          target = directTarget(pc, instruction);
+          _speculate(op, pc);
+          return true;
+        case JrRa:
+          return _speculative.pop(target);
+        case Jr:
+          return _lookUp(pc, target);
+        default:
+          return false;
+      }
+    }
+
+    // bool JumpPredictor::resolve()
+    //   - the jump 'op' at 'pc' goes to 'target' in MEM; updates the committed
+    //     stack and the cache, and returns true if it was predicted right
+    bool resolve(const Op op, const std::uint32_t pc, const std::uint32_t target,
+                 const bool predicted, const std::uint32_t predictedTarget) {
+      const bool hit = predicted && predictedTarget == target;
+      std::uint32_t unused;
+      switch (op) {
+        case J:
+          _numDirectJumps += 1;
+          break;
+        case Jal:
+          _numDirectJumps += 1;
+          if (_committed.count == _committed.entries.size()) {
+            _numRASOverflows += 1;
+          }
+          _committed.push(returnAddress(pc, _numDelaySlots));
+          break;
+        case JrRa:
+          _numReturns += 1;
+          _numRASPredictions += predicted ? 1 : 0;
+          _numRASHits += hit ? 1 : 0;
+          _committed.pop(unused);
+          break;
+        case Jr: {
+          _numIndirectJumps += 1;
+          _numITCPredictions += predicted ? 1 : 0;
+          _numITCHits += hit ? 1 : 0;
+          ITCEntry &entry = _itc[(pc >> 2) % _itc.size()];
+          entry.valid = true;
+          entry.pc = pc;
+          entry.target = target;
+          break;
+        }
+        default:
+          break;
+      }
+      if (predicted && !hit) {
+        _numMispredictions += 1;
+      }
+      return hit;
+    }
+
+    // void JumpPredictor::recover()
+    //   - the instructions after the oldest one in flight are squashed or
+    //     replayed: the speculative stack starts over from the committed one
+    void recover() {
+      _speculative = _committed;
+      _numRecoveries += 1;
+    }
+
+    // void JumpPredictor::replay()
+    //   - the instruction 'op' at 'pc' is still in flight after a recover()
+    void replay(const Op op, const std::uint32_t pc) {
+      _speculate(op, pc);
+    }
+
+    void printStats() {
+      printf("Jump Prediction Statistics (RAS depth %lu, ITC %lu entries):\n",
+             (unsigned long)_committed.entries.size(), (unsigned long)_itc.size());
+      printf("  directJumps        = %lu\n", (unsigned long)_numDirectJumps);
+      printf("  returns            = %lu\n", (unsigned long)_numReturns);
+      printf("  rasPredictions     = %lu\n", (unsigned long)_numRASPredictions);
+      printf("  rasHits            = %lu\n", (unsigned long)_numRASHits);
+      printf("  rasHitRate         = %.2f%%\n",
+             _numReturns == 0 ? 0.0 : 100.0 * (double)_numRASHits / (double)_numReturns);
+      printf("  rasOverflows       = %lu\n", (unsigned long)_numRASOverflows);
+      printf("  indirectJumps      = %lu\n", (unsigned long)_numIndirectJumps);
+      printf("  itcPredictions     = %lu\n", (unsigned long)_numITCPredictions);
+      printf("  itcHits            = %lu\n", (unsigned long)_numITCHits);
+      printf("  mispredictions     = %lu\n", (unsigned long)_numMispredictions);
+      printf("  recoveries         = %lu\n", (unsigned long)_numRecoveries);
+    }
+
+  private:
+
+    typedef struct ReturnStack {
+      std::vector<std::uint32_t> entries;
+      size_t top; // the entry the next push writes
+      size_t count; // the valid entries below 'top'
+
+      void push(const std::uint32_t address) {
+        entries[top] = address;
+        top = (top + 1) % entries.size();
+        if (count < entries.size()) {
+          count += 1;
+        }
+      }
+
+      bool pop(std::uint32_t &address) {
+        if (count == 0) {
+          return false;
+        }
+        top = (top + entries.size() - 1) % entries.size();
+        count -= 1;
+        address = entries[top];
+        return true;
+      }
+    } ReturnStack;
+
+    typedef struct {
+      bool valid = false;
+      std::uint32_t pc = 0;
+      std::uint32_t target = 0;
+    } ITCEntry;
+
+    // the effect of the jump 'op' at 'pc' on the speculative stack
+    void _speculate(const Op op, const std::uint32_t pc) {
+      std::uint32_t unused;
+      if (op == Jal) {
+        _speculative.push(returnAddress(pc, _numDelaySlots));
+      } else if (op == JrRa) {
+        _speculative.pop(unused);
+      }
+    }
+
+    bool _lookUp(const std::uint32_t pc, std::uint32_t &target) const {
+      const ITCEntry &entry = _itc[(pc >> 2) % _itc.size()];
+      if (!entry.valid || entry.pc != pc) {
+        return false;
+      }
+      target = entry.target;
+      return true;
+    }
+
+    size_t _numDelaySlots;
+    ReturnStack _committed; // as the jumps resolved so far left it
+    ReturnStack _speculative; // as the jumps fetched so far left it
+    std::vector<ITCEntry> _itc; // the last target of the jr at each PC (by PC modulo the entries)
+
+    // Statistics
+    std::uint64_t _numDirectJumps;
+    std::uint64_t _numReturns;
+    std::uint64_t _numRASPredictions; // the returns fetched with a nonempty stack
+    std::uint64_t _numRASHits;
+    std::uint64_t _numRASOverflows; // the jals that overwrote the oldest entry
+    std::uint64_t _numIndirectJumps;
+    std::uint64_t _numITCPredictions;
+    std::uint64_t _numITCHits;
+    std::uint64_t _numMispredictions;
+    std::uint64_t _numRecoveries;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
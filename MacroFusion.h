@@ -0,0 +1,98 @@
+#ifndef __MACRO_FUSION_H__
+#define __MACRO_FUSION_H__
+
+#include "SimulatorNamespace.h"
+
+#include <cstdint>
+#include <cstdio>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#define FUSION_PAIR_ADD_LW 0x1 // add rd, rs, rt + lw rd, imm(rd): a load from a computed address
+#define FUSION_PAIR_SLT_BEQ 0x2 // slt rd, rs, rt + beq rd, $0 (or beq $0, rd): a branch on a comparison
+
+#ifndef FUSION_PAIRS
+#define FUSION_PAIRS (FUSION_PAIR_ADD_LW | FUSION_PAIR_SLT_BEQ) // <-- the pairs ID fuses (a mask of FUSION_PAIR_*)
+#endif
+
+// MacroFusion
+//   - the pairs of instructions that ID issues as a single operation, and
+//     the statistics of how many it did
+//   - a pair is fused only if it writes one register at most: the result
+//     of the first instruction must be dead once the second one has run
+//     (lw overwrites it) or be the only result (beq writes none), so the
+//     fused operation goes through EX, MEM, and WB as one instruction does
+//   - add+lw adds the immediate to the sum of the registers in EX, and
+//     slt+beq branches if the comparison is 0, which is the 'Zero' of the
+//     ALU; both take the PC+4 of their second instruction
+class MacroFusion {
+
+  public:
+
+    enum Op { None, AddLw, SltBeq };
+
+    // MacroFusion::Op MacroFusion::match()
+    //   - the fused operation 'first' and the instruction after it make, if
+    //     'pairs' (a mask of FUSION_PAIR_*) allows one
+    static Op match(const std::uint32_t first, const std::uint32_t second, const unsigned pairs) {
+      const unsigned opcode1 = first >> 26, funct1 = first & 0x3F, rd1 = (first >> 11) & 0x1F;
+      const unsigned opcode2 = second >> 26, rs2 = (second >> 21) & 0x1F, rt2 = (second >> 16) & 0x1F;
+      if (opcode1 != 0b000000 || rd1 == 0) {
+        return None;
+      }
+      if ((pairs & FUSION_PAIR_ADD_LW) && funct1 == 0x20 && opcode2 == 0b100011 && rs2 == rd1 && rt2 == rd1) {
+        return AddLw;
+      }
+      if ((pairs & FUSION_PAIR_SLT_BEQ) && funct1 == 0x2A && opcode2 == 0b000100
+          && ((rs2 == rd1 && rt2 == 0) || (rs2 == 0 && rt2 == rd1))) {
+        return SltBeq;
+      }
+      return None;
+    }
+
+    MacroFusion() {
+      reset();
+    }
+
+    // void MacroFusion::reset()
+    //   - drops the statistics
+    void reset() {
+      _numFused[AddLw] = _numFused[SltBeq] = 0;
+      _numBlocked = 0;
+    }
+
+    // bool MacroFusion::issue()
+    //   - ID issues the first instruction of the pair 'op'; true if the
+    //     pair is fused, which it is if the fetch goes on 'sequential'ly
+    //     to its second instruction
+    bool issue(const Op op, const bool sequential) {
+      if (!sequential) {
+        _numBlocked += 1;
+        return false;
+      }
+      _numFused[op] += 1;
+      return true;
+    }
+
+    void printStats(const std::uint64_t numRetired) {
+      const std::uint64_t numFused = _numFused[AddLw] + _numFused[SltBeq];
+      printf("Macro-op Fusion Statistics (pairs 0x%x):\n", FUSION_PAIRS);
+      printf("  fusedAddLw         = %lu\n", (unsigned long)_numFused[AddLw]);
+      printf("  fusedSltBeq        = %lu\n", (unsigned long)_numFused[SltBeq]);
+      printf("  blockedPairs       = %lu\n", (unsigned long)_numBlocked);
+      printf("  fusionRate         = %.2f%%\n",
+             numRetired == 0 ? 0.0 : 100.0 * (double)(2 * numFused) / (double)numRetired);
+      printf("  cyclesSaved        = %lu\n", (unsigned long)numFused);
+    }
+
+  private:
+
+    // Statistics
+    std::uint64_t _numFused[3]; // by Op; each one saves the fetch (and the slot through the pipeline) of an instruction
+    std::uint64_t _numBlocked; // the pairs issued apart, as a branch could take the fetch away from the second instruction
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -2,9 +2,17 @@
 #define __MEMORY_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
 
 #define MEMORY_SIZE (32 * 1024 * 1024) // <-- 32-MB memory
 
@@ -14,6 +22,8 @@ class Memory : public DigitalCircuit {
 
     enum Endianness { LittleEndian, BigEndian };
 
+    typedef std::function<void(std::uint32_t, std::uint32_t, std::uint32_t)> WriteHook;
+
     Memory(const std::string &name,
            const Wire<32> *iAddress,
            const Wire<32> *iWriteData,
@@ -29,7 +39,11 @@ class Memory : public DigitalCircuit {
       _iMemRead = iMemRead;
       _iMemWrite = iMemWrite;
 
-      _memory = new std::bitset<8>[MEMORY_SIZE];
+      // calloc() hands out pages of zeroes that the host only backs once
+      // they are written, so a memory costs what the program touches rather
+      // than MEMORY_SIZE bytes (several CPUs can then live in one process)
+      _memory = static_cast<std::uint8_t *>(calloc(MEMORY_SIZE, 1));
+      assert(_memory != nullptr);
 
       if (initFileName != nullptr) {
         // Each line of the memory initialization file consists of:
@@ -43,70 +57,166 @@ class Memory : public DigitalCircuit {
           printf("INFO: memory[0x%08lx..0x%08lx] <-- 0x%08lx\n",
                  (unsigned long)addr, (unsigned long)(addr + 3),
                  (unsigned long)value);
-          if (_endianness == LittleEndian) {
-            _memory[addr + 0] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 1] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 2] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 3] = (std::uint8_t)(value % 0x100);
-          } else { // _endianness == BigEndian
-            _memory[addr + 3] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 2] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 1] = (std::uint8_t)(value % 0x100); value >>= 8;
-            _memory[addr + 0] = (std::uint8_t)(value % 0x100);
-          }
+          _storeWord(addr, value);
         }
         fclose(initFile);
       }
     }
 
     void printMemory() {
-      for (size_t i = 0; i < MEMORY_SIZE; i += 4) {
-        if (_memory[i].any() || _memory[i + 1].any() || _memory[i + 2].any()
-            || _memory[i + 3].any()) {
-          std::uint32_t value = 0;
-          value += (_memory[i + 3].to_ulong()); value <<= 8;
-          value += (_memory[i + 2].to_ulong()); value <<= 8;
-          value += (_memory[i + 1].to_ulong()); value <<= 8;
-          value += (_memory[i + 0].to_ulong());
-          printf("  memory[0x%08lx..0x%08lx] = 0x%08lx\n", i + 3, i,
-                 (unsigned long)value);
+      forEachLoadedWord([](std::uint32_t i, std::uint32_t value) {
+        if (value != 0) {
+          printf("  memory[0x%08lx..0x%08lx] = 0x%08lx\n", (unsigned long)(i + 3),
+                 (unsigned long)i, (unsigned long)value);
+        }
+      });
+    }
+
+    // void Memory::forEachLoadedWord()
+    //   - calls 'visit(address, value)' for every aligned word that has
+    //     ever been written, in the order of the addresses; only those words
+    //     can be non-zero, so this is what printMemory() and anything that
+    //     captures the memory walk instead of the whole memory
+    template<typename Visitor>
+    void forEachLoadedWord(Visitor visit) const {
+      for (size_t b = 0; b < _loadedBlocks.size(); b++) {
+        for (std::uint64_t blocks = _loadedBlocks[b]; blocks != 0; blocks &= blocks - 1) {
+          const size_t w = b * 64 + __builtin_ctzll(blocks);
+          for (std::uint64_t words = _loadedWords[w]; words != 0; words &= words - 1) {
+            const std::uint32_t i = (std::uint32_t)((w * 64 + __builtin_ctzll(words)) * 4);
+            visit(i, _readWord(i));
+          }
         }
       }
     }
 
+    // void Memory::setWriteHook()
+    //   - 'hook(address, oldValue, newValue)' is called on every change of an
+    //     aligned word from now on, with the values printMemory() shows (see
+    //     StateDigest::watch())
+    void setWriteHook(const WriteHook &hook) {
+      _writeHook = hook;
+    }
+
     virtual void advanceCycle() {
       if (_iMemRead->test(0)) {
-        std::uint32_t address = _iAddress->to_ulong();
-        std::uint32_t data = 0;
-        for (int i = 0; i < 4; ++i) {
-          if (_endianness == LittleEndian) {
-            data |= (_memory[address + i].to_ulong() << (i * 8));
-          } else {
-            data |= (_memory[address + i].to_ulong() << ((3 - i) * 8));
-          }
-        }
-        *_oReadData = data;
+        *_oReadData = _loadWord(_iAddress->to_ulong());
       }
 
       if (_iMemWrite->test(0)) {
-        std::uint32_t address = _iAddress->to_ulong();
-        std::uint32_t data = _iWriteData->to_ulong();
-        for (int i = 0; i < 4; ++i) {
-          if (_endianness == LittleEndian) {
-            _memory[address + i] = (data >> (i * 8)) & 0xFF;
-          } else {
-            _memory[address + i] = (data >> ((3 - i) * 8)) & 0xFF;
-          }
-        }
+        _storeWord(_iAddress->to_ulong(), _iWriteData->to_ulong());
       }
     }
 
+    // std::uint32_t Memory::readWord()
+    //   - the 32-bit data at 'address', as a load would read it
+    std::uint32_t readWord(std::uint32_t address) const {
+      return _loadWord(address);
+    }
+
+    // void Memory::writeWord()
+    //   - stores 'data' at 'address', as a store (or a line of the
+    //     initialization file) would
+    void writeWord(std::uint32_t address, std::uint32_t data) {
+      _storeWord(address, data);
+    }
+
+    // bool Memory::isLoaded()
+    //   - true if the aligned word at 'address' has ever been written
+    bool isLoaded(std::uint32_t address) const {
+      if (address >= MEMORY_SIZE) {
+        return false;
+      }
+      const std::uint32_t w = address / 4;
+      return (_loadedWords[w / 64] >> (w % 64)) & 1;
+    }
+
+    // void Memory::clear()
+    //   - zeroes the memory; only the words that have been written are
+    //     touched, so this is far cheaper than allocating a new one
+    void clear() {
+      forEachLoadedWord([this](std::uint32_t i, std::uint32_t value) {
+        if (_writeHook) {
+          _writeHook(i, value, 0);
+        }
+        _memory[i] = _memory[i + 1] = _memory[i + 2] = _memory[i + 3] = 0;
+      });
+      std::fill(_loadedWords.begin(), _loadedWords.end(), 0);
+      std::fill(_loadedBlocks.begin(), _loadedBlocks.end(), 0);
+    }
+
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iAddress, _iWriteData, _iMemRead, _iMemWrite });
+      outputs.insert(outputs.end(), { _oReadData });
+    }
+
     ~Memory() {
-      delete[] _memory;
+      free(_memory);
     }
 
   private:
 
+    // void Memory::_touch()
+    //   - records the aligned words covered by the four bytes from 'address'
+    void _touch(std::uint32_t address) {
+      _touchWord((address & ~3u) / 4);
+      _touchWord(((address + 3) & ~3u) / 4);
+    }
+
+    void _touchWord(std::uint32_t w) {
+      if (w >= MEMORY_SIZE / 4) {
+        return;
+      }
+      _loadedWords[w / 64] |= 1ULL << (w % 64);
+      _loadedBlocks[w / 64 / 64] |= 1ULL << (w / 64 % 64);
+    }
+
+    std::uint32_t _loadWord(std::uint32_t address) const {
+      std::uint32_t data = 0;
+      for (int i = 0; i < 4; ++i) {
+        if (_endianness == LittleEndian) {
+          data |= ((std::uint32_t)_memory[address + i] << (i * 8));
+        } else {
+          data |= ((std::uint32_t)_memory[address + i] << ((3 - i) * 8));
+        }
+      }
+      return data;
+    }
+
+    void _storeWord(std::uint32_t address, std::uint32_t data) {
+      // an unaligned write changes two words
+      const std::uint32_t first = address & ~3u, last = (address + 3) & ~3u;
+      std::uint32_t oldFirst = 0, oldLast = 0;
+      if (_writeHook) {
+        oldFirst = _readWord(first);
+        oldLast = _readWord(last);
+      }
+      for (int i = 0; i < 4; ++i) {
+        if (_endianness == LittleEndian) {
+          _memory[address + i] = (data >> (i * 8)) & 0xFF;
+        } else {
+          _memory[address + i] = (data >> ((3 - i) * 8)) & 0xFF;
+        }
+      }
+      _touch(address);
+      if (_writeHook) {
+        _writeHook(first, oldFirst, _readWord(first));
+        if (last != first) {
+          _writeHook(last, oldLast, _readWord(last));
+        }
+      }
+    }
+
+    // the little-endian value of the aligned word at 'i', as printed
+    std::uint32_t _readWord(std::uint32_t i) const {
+      std::uint32_t value = 0;
+      value += _memory[i + 3]; value <<= 8;
+      value += _memory[i + 2]; value <<= 8;
+      value += _memory[i + 1]; value <<= 8;
+      value += _memory[i + 0];
+      return value;
+    }
+
     const Wire<32> *_iAddress;
     const Wire<32> *_iWriteData;
     const Wire<1> *_iMemRead;
@@ -114,9 +224,18 @@ class Memory : public DigitalCircuit {
     Wire<32> *_oReadData;
 
     Endianness _endianness;
-    std::bitset<8> *_memory;
+    std::uint8_t *_memory; // MEMORY_SIZE bytes
+    // the aligned words that have been written, one bit each, and the
+    // groups of 64 of those bits that have any set, so a walk over them
+    // skips the untouched parts of the memory; a store only sets two bits
+    std::vector<std::uint64_t> _loadedWords = std::vector<std::uint64_t>(MEMORY_SIZE / 4 / 64);
+    std::vector<std::uint64_t> _loadedBlocks = std::vector<std::uint64_t>(MEMORY_SIZE / 4 / 64 / 64);
+
+    WriteHook _writeHook; // called on every change of a word, if set
 
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
 
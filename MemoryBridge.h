@@ -0,0 +1,197 @@
+#ifndef __MEMORY_BRIDGE_H__
+#define __MEMORY_BRIDGE_H__
+
+#include "ClockDomain.h"
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <cstdint>
+#include <cstdio>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+class MemoryBridge : public DigitalCircuit {
+
+  public:
+
+    // MemoryBridge::MemoryBridge()
+    //   - the crossing between the MEM stage, in the core clock domain, and
+    //     the data memory, in a clock domain of its own; the first six wires
+    //     are the MEM-stage side (same meaning as the ones of StoreBuffer),
+    //     and the 'mem*' wires are the port of 'memory', which the bridge
+    //     drives on the edges of the memory clock
+    //   - an access is sent as a request through a synchronizing latch of the
+    //     memory domain and answered through one of the core domain, so it
+    //     takes at least a memory edge and then a core edge, and MEM stalls
+    //     until the answer has arrived
+    //   - the MEM-stage side may also be a unit in front of the bridge (see
+    //     StoreBuffer); an access other than the one in flight waits until
+    //     that one has been answered and taken
+    MemoryBridge(const std::string &name,
+                 const Wire<32> *iAddress,
+                 const Wire<32> *iWriteData,
+                 const Wire<1> *iMemRead,
+                 const Wire<1> *iMemWrite,
+                 Wire<32> *oReadData,
+                 Wire<1> *oStall,
+                 DigitalCircuit *memory,
+                 Wire<32> *memAddress,
+                 Wire<32> *memWriteData,
+                 Wire<1> *memRead,
+                 Wire<1> *memWrite,
+                 const Wire<32> *memReadData)
+      : DigitalCircuit(name),
+        _requestSync(name + ".requestSync", &_request),
+        _responseSync(name + ".responseSync", &_response) {
+      _iAddress = iAddress;
+      _iWriteData = iWriteData;
+      _iMemRead = iMemRead;
+      _iMemWrite = iMemWrite;
+      _oReadData = oReadData;
+      _oStall = oStall;
+      _memory = memory;
+      _memAddress = memAddress;
+      _memWriteData = memWriteData;
+      _memRead = memRead;
+      _memWrite = memWrite;
+      _memReadData = memReadData;
+
+      reset();
+    }
+
+    // void MemoryBridge::connect()
+    //   - puts the memory side of the bridge, and the latch it reads the
+    //     requests from, in 'memDomain', and the latch the MEM stage reads
+    //     the answers from in 'coreDomain'; the MEM-stage side is evaluated
+    //     by the MEM stage itself, on the core edges
+    void connect(ClockDomain *coreDomain, ClockDomain *memDomain) {
+      coreDomain->addSync(&_responseSync);
+      memDomain->addSync(&_requestSync);
+      memDomain->add([this]() { _advanceMemoryCycle(); });
+    }
+
+    // bool MemoryBridge::isIdle()
+    //   - true unless an access is on its way to or from the data memory
+    bool isIdle() const {
+      return !_pending;
+    }
+
+    // void MemoryBridge::reset()
+    //   - drops the access in flight and the statistics
+    void reset() {
+      _request = Request_t();
+      _response = Response_t();
+      _requestSync.reset();
+      _responseSync.reset();
+      _pending = false;
+      _numAccesses = 0;
+      _numStallCycles = 0;
+    }
+
+    void printStats() {
+      printf("Memory Bridge Statistics:\n");
+      printf("  accesses           = %lu\n", (unsigned long)_numAccesses);
+      printf("  stallCycles        = %lu\n", (unsigned long)_numStallCycles);
+      printf("  avgStallCycles     = %.2f\n",
+             _numAccesses == 0 ? 0.0 : (double)_numStallCycles / (double)_numAccesses);
+    }
+
+    // the MEM-stage side, on the core edges
+    virtual void advanceCycle() {
+      *_oStall = 0;
+      if (!_iMemRead->test(0) && !_iMemWrite->test(0)) {
+        return;
+      }
+      if (_pending && !_isInFlight()) {
+        *_oStall = 1;
+        _numStallCycles += 1;
+        return;
+      }
+      if (_pending && _responseSync.getOutput().id == _request.id) {
+        // the answer to the access of the instruction in MEM1 has arrived
+        *_oReadData = _responseSync.getOutput().readData;
+        _pending = false;
+        return;
+      }
+      if (!_pending) {
+        _request.id += 1;
+        _request.address = _iAddress->to_ulong();
+        _request.writeData = _iWriteData->to_ulong();
+        _request.memRead = _iMemRead->test(0);
+        _request.memWrite = _iMemWrite->test(0);
+        _pending = true;
+        _numAccesses += 1;
+      }
+      *_oStall = 1;
+      _numStallCycles += 1;
+    }
+
+  private:
+
+    typedef struct {
+      std::uint32_t id; // the number of the access, 0 before the first one
+      std::uint32_t address;
+      std::uint32_t writeData;
+      bool memRead;
+      bool memWrite;
+    } Request_t;
+
+    typedef struct {
+      std::uint32_t id; // the number of the access answered
+      std::uint32_t readData;
+    } Response_t;
+
+    // true if the access offered is the one in flight
+    bool _isInFlight() const {
+      return _request.address == _iAddress->to_ulong() && _request.memRead == _iMemRead->test(0)
+             && _request.memWrite == _iMemWrite->test(0)
+             && (!_request.memWrite || _request.writeData == _iWriteData->to_ulong());
+    }
+
+    // the memory side, on the memory edges: a request not answered yet is
+    // carried out, and answered
+    void _advanceMemoryCycle() {
+      const Request_t &request = _requestSync.getOutput();
+      if (request.id == _response.id) {
+        return;
+      }
+      *_memAddress = request.address;
+      *_memWriteData = request.writeData;
+      *_memRead = request.memRead;
+      *_memWrite = request.memWrite;
+      _memory->advanceCycle();
+      *_memRead = 0;
+      *_memWrite = 0;
+      _response.id = request.id;
+      _response.readData = _memReadData->to_ulong();
+    }
+
+    const Wire<32> *_iAddress;
+    const Wire<32> *_iWriteData;
+    const Wire<1> *_iMemRead;
+    const Wire<1> *_iMemWrite;
+    Wire<32> *_oReadData;
+    Wire<1> *_oStall;
+
+    DigitalCircuit *_memory;
+    Wire<32> *_memAddress;
+    Wire<32> *_memWriteData;
+    Wire<1> *_memRead;
+    Wire<1> *_memWrite;
+    const Wire<32> *_memReadData;
+
+    Request_t _request; // driven by the core side
+    Response_t _response; // driven by the memory side
+    SyncLatch<Request_t> _requestSync; // '_request' as the memory side sees it
+    SyncLatch<Response_t> _responseSync; // '_response' as the core side sees it
+    bool _pending; // true from the request of an access until its answer arrives
+
+    // Statistics
+    std::uint64_t _numAccesses;
+    std::uint64_t _numStallCycles;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -2,6 +2,9 @@
 #define __MISCELLANEOUS_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+SIMULATOR_NAMESPACE_BEGIN
 
 template<size_t N>
 class Adder : public DigitalCircuit {
@@ -31,6 +34,11 @@ class Adder : public DigitalCircuit {
       }
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _input0, _input1 });
+      outputs.insert(outputs.end(), { _output });
+    }
+
   private:
 
     const Wire<N> *_input0, *_input1;
@@ -68,6 +76,11 @@ class SignExtend : public DigitalCircuit {
       }
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _input });
+      outputs.insert(outputs.end(), { _output });
+    }
+
   private:
 
     const Wire<N> *_input;
@@ -112,6 +125,11 @@ class MUX2 : public DigitalCircuit {
       }
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _input0, _input1, _select });
+      outputs.insert(outputs.end(), { _output });
+    }
+
   private:
 
     const Wire<N> *_input0, *_input1;
@@ -163,6 +181,11 @@ class MUX3 : public DigitalCircuit {
       }
     }
 
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _input0, _input1, _input2, _select });
+      outputs.insert(outputs.end(), { _output });
+    }
+
   private:
 
     const Wire<N> *_input0, *_input1, *_input2;
@@ -171,5 +194,64 @@ class MUX3 : public DigitalCircuit {
 
 };
 
+template<size_t N>
+class MUX4 : public DigitalCircuit {
+
+  public:
+
+    MUX4(
+      const std::string &name,
+      const Wire<N> *input0,
+      const Wire<N> *input1,
+      const Wire<N> *input2,
+      const Wire<N> *input3,
+      const Wire<2> *select,
+      Wire<N> *output
+    ) : DigitalCircuit(name) {
+      _input0 = input0;
+      _input1 = input1;
+      _input2 = input2;
+      _input3 = input3;
+      _select = select;
+      _output = output;
+    }
+
+    virtual void advanceCycle() {
+      _output->reset();
+      switch (_select->to_ulong()) {
+        case 0: {
+          (*_output) = (*_input0);
+          break;
+        }
+        case 1: {
+          (*_output) = (*_input1);
+          break;
+        }
+        case 2: {
+          (*_output) = (*_input2);
+          break;
+        }
+        case 3: {
+          (*_output) = (*_input3);
+          break;
+        }
+      }
+    }
+
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _input0, _input1, _input2, _input3, _select });
+      outputs.insert(outputs.end(), { _output });
+    }
+
+  private:
+
+    const Wire<N> *_input0, *_input1, *_input2, *_input3;
+    const Wire<2> *_select;
+    Wire<N> *_output;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
 #endif
 
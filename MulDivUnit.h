@@ -0,0 +1,301 @@
+#ifndef __MUL_DIV_UNIT_H__
+#define __MUL_DIV_UNIT_H__
+
+#include "DigitalCircuit.h"
+#include "OutputRecord.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef MULT_LATENCY
+#define MULT_LATENCY 4 // <-- the cycles a mult/multu takes in the (pipelined) multiplier
+#endif
+
+#ifndef DIV_LATENCY
+#define DIV_LATENCY 32 // <-- the cycles a div/divu takes in the (iterative, one-at-a-time) divider
+#endif
+
+// MulDivUnit
+//   - the multiplier and the divider beside the ALU, which write their
+//     results into the HI and LO registers; mfhi and mflo read them back
+//   - an operation is started in EX and its HI and LO are written
+//     'latency' cycles later, i.e., an mfhi in EX sees them in the cycle
+//     after that; the multiplier takes a new operation every cycle, but the
+//     divider only once the previous division is done
+class MulDivUnit : public DigitalCircuit {
+
+  public:
+
+    enum Op { None, Mult, Multu, Div, Divu, Mfhi, Mflo };
+
+    // the reasons for which an instruction waits in ID
+    enum Stall { NoStall, HiLoNotReady, UnitBusy };
+
+    // MulDivUnit::Op MulDivUnit::decode()
+    //   - the operation of an instruction, from its 'funct' field
+    static Op decode(const std::uint32_t instruction) {
+      if ((instruction >> 26) != 0b000000) {
+        return None;
+      }
+      switch (instruction & 0x3F) {
+        case 0x10: return Mfhi;
+        case 0x12: return Mflo;
+        case 0x18: return Mult;
+        case 0x19: return Multu;
+        case 0x1a: return Div;
+        case 0x1b: return Divu;
+        default: return None;
+      }
+    }
+
+    static bool isMulDiv(const Op op) {
+      return op == Mult || op == Multu || op == Div || op == Divu;
+    }
+
+    // void MulDivUnit::compute()
+    //   - the HI and LO an operation writes; MIPS leaves a division by zero
+    //     undefined, so it gives a quotient of all ones and the dividend as
+    //     the remainder, and the signed overflow (-2^31 / -1) gives -2^31
+    static void compute(const Op op, const std::uint32_t rs, const std::uint32_t rt,
+                        std::uint32_t &hi, std::uint32_t &lo) {
+      switch (op) {
+        case Mult: {
+          const std::int64_t product = (std::int64_t)(std::int32_t)rs * (std::int64_t)(std::int32_t)rt;
+          hi = (std::uint32_t)((std::uint64_t)product >> 32);
+          lo = (std::uint32_t)product;
+          break;
+        }
+        case Multu: {
+          const std::uint64_t product = (std::uint64_t)rs * (std::uint64_t)rt;
+          hi = (std::uint32_t)(product >> 32);
+          lo = (std::uint32_t)product;
+          break;
+        }
+        case Div:
+          if (rt == 0) {
+            hi = rs;
+            lo = 0xFFFFFFFF;
+          } else if (rs == 0x80000000 && rt == 0xFFFFFFFF) {
+            hi = 0;
+            lo = rs;
+          } else {
+            hi = (std::uint32_t)((std::int32_t)rs % (std::int32_t)rt);
+            lo = (std::uint32_t)((std::int32_t)rs / (std::int32_t)rt);
+          }
+          break;
+        case Divu:
+          hi = (rt == 0) ? rs : rs % rt;
+          lo = (rt == 0) ? 0xFFFFFFFF : rs / rt;
+          break;
+        default:
+          break;
+      }
+    }
+
+    // MulDivUnit::MulDivUnit()
+    //   - 'iOp' is the operation of the instruction in EX and 'iRs'/'iRt'
+    //     its operands; 'oResult' is HI for an mfhi and LO for an mflo
+    MulDivUnit(const std::string &name,
+               const Wire<3> *iOp,
+               const Wire<32> *iRs,
+               const Wire<32> *iRt,
+               Wire<32> *oResult,
+               const size_t multLatency = MULT_LATENCY,
+               const size_t divLatency = DIV_LATENCY)
+      : DigitalCircuit(name) {
+      _iOp = iOp;
+      _iRs = iRs;
+      _iRt = iRt;
+      _oResult = oResult;
+
+      assert(multLatency > 0);
+      assert(divLatency > 0);
+      _multLatency = multLatency;
+      _divLatency = divLatency;
+
+      reset();
+    }
+
+    // void MulDivUnit::reset()
+    //   - drops the operations in flight, HI and LO, and the statistics
+    void reset() {
+      _inFlight.clear();
+      _hi = 0;
+      _lo = 0;
+      _numMults = 0;
+      _numDivs = 0;
+      _numMoves = 0;
+      _numHiLoStallCycles = 0;
+      _numBusyStallCycles = 0;
+    }
+
+    // bool MulDivUnit::isIdle()
+    //   - true once every operation started has written HI and LO
+    bool isIdle() const {
+      return _inFlight.empty();
+    }
+
+    std::uint32_t getHI() const {
+      return _hi;
+    }
+
+    std::uint32_t getLO() const {
+      return _lo;
+    }
+
+    // MulDivUnit::Stall MulDivUnit::checkStall()
+    //   - whether the instruction in ID, with operation 'op', must wait
+    //     instead of going to EX in the next cycle, given 'exOp', the
+    //     operation of the one in EX, which starts in the current cycle:
+    //       * an mfhi/mflo waits until every operation has written HI and LO
+    //       * a division waits while the divider is busy
+    //       * an operation waits if it would write HI and LO before an
+    //         older one does (a multiplication behind a division)
+    //   - the inputs are all latches, so this is evaluated with the hazards,
+    //     before EX has run
+    Stall checkStall(const Op op, const Op exOp) const {
+      if (op == None) {
+        return NoStall;
+      }
+      // the cycles each operation still takes from the next cycle on
+      const size_t latency = _latencyOf(op);
+      Stall stall = NoStall;
+      for (size_t i = 0; i <= _inFlight.size(); i++) {
+        size_t cyclesLeft;
+        bool div;
+        if (i < _inFlight.size()) {
+          cyclesLeft = _inFlight[i].cyclesLeft - 1;
+          div = _inFlight[i].div;
+        } else if (isMulDiv(exOp)) {
+          cyclesLeft = _latencyOf(exOp) - 1;
+          div = (exOp == Div || exOp == Divu);
+        } else {
+          break;
+        }
+        if (cyclesLeft == 0) {
+          continue;
+        }
+        if (op == Mfhi || op == Mflo) {
+          return HiLoNotReady;
+        }
+        if (((op == Div || op == Divu) && div) || cyclesLeft > latency) {
+          stall = UnitBusy;
+        }
+      }
+      return stall;
+    }
+
+    // void MulDivUnit::countStall()
+    //   - ID counts the cycles it has waited
+    void countStall(const Stall stall) {
+      if (stall == HiLoNotReady) {
+        _numHiLoStallCycles += 1;
+      } else if (stall == UnitBusy) {
+        _numBusyStallCycles += 1;
+      }
+    }
+
+    // void MulDivUnit::captureHILO()
+    //   - appends HI and LO to 'record', to be printed by formatHILO()
+    void captureHILO(OutputRecord &record) const {
+      record.push_back(_hi);
+      record.push_back(_lo);
+    }
+
+    static void formatHILO(OutputRecordReader &reader, std::string &out) {
+      const std::uint32_t hi = reader.get();
+      const std::uint32_t lo = reader.get();
+      appendf(out, "  HI = 0x%08lx\n", (unsigned long)hi);
+      appendf(out, "  LO = 0x%08lx\n", (unsigned long)lo);
+    }
+
+    void printStats() {
+      printf("Multiply/Divide Unit Statistics (mult latency %lu, div latency %lu):\n",
+             (unsigned long)_multLatency, (unsigned long)_divLatency);
+      printf("  mults              = %lu\n", (unsigned long)_numMults);
+      printf("  divs               = %lu\n", (unsigned long)_numDivs);
+      printf("  moves              = %lu\n", (unsigned long)_numMoves);
+      printf("  hiLoStallCycles    = %lu\n", (unsigned long)_numHiLoStallCycles);
+      printf("  busyStallCycles    = %lu\n", (unsigned long)_numBusyStallCycles);
+    }
+
+    virtual void advanceCycle() {
+      const Op op = (Op)_iOp->to_ulong();
+
+      // an mfhi/mflo reads HI and LO as the operations before it left them
+      if (op == Mfhi || op == Mflo) {
+        *_oResult = (op == Mfhi) ? _hi : _lo;
+        _numMoves += 1;
+      }
+
+      if (isMulDiv(op)) {
+        InFlight entry;
+        entry.cyclesLeft = _latencyOf(op);
+        entry.div = (op == Div || op == Divu);
+        compute(op, _iRs->to_ulong(), _iRt->to_ulong(), entry.hi, entry.lo);
+        _inFlight.push_back(entry);
+        if (entry.div) {
+          _numDivs += 1;
+        } else {
+          _numMults += 1;
+        }
+      }
+
+      // the operations finish in the order they started
+      for (InFlight &entry : _inFlight) {
+        entry.cyclesLeft -= 1;
+      }
+      while (!_inFlight.empty() && _inFlight.front().cyclesLeft == 0) {
+        _hi = _inFlight.front().hi;
+        _lo = _inFlight.front().lo;
+        _inFlight.pop_front();
+      }
+    }
+
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iOp, _iRs, _iRt });
+      outputs.insert(outputs.end(), { _oResult });
+    }
+
+  private:
+
+    typedef struct {
+      size_t cyclesLeft; // the cycles until HI and LO are written
+      bool div; // true if the operation occupies the divider
+      std::uint32_t hi;
+      std::uint32_t lo;
+    } InFlight;
+
+    size_t _latencyOf(const Op op) const {
+      return (op == Div || op == Divu) ? _divLatency : _multLatency;
+    }
+
+    const Wire<3> *_iOp;
+    const Wire<32> *_iRs;
+    const Wire<32> *_iRt;
+    Wire<32> *_oResult;
+
+    size_t _multLatency;
+    size_t _divLatency;
+
+    std::deque<InFlight> _inFlight; // the operations started but not done, oldest first
+    std::uint32_t _hi;
+    std::uint32_t _lo;
+
+    // Statistics
+    std::uint64_t _numMults;
+    std::uint64_t _numDivs;
+    std::uint64_t _numMoves; // mfhi and mflo
+    std::uint64_t _numHiLoStallCycles;
+    std::uint64_t _numBusyStallCycles;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
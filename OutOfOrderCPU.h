@@ -0,0 +1,680 @@
+#ifndef __OUT_OF_ORDER_CPU_H__
+#define __OUT_OF_ORDER_CPU_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include "Memory.h"
+#include "Control.h"
+#include "RegisterFile.h"
+#include "ALU.h"
+#include "ALUControl.h"
+
+// OutOfOrderCPU is configured only by ENABLE_OUT_OF_ORDER and the OOO_*
+// sizes below; it forwards and resolves the hazards by itself, so
+// ENABLE_DATA_FORWARDING and ENABLE_HAZARD_DETECTION make no difference,
+// and every other ENABLE_* option is a feature of PipelinedCPU
+#if defined(ENABLE_PIPELINE_STATS) || defined(ENABLE_STORE_BUFFER) || defined(ENABLE_TRACE_DRIVEN) \
+    || defined(ENABLE_VCD_DUMP) || defined(ENABLE_ASYNC_OUTPUT) || defined(ENABLE_PROFILER) \
+    || defined(ENABLE_STATE_DIGEST) || defined(ENABLE_PARALLEL_STAGES) || defined(ENABLE_FETCH_QUEUE) \
+    || defined(ENABLE_MULTITHREADING) || defined(ENABLE_HOST_PROFILER) || defined(ENABLE_MULT_DIV) \
+    || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PIPEVIEW) || defined(ENABLE_JUMPS) \
+    || defined(ENABLE_JUMP_PREDICTION) || defined(ENABLE_PREFETCHER) || defined(ENABLE_TIMING_MODEL) \
+    || defined(ENABLE_MACRO_FUSION) || defined(ENABLE_PVS_ARCHIVE) || defined(ENABLE_VIRTUAL_MEMORY)
+#error "OutOfOrderCPU supports only ENABLE_OUT_OF_ORDER (with ENABLE_DATA_FORWARDING and ENABLE_HAZARD_DETECTION ignored); the other ENABLE_* options are only supported by PipelinedCPU"
+#endif
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <utility>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef OOO_WIDTH
+#define OOO_WIDTH 2 // <-- instructions fetched/dispatched/issued/committed per cycle
+#endif
+
+#ifndef OOO_ROB_SIZE
+#define OOO_ROB_SIZE 32 // <-- the number of reorder buffer entries
+#endif
+
+#ifndef OOO_RS_SIZE
+#define OOO_RS_SIZE 16 // <-- the number of reservation stations
+#endif
+
+#ifndef OOO_LSQ_SIZE
+#define OOO_LSQ_SIZE 16 // <-- the number of load/store queue entries
+#endif
+
+#ifndef OOO_BRANCH_DELAY_SLOTS
+#define OOO_BRANCH_DELAY_SLOTS 2 // <-- the instructions after a taken beq that PipelinedCPU still executes
+#endif
+
+#ifndef OOO_FETCH_QUEUE_SIZE
+#define OOO_FETCH_QUEUE_SIZE (2 * OOO_WIDTH) // <-- the number of fetched-but-not-dispatched instructions
+#endif
+
+// OutOfOrderCPU
+//   - a Tomasulo-style core with a reorder buffer, built from the same
+//     Control, RegisterFile, ALUControl, ALU and Memory components as
+//     PipelinedCPU, so that both can run the same program images
+//   - the Register File holds the committed state; in-flight values live in
+//     the reorder buffer and are renamed through the register alias table
+//   - branches are predicted not-taken and resolved at commit; like
+//     PipelinedCPU (and FunctionalCPU), a taken beq still commits the two
+//     instructions after it, its branch delay slots, before the younger
+//     instructions are flushed and the fetch goes to the target
+//   - loads wait until the addresses of all older stores are known, then
+//     either take the data of the youngest matching store or read the data
+//     memory; stores write the data memory at commit
+class OutOfOrderCPU : public DigitalCircuit {
+
+  public:
+
+    OutOfOrderCPU(
+      const std::string &name,
+      const std::uint32_t &initialPC,
+      const Memory::Endianness &memoryEndianness,
+      const char *regFileName,
+      const char *instMemFileName,
+      const char *dataMemFileName,
+      const size_t width = OOO_WIDTH,
+      const size_t robSize = OOO_ROB_SIZE,
+      const size_t rsSize = OOO_RS_SIZE,
+      const size_t lsqSize = OOO_LSQ_SIZE,
+      const size_t fetchQueueSize = OOO_FETCH_QUEUE_SIZE
+    ) : DigitalCircuit(name) {
+      assert(width > 0 && robSize > 0 && rsSize > 0 && lsqSize > 0 && fetchQueueSize > 0);
+
+      _currCycle = 0;
+      // the driver passes (initialPC - 4) like it does for PipelinedCPU
+      _PC = initialPC + 4;
+
+      _width = width;
+      _fetchQueueSize = fetchQueueSize;
+
+      _instMemory = new Memory(
+        "InstMemory",
+        &_instMemAddress,
+        &_alwaysLo32,
+        &_alwaysHi,
+        &_alwaysLo,
+        &_instMemReadData,
+        memoryEndianness,
+        instMemFileName);
+
+      _control = new Control(
+        &_opcode,
+        &_ctrlRegDst,
+        &_ctrlALUSrc,
+        &_ctrlMemToReg,
+        &_ctrlRegWrite,
+        &_ctrlMemRead,
+        &_ctrlMemWrite,
+        &_ctrlBranch,
+        &_ctrlALUOp);
+
+      _registerFile = new RegisterFile(
+        &_regFileReadRegister1,
+        &_regFileReadRegister2,
+        &_regFileWriteRegister,
+        &_regFileWriteData,
+        &_regFileRegWrite,
+        &_regFileReadData1,
+        &_regFileReadData2,
+        regFileName);
+
+      _dataMemory = new Memory(
+        "dataMemory",
+        &_dataMemAddress,
+        &_dataMemWriteData,
+        &_dataMemRead,
+        &_dataMemWrite,
+        &_dataMemReadData,
+        memoryEndianness,
+        dataMemFileName);
+
+      for (size_t i = 0; i < _width; i++) {
+        FunctionalUnit_t *fu = new FunctionalUnit_t();
+        fu->aluControl = new ALUControl(&fu->aluOp, &fu->funct, &fu->operation);
+        fu->alu = new ALU(&fu->operation, &fu->input0, &fu->input1, &fu->output, &fu->zero);
+        _functionalUnits.push_back(fu);
+      }
+
+      _rob.resize(robSize);
+      _rs.resize(rsSize);
+      _lsq.resize(lsqSize);
+      _flushAll();
+    }
+
+    ~OutOfOrderCPU() {
+      delete _instMemory;
+      delete _control;
+      delete _registerFile;
+      delete _dataMemory;
+      for (size_t i = 0; i < _functionalUnits.size(); i++) {
+        delete _functionalUnits[i]->aluControl;
+        delete _functionalUnits[i]->alu;
+        delete _functionalUnits[i];
+      }
+    }
+
+    void commit() {
+      for (size_t n = 0; n < _width && _robCount > 0; n++) {
+        ROBEntry_t &head = _rob[_robHead];
+        if (!head.done) {
+          break;
+        }
+
+        if (head.isStore) {
+          assert(_lsqCount > 0 && _lsq[_lsqHead].robIdx == _robHead);
+          _dataMemAddress = _lsq[_lsqHead].address;
+          _dataMemWriteData = _lsq[_lsqHead].data;
+          _dataMemRead = 0;
+          _dataMemWrite = 1;
+          _dataMemory->advanceCycle();
+          _dataMemWrite = 0;
+        }
+        if (head.isStore || head.isLoad) {
+          _lsq[_lsqHead].busy = false;
+          _lsqHead = (_lsqHead + 1) % _lsq.size();
+          _lsqCount -= 1;
+        }
+
+        if (head.destReg > 0) {
+          _regFileWriteRegister = head.destReg;
+          _regFileWriteData = head.value;
+          _regFileRegWrite = 1;
+          _registerFile->advanceCycle();
+          _regFileRegWrite = 0;
+          if (_rat[head.destReg] == (int)_robHead) {
+            _rat[head.destReg] = -1;
+          }
+        }
+
+        if (head.isBranch && head.taken) {
+          _redirects.push_back(std::make_pair(_numRetired + 1 + OOO_BRANCH_DELAY_SLOTS, head.target));
+        }
+        _numRetired += 1;
+        head.busy = false;
+        _robHead = (_robHead + 1) % _rob.size();
+        _robCount -= 1;
+
+        if (!_redirects.empty() && _redirects.front().first == _numRetired) {
+          // everything younger than the delay slots is on the wrong path
+          _numFlushes += 1;
+          _flushAll();
+          _PC = _redirects.front().second;
+          _redirects.pop_front();
+          break;
+        }
+      }
+    }
+
+    void writeBack() {
+      for (size_t i = 0; i < _results.size(); i++) {
+        const Result_t &result = _results[i];
+        ROBEntry_t &entry = _rob[result.robIdx];
+        if (entry.isLoad && !result.fromLSQ) {
+          // the effective address of a load
+          _lsq[entry.lsqIdx].address = result.value;
+          _lsq[entry.lsqIdx].addrReady = true;
+        } else if (entry.isStore) {
+          _lsq[entry.lsqIdx].address = result.value;
+          _lsq[entry.lsqIdx].data = result.storeData;
+          _lsq[entry.lsqIdx].addrReady = true;
+          entry.done = true;
+        } else if (entry.isBranch) {
+          entry.taken = result.zero;
+          entry.done = true;
+        } else {
+          entry.value = result.value;
+          entry.done = true;
+          _broadcast(result.robIdx, result.value);
+        }
+      }
+      _results.clear();
+    }
+
+    void issue() {
+      // reservation stations, oldest first, one per functional unit
+      size_t numIssued = 0;
+      while (numIssued < _functionalUnits.size()) {
+        int selected = -1;
+        for (size_t i = 0; i < _rs.size(); i++) {
+          if (_rs[i].busy && _rs[i].qj < 0 && _rs[i].qk < 0) {
+            if (selected < 0 || _robAge(_rs[i].robIdx) < _robAge(_rs[selected].robIdx)) {
+              selected = i;
+            }
+          }
+        }
+        if (selected < 0) {
+          break;
+        }
+
+        RSEntry_t &rs = _rs[selected];
+        FunctionalUnit_t *fu = _functionalUnits[numIssued];
+        fu->aluOp = rs.aluOp;
+        fu->funct = rs.funct;
+        fu->aluControl->advanceCycle();
+        fu->input0 = rs.vj;
+        fu->input1 = rs.aluSrc ? rs.imm : rs.vk;
+        fu->alu->advanceCycle();
+
+        Result_t result = {};
+        result.robIdx = rs.robIdx;
+        result.value = fu->output.to_ulong();
+        result.zero = fu->zero.test(0);
+        result.storeData = rs.vk;
+        _results.push_back(result);
+
+        rs.busy = false;
+        numIssued += 1;
+      }
+
+      // the load/store queue has a single data memory read port
+      for (size_t n = 0; n < _lsqCount; n++) {
+        size_t idx = (_lsqHead + n) % _lsq.size();
+        LSQEntry_t &load = _lsq[idx];
+        if (load.isStore || !load.addrReady || load.executed) {
+          continue;
+        }
+
+        bool blocked = false;
+        int forwardFrom = -1;
+        for (size_t m = n; m-- > 0; ) {
+          const LSQEntry_t &store = _lsq[(_lsqHead + m) % _lsq.size()];
+          if (!store.isStore) {
+            continue;
+          }
+          if (!store.addrReady) {
+            blocked = true;
+            break;
+          }
+          if (forwardFrom < 0 && _overlaps(store.address, load.address)) {
+            if (store.address == load.address) {
+              forwardFrom = (_lsqHead + m) % _lsq.size();
+            } else {
+              blocked = true; // wait until the partially-overlapping store commits
+              break;
+            }
+          }
+        }
+        if (blocked) {
+          continue;
+        }
+
+        Result_t result = {};
+        result.robIdx = load.robIdx;
+        result.fromLSQ = true;
+        if (forwardFrom >= 0) {
+          result.value = _lsq[forwardFrom].data;
+          _numForwardedLoads += 1;
+        } else {
+          _dataMemAddress = load.address;
+          _dataMemRead = 1;
+          _dataMemWrite = 0;
+          _dataMemory->advanceCycle();
+          _dataMemRead = 0;
+          result.value = _dataMemReadData.to_ulong();
+        }
+        _results.push_back(result);
+        load.executed = true;
+        break;
+      }
+    }
+
+    void dispatch() {
+      for (size_t n = 0; n < _width && !_fetchQueue.empty(); n++) {
+        const FetchedInstruction_t &fetched = _fetchQueue.front();
+        std::uint32_t instruction = fetched.instruction;
+
+        _opcode = (instruction >> 26) & 0x3F;
+        _control->advanceCycle();
+
+        bool isLoad = _ctrlMemRead.test(0);
+        bool isStore = _ctrlMemWrite.test(0);
+        bool isBranch = _ctrlBranch.test(0);
+        bool isALU = _ctrlRegWrite.test(0) && !isLoad;
+        bool needsRS = isLoad || isStore || isBranch || isALU;
+
+        if (_robCount == _rob.size()) {
+          _numROBFullStalls += 1;
+          break;
+        }
+        int rsIdx = -1;
+        if (needsRS) {
+          for (size_t i = 0; i < _rs.size(); i++) {
+            if (!_rs[i].busy) {
+              rsIdx = i;
+              break;
+            }
+          }
+          if (rsIdx < 0) {
+            _numRSFullStalls += 1;
+            break;
+          }
+        }
+        if ((isLoad || isStore) && _lsqCount == _lsq.size()) {
+          _numLSQFullStalls += 1;
+          break;
+        }
+
+        std::uint8_t rs = (instruction >> 21) & 0x1F;
+        std::uint8_t rt = (instruction >> 16) & 0x1F;
+        std::uint8_t rd = (instruction >> 11) & 0x1F;
+        std::uint32_t imm = (std::uint32_t)(std::int32_t)(std::int16_t)(instruction & 0xFFFF);
+
+        size_t robIdx = (_robHead + _robCount) % _rob.size();
+        ROBEntry_t &entry = _rob[robIdx];
+        entry = ROBEntry_t();
+        entry.busy = true;
+        entry.pc = fetched.pc;
+        entry.instruction = instruction;
+        entry.destReg = -1;
+        entry.isLoad = isLoad;
+        entry.isStore = isStore;
+        entry.isBranch = isBranch;
+        entry.target = fetched.pc + 4 + (imm << 2);
+        entry.lsqIdx = -1;
+        entry.done = !needsRS; // unsupported opcodes retire as nops
+        _robCount += 1;
+
+        if (needsRS) {
+          RSEntry_t &station = _rs[rsIdx];
+          station = RSEntry_t();
+          station.busy = true;
+          station.robIdx = robIdx;
+          station.aluOp = _ctrlALUOp;
+          station.funct = instruction & 0x3F;
+          station.aluSrc = _ctrlALUSrc.test(0);
+          station.imm = imm;
+          _readOperand(rs, station.vj, station.qj);
+          if (isStore || isBranch || (isALU && !station.aluSrc)) {
+            _readOperand(rt, station.vk, station.qk);
+          } else {
+            station.vk = 0;
+            station.qk = -1;
+          }
+        }
+
+        if (isLoad || isStore) {
+          size_t lsqIdx = (_lsqHead + _lsqCount) % _lsq.size();
+          _lsq[lsqIdx] = LSQEntry_t();
+          _lsq[lsqIdx].busy = true;
+          _lsq[lsqIdx].robIdx = robIdx;
+          _lsq[lsqIdx].isStore = isStore;
+          _lsqCount += 1;
+          entry.lsqIdx = lsqIdx;
+        }
+
+        // rename the destination only after the sources have been read
+        if (_ctrlRegWrite.test(0)) {
+          std::uint8_t dest = _ctrlRegDst.test(0) ? rd : rt;
+          if (dest != 0) {
+            entry.destReg = dest;
+            _rat[dest] = robIdx;
+          }
+        }
+
+        _fetchQueue.pop_front();
+      }
+    }
+
+    void fetch() {
+      for (size_t n = 0; n < _width && _fetchQueue.size() < _fetchQueueSize; n++) {
+        _instMemAddress = _PC;
+        _instMemory->advanceCycle();
+        FetchedInstruction_t fetched = {
+          (std::uint32_t)_PC.to_ulong(), (std::uint32_t)_instMemReadData.to_ulong() };
+        _fetchQueue.push_back(fetched);
+        _PC = _PC.to_ulong() + 4;
+      }
+    }
+
+    virtual void advanceCycle() {
+      _currCycle += 1;
+
+      commit();
+      writeBack();
+      issue();
+      dispatch();
+      fetch();
+    }
+
+  private:
+
+    typedef struct {
+      std::uint32_t pc; // the address of the instruction
+      std::uint32_t instruction; // 32-bit instruction
+    } FetchedInstruction_t;
+
+    typedef struct {
+      bool busy;
+      bool done; // the result (or the branch outcome) is known
+      std::uint32_t pc; // the address of the instruction
+      std::uint32_t instruction; // 32-bit instruction
+      int destReg; // the architectural destination register, -1 if none
+      std::uint32_t value; // the result to be written at commit
+      bool isLoad, isStore, isBranch;
+      bool taken; // the outcome of a branch
+      std::uint32_t target; // the branch target address
+      int lsqIdx; // the load/store queue entry, -1 if none
+    } ROBEntry_t;
+
+    typedef struct {
+      bool busy;
+      size_t robIdx; // the reorder buffer entry of the instruction
+      Register<2> aluOp; // 'ALUOp' from the Control unit
+      Register<6> funct; // the 'funct' field
+      bool aluSrc; // 'ALUSrc' from the Control unit
+      std::uint32_t vj, vk; // the operand values
+      int qj, qk; // the reorder buffer entries producing the operands, -1 if ready
+      std::uint32_t imm; // the 32-bit sign-extended immediate value
+    } RSEntry_t;
+
+    typedef struct {
+      bool busy;
+      size_t robIdx; // the reorder buffer entry of the instruction
+      bool isStore;
+      bool addrReady; // the effective address (and, for stores, the data) is known
+      std::uint32_t address; // the effective address
+      std::uint32_t data; // the data to be stored
+      bool executed; // the load has read its data
+    } LSQEntry_t;
+
+    typedef struct {
+      size_t robIdx; // the reorder buffer entry of the producer
+      bool fromLSQ; // the data of a load (rather than an ALU output)
+      std::uint32_t value; // the ALU output or the loaded data
+      bool zero; // 'Zero' from the ALU
+      std::uint32_t storeData; // the data of a store
+    } Result_t;
+
+    typedef struct {
+      Wire<2> aluOp;
+      Wire<6> funct;
+      Wire<4> operation;
+      Wire<32> input0, input1, output;
+      Wire<1> zero;
+      ALUControl *aluControl;
+      ALU *alu;
+    } FunctionalUnit_t;
+
+    static bool _overlaps(std::uint32_t a, std::uint32_t b) {
+      return (a < b + 4) && (b < a + 4);
+    }
+
+    size_t _robAge(size_t robIdx) const {
+      return (robIdx + _rob.size() - _robHead) % _rob.size();
+    }
+
+    void _readOperand(std::uint8_t reg, std::uint32_t &value, int &tag) {
+      tag = -1;
+      if (reg != 0 && _rat[reg] >= 0) {
+        const ROBEntry_t &producer = _rob[_rat[reg]];
+        if (producer.done) {
+          value = producer.value;
+        } else {
+          tag = _rat[reg];
+        }
+        return;
+      }
+      _regFileReadRegister1 = reg;
+      _regFileRegWrite = 0;
+      _registerFile->advanceCycle();
+      value = _regFileReadData1.to_ulong();
+    }
+
+    void _broadcast(size_t robIdx, std::uint32_t value) {
+      for (size_t i = 0; i < _rs.size(); i++) {
+        if (!_rs[i].busy) {
+          continue;
+        }
+        if (_rs[i].qj == (int)robIdx) {
+          _rs[i].vj = value;
+          _rs[i].qj = -1;
+        }
+        if (_rs[i].qk == (int)robIdx) {
+          _rs[i].vk = value;
+          _rs[i].qk = -1;
+        }
+      }
+    }
+
+    void _flushAll() {
+      for (size_t i = 0; i < _rob.size(); i++) { _rob[i].busy = false; }
+      for (size_t i = 0; i < _rs.size(); i++) { _rs[i].busy = false; }
+      for (size_t i = 0; i < _lsq.size(); i++) { _lsq[i].busy = false; }
+      for (size_t i = 0; i < 32; i++) { _rat[i] = -1; }
+      _robHead = _robCount = 0;
+      _lsqHead = _lsqCount = 0;
+      _fetchQueue.clear();
+      _results.clear();
+    }
+
+    // Cycle tracker
+    std::uint64_t _currCycle = 0;
+
+    // Always-1/0 wires
+    const Wire<1> _alwaysHi = 1;
+    const Wire<1> _alwaysLo = 0;
+    const Wire<32> _alwaysLo32 = 0;
+
+    // Configuration
+    size_t _width;
+    size_t _fetchQueueSize;
+
+    // Components
+    Register<32> _PC; // the Program Counter (PC) register
+    Memory *_instMemory; // the instruction memory
+    Control *_control; // the Control unit
+    RegisterFile *_registerFile; // the Register File (the committed state)
+    Memory *_dataMemory; // the data memory
+    std::vector<FunctionalUnit_t *> _functionalUnits; // the ALU Control unit and the ALU of each issue slot
+
+    // Out-of-order structures
+    std::deque<FetchedInstruction_t> _fetchQueue; // the instructions fetched but not dispatched
+    int _rat[32]; // the register alias table (reorder buffer entry per register, -1 if committed)
+    std::vector<RSEntry_t> _rs; // the reservation stations
+    std::vector<ROBEntry_t> _rob; // the reorder buffer
+    size_t _robHead, _robCount;
+    std::vector<LSQEntry_t> _lsq; // the load/store queue
+    size_t _lsqHead, _lsqCount;
+    std::vector<Result_t> _results; // the results to be broadcast in the next cycle
+    // the taken branches in their delay slots: the number of retired
+    // instructions after which the fetch is redirected, and the target
+    std::deque<std::pair<std::uint64_t, std::uint32_t>> _redirects;
+
+    // Wires
+    Wire<32> _instMemAddress, _instMemReadData; // the instruction memory port
+    Wire<6> _opcode; // the input to the Control unit
+    Wire<1> _ctrlRegDst, _ctrlALUSrc, _ctrlMemToReg, _ctrlRegWrite; // the outputs of the Control unit
+    Wire<1> _ctrlMemRead, _ctrlMemWrite, _ctrlBranch; // the outputs of the Control unit
+    Wire<2> _ctrlALUOp; // the output of the Control unit
+    Wire<5> _regFileReadRegister1, _regFileReadRegister2, _regFileWriteRegister; // the Register File port
+    Wire<32> _regFileWriteData, _regFileReadData1, _regFileReadData2; // the Register File port
+    Wire<1> _regFileRegWrite; // the Register File port
+    Wire<32> _dataMemAddress, _dataMemWriteData, _dataMemReadData; // the data memory port
+    Wire<1> _dataMemRead, _dataMemWrite; // the data memory port
+
+    // Statistics
+    std::uint64_t _numRetired = 0;
+    std::uint64_t _numFlushes = 0;
+    std::uint64_t _numForwardedLoads = 0;
+    std::uint64_t _numROBFullStalls = 0;
+    std::uint64_t _numRSFullStalls = 0;
+    std::uint64_t _numLSQFullStalls = 0;
+
+  public:
+
+    void printPVS() {
+      printf("==================== Cycle %lu ====================\n", _currCycle);
+      printf("PC = 0x%08lx\n", _PC.to_ulong());
+      printf("Registers:\n");
+      _registerFile->printRegisters();
+      printf("Data Memory:\n");
+      _dataMemory->printMemory();
+      printf("Instruction Memory:\n");
+      _instMemory->printMemory();
+      printf("Fetch Queue:\n");
+      for (size_t i = 0; i < _fetchQueue.size(); i++) {
+        printf("  [%lu] pc = 0x%08lx, instruction = 0x%08lx\n", (unsigned long)i,
+               (unsigned long)_fetchQueue[i].pc, (unsigned long)_fetchQueue[i].instruction);
+      }
+      printf("Register Alias Table:\n");
+      for (size_t i = 0; i < 32; i++) {
+        if (_rat[i] >= 0) {
+          printf("  $%02lu -> ROB[%d]\n", (unsigned long)i, _rat[i]);
+        }
+      }
+      printf("Reservation Stations:\n");
+      for (size_t i = 0; i < _rs.size(); i++) {
+        if (_rs[i].busy) {
+          printf("  RS[%lu]: ROB[%lu] aluOp = 0b%s, funct = 0b%s, Vj = 0x%08lx, Vk = 0x%08lx, Qj = %d, Qk = %d\n",
+                 (unsigned long)i, (unsigned long)_rs[i].robIdx,
+                 _rs[i].aluOp.to_string().c_str(), _rs[i].funct.to_string().c_str(),
+                 (unsigned long)_rs[i].vj, (unsigned long)_rs[i].vk, _rs[i].qj, _rs[i].qk);
+        }
+      }
+      printf("Reorder Buffer:\n");
+      for (size_t n = 0; n < _robCount; n++) {
+        size_t i = (_robHead + n) % _rob.size();
+        printf("  ROB[%lu]: pc = 0x%08lx, instruction = 0x%08lx, dest = %d, value = 0x%08lx, done = %d\n",
+               (unsigned long)i, (unsigned long)_rob[i].pc, (unsigned long)_rob[i].instruction,
+               _rob[i].destReg, (unsigned long)_rob[i].value, _rob[i].done ? 1 : 0);
+      }
+      printf("Load/Store Queue:\n");
+      for (size_t n = 0; n < _lsqCount; n++) {
+        size_t i = (_lsqHead + n) % _lsq.size();
+        printf("  LSQ[%lu]: ROB[%lu] %s, address = 0x%08lx%s, data = 0x%08lx\n",
+               (unsigned long)i, (unsigned long)_lsq[i].robIdx, _lsq[i].isStore ? "sw" : "lw",
+               (unsigned long)_lsq[i].address, _lsq[i].addrReady ? "" : " (unknown)",
+               (unsigned long)_lsq[i].data);
+      }
+    }
+
+    void printStats() {
+      printf("Pipeline Statistics:\n");
+      printf("  cycles             = %lu\n", (unsigned long)_currCycle);
+      printf("  retired            = %lu\n", (unsigned long)_numRetired);
+      printf("  CPI                = %.3f\n",
+             _numRetired == 0 ? 0.0 : (double)_currCycle / (double)_numRetired);
+      printf("Out-of-Order Statistics (width %lu, ROB %lu, RS %lu, LSQ %lu):\n",
+             (unsigned long)_width, (unsigned long)_rob.size(),
+             (unsigned long)_rs.size(), (unsigned long)_lsq.size());
+      printf("  flushes            = %lu\n", (unsigned long)_numFlushes);
+      printf("  forwardedLoads     = %lu\n", (unsigned long)_numForwardedLoads);
+      printf("  robFullStalls      = %lu\n", (unsigned long)_numROBFullStalls);
+      printf("  rsFullStalls       = %lu\n", (unsigned long)_numRSFullStalls);
+      printf("  lsqFullStalls      = %lu\n", (unsigned long)_numLSQFullStalls);
+    }
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef __OUTPUT_RECORD_H__
+#define __OUTPUT_RECORD_H__
+
+#include "SimulatorNamespace.h"
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+// OutputRecord
+//   - a snapshot of the state to be printed, as a flat sequence of 32-bit
+//     words; the component that captures a record also knows how to format
+//     it, so the text can be produced later (and on another thread)
+typedef std::vector<std::uint32_t> OutputRecord;
+
+class OutputRecordReader {
+
+  public:
+
+    OutputRecordReader(const std::uint32_t *words) {
+      _words = words;
+    }
+
+    std::uint32_t get() {
+      return *_words++;
+    }
+
+    std::uint64_t get64() {
+      std::uint64_t lo = get();
+      std::uint64_t hi = get();
+      return (hi << 32) | lo;
+    }
+
+  private:
+
+    const std::uint32_t *_words;
+
+};
+
+inline void put64(OutputRecord &record, std::uint64_t value) {
+  record.push_back((std::uint32_t)value);
+  record.push_back((std::uint32_t)(value >> 32));
+}
+
+// void appendf()
+//   - printf() into the end of 'out'
+inline void appendf(std::string &out, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (n >= (int)sizeof(buffer)) {
+    std::vector<char> large(n + 1);
+    va_start(args, format);
+    vsnprintf(large.data(), large.size(), format, args);
+    va_end(args);
+    out.append(large.data(), n);
+  } else if (n > 0) {
+    out.append(buffer, n);
+  }
+}
+
+// void appendBinary()
+//   - appends the 'width' low bits of 'value', in the same form as
+//     std::bitset<width>::to_string()
+inline void appendBinary(std::string &out, std::uint32_t value, size_t width) {
+  for (size_t b = width; b > 0; b--) {
+    out += (char)('0' + ((value >> (b - 1)) & 1));
+  }
+}
+
+SIMULATOR_NAMESPACE_END
+
+#endif
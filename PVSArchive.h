@@ -0,0 +1,438 @@
+#ifndef __PVS_ARCHIVE_H__
+#define __PVS_ARCHIVE_H__
+
+#include "OutputRecord.h"
+#include "PVSLayout.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef PVS_ARCHIVE_KEYFRAME_CYCLES
+#define PVS_ARCHIVE_KEYFRAME_CYCLES 1024 // <-- the records of a chunk: a keyframe and the deltas after it
+#endif
+
+#ifndef PVS_ARCHIVE_COMPRESSION
+#define PVS_ARCHIVE_COMPRESSION 6 // <-- the zlib level each chunk is compressed with (1 to 9)
+#endif
+
+// PVSArchive
+//   - a file of PVS records (see PipelinedCPU::_capturePVS()) that can be
+//     read back at any cycle without going through the ones before it:
+//       header: "PVSARC01", the keyframe interval, and the PVSLayout
+//       chunks: each one compressed on its own, and holding a keyframe (a
+//               whole record) followed by the deltas of the next records
+//       index:  the first and the last cycle, the file offset, and the sizes
+//               of every chunk
+//       footer: the offset of the index, the number of chunks, "PVSIDX01"
+//   - a delta holds the runs of words that differ from the record before
+//     it; a record of another length (e.g., a word of memory written for
+//     the first time) is stored whole
+//   - the integers in the header, the index, and the footer are little
+//     endian; in a chunk, the counts are LEB128 and the words are 32-bit
+//     little endian
+//   - reading a cycle takes a search of the index and the decoding of one
+//     chunk, whatever the length of the run
+namespace PVSArchive {
+
+  static const char HeaderMagic[] = "PVSARC01";
+  static const char FooterMagic[] = "PVSIDX01";
+  static const size_t MagicSize = 8;
+  static const size_t IndexEntrySize = 8 + 8 + 8 + 4 + 4 + 4;
+  static const size_t FooterSize = 8 + 8 + MagicSize;
+
+  typedef struct {
+    std::uint64_t firstCycle;
+    std::uint64_t lastCycle;
+    std::uint64_t offset; // of the compressed chunk in the file
+    std::uint32_t compressedSize;
+    std::uint32_t rawSize;
+    std::uint32_t numRecords;
+  } IndexEntry_t;
+
+  inline std::uint64_t cycleOf(const OutputRecord &record) {
+    assert(record.size() >= 2);
+    return ((std::uint64_t)record[1] << 32) | record[0];
+  }
+
+  inline void putVarint(std::string &out, std::uint32_t value) {
+    while (value >= 0x80) {
+      out += (char)((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    out += (char)value;
+  }
+
+  inline bool getVarint(const std::string &data, size_t &pos, std::uint32_t &value) {
+    value = 0;
+    for (size_t shift = 0; shift < 35; shift += 7) {
+      if (pos >= data.size()) {
+        return false;
+      }
+      const unsigned char byte = (unsigned char)data[pos++];
+      value |= (std::uint32_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+}
+
+class PVSArchiveWriter {
+
+  public:
+
+    // PVSArchiveWriter::PVSArchiveWriter()
+    //   - starts an archive of the records printed with 'layout'; a chunk
+    //     is closed every 'keyframeInterval' records
+    PVSArchiveWriter(const char *fileName, const PVSLayout &layout,
+                     const size_t keyframeInterval = PVS_ARCHIVE_KEYFRAME_CYCLES) {
+      assert(keyframeInterval > 0);
+      _file = fopen(fileName, "wb");
+      if (_file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open '%s'\n", __func__, fileName);
+        assert(false);
+      }
+      _keyframeInterval = keyframeInterval;
+      std::string layoutData;
+      layout.save(layoutData);
+      std::string header(PVSArchive::HeaderMagic, PVSArchive::MagicSize);
+      PVSLayout::put32(header, _keyframeInterval);
+      PVSLayout::put32(header, layoutData.size());
+      header += layoutData;
+      _write(header);
+    }
+
+    ~PVSArchiveWriter() {
+      _flushChunk();
+      std::string index;
+      for (const PVSArchive::IndexEntry_t &entry : _index) {
+        PVSLayout::put64(index, entry.firstCycle);
+        PVSLayout::put64(index, entry.lastCycle);
+        PVSLayout::put64(index, entry.offset);
+        PVSLayout::put32(index, entry.compressedSize);
+        PVSLayout::put32(index, entry.rawSize);
+        PVSLayout::put32(index, entry.numRecords);
+      }
+      PVSLayout::put64(index, _offset);
+      PVSLayout::put64(index, _index.size());
+      index.append(PVSArchive::FooterMagic, PVSArchive::MagicSize);
+      _write(index);
+      fclose(_file);
+    }
+
+    // void PVSArchiveWriter::append()
+    //   - adds the record of a cycle after the last one appended
+    void append(const OutputRecord &record) {
+      const std::uint64_t cycle = PVSArchive::cycleOf(record);
+      if (_numRecords > 0 && cycle <= _lastCycle) {
+        fprintf(stderr, "[%s] ERROR: cycle %lu is appended after cycle %lu\n", __func__,
+                (unsigned long)cycle, (unsigned long)_lastCycle);
+        assert(false);
+      }
+      if (_chunkRecords == _keyframeInterval) {
+        _flushChunk();
+      }
+      if (_chunkRecords == 0 || record.size() != _previous.size()) {
+        // a keyframe, or a record that cannot be a delta: the tag is even
+        PVSArchive::putVarint(_chunk, 2 * record.size());
+        for (const std::uint32_t word : record) {
+          PVSLayout::put32(_chunk, word);
+        }
+        _numWholeRecords += 1;
+      } else {
+        _appendDelta(record);
+      }
+      if (_chunkRecords == 0) {
+        _chunkFirstCycle = cycle;
+      }
+      _chunkRecords += 1;
+      _lastCycle = cycle;
+      _numRecords += 1;
+      _numRawBytes += 4 * record.size();
+      _previous = record;
+    }
+
+    // void PVSArchiveWriter::printStats()
+    //   - closes the chunk being filled first, so the sizes are those of the
+    //     file (but for the index); a record appended later starts a chunk
+    void printStats() {
+      _flushChunk();
+      printf("PVS Archive Statistics (keyframe every %lu records):\n", (unsigned long)_keyframeInterval);
+      printf("  records            = %lu\n", (unsigned long)_numRecords);
+      printf("  wholeRecords       = %lu\n", (unsigned long)_numWholeRecords);
+      printf("  chunks             = %lu\n", (unsigned long)_index.size());
+      printf("  rawBytes           = %lu\n", (unsigned long)_numRawBytes);
+      printf("  archivedBytes      = %lu\n", (unsigned long)_offset);
+    }
+
+  private:
+
+    // a delta: the tag (odd) counts the runs; each run is the number of
+    // words unchanged since the last one, its length, and its words
+    void _appendDelta(const OutputRecord &record) {
+      std::string runs;
+      std::uint32_t numRuns = 0;
+      size_t end = 0; // where the last run ended
+      for (size_t i = 0; i < record.size(); ) {
+        if (record[i] == _previous[i]) {
+          i++;
+          continue;
+        }
+        size_t j = i;
+        while (j < record.size() && record[j] != _previous[j]) {
+          j++;
+        }
+        PVSArchive::putVarint(runs, i - end);
+        PVSArchive::putVarint(runs, j - i);
+        for (size_t k = i; k < j; k++) {
+          PVSLayout::put32(runs, record[k]);
+        }
+        numRuns += 1;
+        end = i = j;
+      }
+      PVSArchive::putVarint(_chunk, 2 * numRuns + 1);
+      _chunk += runs;
+    }
+
+    void _flushChunk() {
+      if (_chunkRecords == 0) {
+        return;
+      }
+      uLongf compressedSize = compressBound(_chunk.size());
+      std::vector<Bytef> compressed(compressedSize);
+      if (compress2(compressed.data(), &compressedSize, (const Bytef *)_chunk.data(), _chunk.size(),
+                    PVS_ARCHIVE_COMPRESSION) != Z_OK) {
+        fprintf(stderr, "[%s] ERROR: cannot compress the chunk of cycle %lu\n", __func__,
+                (unsigned long)_chunkFirstCycle);
+        assert(false);
+      }
+      PVSArchive::IndexEntry_t entry = {
+        _chunkFirstCycle, _lastCycle, _offset,
+        (std::uint32_t)compressedSize, (std::uint32_t)_chunk.size(), (std::uint32_t)_chunkRecords
+      };
+      _index.push_back(entry);
+      _write(std::string((const char *)compressed.data(), compressedSize));
+      _chunk.clear();
+      _chunkRecords = 0;
+    }
+
+    void _write(const std::string &data) {
+      if (fwrite(data.data(), 1, data.size(), _file) != data.size()) {
+        fprintf(stderr, "[%s] ERROR: cannot write the archive\n", __func__);
+        assert(false);
+      }
+      _offset += data.size();
+    }
+
+    FILE *_file;
+    std::uint64_t _offset = 0; // the bytes written so far
+    size_t _keyframeInterval;
+    std::vector<PVSArchive::IndexEntry_t> _index; // the chunks written so far
+
+    std::string _chunk; // the chunk being filled, uncompressed
+    size_t _chunkRecords = 0;
+    std::uint64_t _chunkFirstCycle = 0;
+    std::uint64_t _lastCycle = 0;
+    OutputRecord _previous; // the record last appended, which the next delta is against
+
+    // Statistics
+    std::uint64_t _numRecords = 0;
+    std::uint64_t _numWholeRecords = 0; // the keyframes, and the records of a new length
+    std::uint64_t _numRawBytes = 0; // the records, as captured
+
+};
+
+class PVSArchiveReader {
+
+  public:
+
+    // bool PVSArchiveReader::open()
+    //   - reads the header and the index of the archive 'fileName'; false
+    //     (with the reason on stderr) if it is not one
+    bool open(const char *fileName) {
+      _file = fopen(fileName, "rb");
+      if (_file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open '%s'\n", __func__, fileName);
+        return false;
+      }
+      std::string header;
+      size_t pos = PVSArchive::MagicSize;
+      std::uint32_t keyframeInterval, layoutSize;
+      if (!_read(0, PVSArchive::MagicSize + 8, header)
+          || header.compare(0, PVSArchive::MagicSize, PVSArchive::HeaderMagic) != 0
+          || !PVSLayout::get32(header, pos, keyframeInterval)
+          || !PVSLayout::get32(header, pos, layoutSize)) {
+        fprintf(stderr, "[%s] ERROR: '%s' is not a PVS archive\n", __func__, fileName);
+        return false;
+      }
+      _keyframeInterval = keyframeInterval;
+      std::string layoutData;
+      if (!_read(pos, layoutSize, layoutData) || !_layout.load(layoutData)) {
+        fprintf(stderr, "[%s] ERROR: '%s' has a bad layout\n", __func__, fileName);
+        return false;
+      }
+
+      std::string footer;
+      std::uint64_t indexOffset, numChunks;
+      if (fseek(_file, 0, SEEK_END) != 0) {
+        return false;
+      }
+      const long fileSize = ftell(_file);
+      pos = 0;
+      if (fileSize < (long)PVSArchive::FooterSize
+          || !_read(fileSize - PVSArchive::FooterSize, PVSArchive::FooterSize, footer)
+          || !PVSLayout::get64(footer, pos, indexOffset) || !PVSLayout::get64(footer, pos, numChunks)
+          || footer.compare(pos, PVSArchive::MagicSize, PVSArchive::FooterMagic) != 0
+          || indexOffset + numChunks * PVSArchive::IndexEntrySize + PVSArchive::FooterSize != (std::uint64_t)fileSize) {
+        fprintf(stderr, "[%s] ERROR: '%s' has no index (was the run cut short?)\n", __func__, fileName);
+        return false;
+      }
+      std::string index;
+      if (!_read(indexOffset, numChunks * PVSArchive::IndexEntrySize, index)) {
+        return false;
+      }
+      pos = 0;
+      _index.resize(numChunks);
+      for (PVSArchive::IndexEntry_t &entry : _index) {
+        PVSLayout::get64(index, pos, entry.firstCycle);
+        PVSLayout::get64(index, pos, entry.lastCycle);
+        PVSLayout::get64(index, pos, entry.offset);
+        PVSLayout::get32(index, pos, entry.compressedSize);
+        PVSLayout::get32(index, pos, entry.rawSize);
+        PVSLayout::get32(index, pos, entry.numRecords);
+      }
+      return true;
+    }
+
+    ~PVSArchiveReader() {
+      if (_file != NULL) {
+        fclose(_file);
+      }
+    }
+
+    const PVSLayout &getLayout() const {
+      return _layout;
+    }
+
+    size_t getKeyframeInterval() const {
+      return _keyframeInterval;
+    }
+
+    const std::vector<PVSArchive::IndexEntry_t> &getIndex() const {
+      return _index;
+    }
+
+    // bool PVSArchiveReader::read()
+    //   - the record of 'cycle'; false if the archive has none
+    //   - the chunk last decoded is kept, so reading the cycles of a range in
+    //     order decodes each chunk once
+    bool read(const std::uint64_t cycle, OutputRecord &record) {
+      // the first chunk that ends at or after 'cycle'
+      auto it = std::lower_bound(_index.begin(), _index.end(), cycle,
+        [](const PVSArchive::IndexEntry_t &entry, std::uint64_t c) { return entry.lastCycle < c; });
+      if (it == _index.end() || it->firstCycle > cycle) {
+        return false;
+      }
+      const size_t chunk = it - _index.begin();
+      if (chunk != _cachedChunk && !_decodeChunk(chunk)) {
+        return false;
+      }
+      auto rit = std::lower_bound(_records.begin(), _records.end(), cycle,
+        [](const OutputRecord &r, std::uint64_t c) { return PVSArchive::cycleOf(r) < c; });
+      if (rit == _records.end() || PVSArchive::cycleOf(*rit) != cycle) {
+        return false;
+      }
+      record = *rit;
+      return true;
+    }
+
+  private:
+
+    bool _read(const std::uint64_t offset, const std::uint64_t size, std::string &data) {
+      data.resize(size);
+      if (fseek(_file, (long)offset, SEEK_SET) != 0
+          || fread(&data[0], 1, size, _file) != size) {
+        return false;
+      }
+      return true;
+    }
+
+    bool _decodeChunk(const size_t chunk) {
+      const PVSArchive::IndexEntry_t &entry = _index[chunk];
+      std::string compressed;
+      std::string raw(entry.rawSize, '\0');
+      uLongf rawSize = entry.rawSize;
+      _cachedChunk = SIZE_MAX;
+      if (!_read(entry.offset, entry.compressedSize, compressed)
+          || uncompress((Bytef *)&raw[0], &rawSize, (const Bytef *)compressed.data(), compressed.size()) != Z_OK
+          || rawSize != entry.rawSize || !_parseChunk(raw, entry.numRecords)) {
+        fprintf(stderr, "[%s] ERROR: the chunk of cycle %lu is corrupt\n", __func__,
+                (unsigned long)entry.firstCycle);
+        return false;
+      }
+      _cachedChunk = chunk;
+      return true;
+    }
+
+    // the records of the uncompressed chunk 'raw', into '_records'
+    bool _parseChunk(const std::string &raw, const std::uint32_t numRecords) {
+      _records.assign(numRecords, OutputRecord());
+      size_t pos = 0;
+      for (std::uint32_t r = 0; r < numRecords; r++) {
+        OutputRecord &record = _records[r];
+        std::uint32_t tag;
+        if (!PVSArchive::getVarint(raw, pos, tag) || (r == 0 && (tag & 1) != 0)) {
+          return false;
+        }
+        if ((tag & 1) == 0) {
+          record.resize(tag / 2);
+          for (std::uint32_t &word : record) {
+            if (!PVSLayout::get32(raw, pos, word)) {
+              return false;
+            }
+          }
+          continue;
+        }
+        record = _records[r - 1];
+        size_t end = 0;
+        for (std::uint32_t run = 0; run < tag / 2; run++) {
+          std::uint32_t gap, length;
+          if (!PVSArchive::getVarint(raw, pos, gap) || !PVSArchive::getVarint(raw, pos, length)
+              || end + gap + length > record.size()) {
+            return false;
+          }
+          end += gap;
+          for (std::uint32_t k = 0; k < length; k++) {
+            if (!PVSLayout::get32(raw, pos, record[end++])) {
+              return false;
+            }
+          }
+        }
+      }
+      return pos == raw.size();
+    }
+
+    FILE *_file = NULL;
+    size_t _keyframeInterval = 0;
+    PVSLayout _layout;
+    std::vector<PVSArchive::IndexEntry_t> _index;
+    size_t _cachedChunk = SIZE_MAX; // the chunk '_records' holds
+    std::vector<OutputRecord> _records;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
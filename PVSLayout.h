@@ -0,0 +1,210 @@
+#ifndef __PVS_LAYOUT_H__
+#define __PVS_LAYOUT_H__
+
+#include "OutputRecord.h"
+#include "RegisterFile.h"
+#include "Memory.h"
+#include "MulDivUnit.h"
+#include "StoreBuffer.h"
+#include "SimulatorNamespace.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+// PVSLayout
+//   - how a record of the program-visible state (PVS) is printed: the items
+//     of the record in the order they were captured, each with the text that
+//     goes before it
+//   - the layout depends on the configuration the simulator was built with,
+//     so it is saved along with the records (see PVSArchive) and anything
+//     that reads them back prints them exactly as printPVS() did
+class PVSLayout {
+
+  public:
+
+    enum Kind {
+      CycleHeader, // the 64-bit cycle, printed as the banner of the cycle
+      Literal, // text alone; takes nothing from the record
+      ProgramCounter,
+      RegisterValues, // see RegisterFile::captureRegisters()
+      HILOValues, // see MulDivUnit::captureHILO()
+      MemoryWords, // see PVSLayout::captureMemory()
+      StoreBufferEntries, // see StoreBuffer::captureStoreBuffer()
+      Field, // a latch field, in binary or in hexadecimal
+      NumKinds
+    };
+
+    void add(const Kind kind, const std::string &text = "") {
+      Item_t item = { kind, text, 0 };
+      _items.push_back(item);
+    }
+
+    // void PVSLayout::addField()
+    //   - a latch field after 'text', printed as 'width' bits, or as eight
+    //     hexadecimal digits if 'width' is 0
+    void addField(const std::string &text, const size_t width) {
+      Item_t item = { Field, text, (std::uint32_t)width };
+      _items.push_back(item);
+    }
+
+    size_t size() const {
+      return _items.size();
+    }
+
+    // void PVSLayout::format()
+    //   - appends the text of the record at 'reader' to 'out'; it touches
+    //     nothing but the record and the layout, so it may run on another
+    //     thread
+    void format(OutputRecordReader &reader, std::string &out) const {
+      for (const Item_t &item : _items) {
+        out += item.text;
+        switch (item.kind) {
+          case CycleHeader:
+            appendf(out, "==================== Cycle %lu ====================\n", (unsigned long)reader.get64());
+            break;
+          case ProgramCounter:
+            appendf(out, "PC = 0x%08lx\n", (unsigned long)reader.get());
+            break;
+          case RegisterValues:
+            RegisterFile::formatRegisters(reader, out);
+            break;
+          case HILOValues:
+            MulDivUnit::formatHILO(reader, out);
+            break;
+          case MemoryWords:
+            formatMemory(reader, out);
+            break;
+          case StoreBufferEntries:
+            StoreBuffer::formatStoreBuffer(reader, out);
+            break;
+          case Field:
+            if (item.width > 0) {
+              appendBinary(out, reader.get(), item.width);
+            } else {
+              appendf(out, "%08lx", (unsigned long)reader.get());
+            }
+            out += '\n';
+            break;
+          default:
+            break;
+        }
+      }
+    }
+
+    // void PVSLayout::save()
+    //   - appends the layout to 'out' as a sequence of items, each one a
+    //     kind byte, a 32-bit width, a 32-bit text length, and the text
+    void save(std::string &out) const {
+      put32(out, _items.size());
+      for (const Item_t &item : _items) {
+        out += (char)item.kind;
+        put32(out, item.width);
+        put32(out, item.text.size());
+        out += item.text;
+      }
+    }
+
+    // bool PVSLayout::load()
+    //   - replaces the layout with the one save() put in 'data'; false if
+    //     'data' is not one
+    bool load(const std::string &data) {
+      _items.clear();
+      size_t pos = 0;
+      std::uint32_t numItems;
+      if (!get32(data, pos, numItems)) {
+        return false;
+      }
+      for (std::uint32_t i = 0; i < numItems; i++) {
+        Item_t item;
+        std::uint32_t length;
+        if (pos >= data.size() || (unsigned char)data[pos] >= NumKinds) {
+          return false;
+        }
+        item.kind = (Kind)(unsigned char)data[pos++];
+        if (!get32(data, pos, item.width) || !get32(data, pos, length) || data.size() - pos < length) {
+          return false;
+        }
+        item.text = data.substr(pos, length);
+        pos += length;
+        _items.push_back(item);
+      }
+      return pos == data.size();
+    }
+
+    // void PVSLayout::captureMemory()
+    //   - appends the non-zero words of 'memory' to 'record', to be printed
+    //     later by formatMemory() exactly as Memory::printMemory() would
+    //     print them now
+    static void captureMemory(const Memory &memory, OutputRecord &record) {
+      const size_t countIndex = record.size();
+      record.push_back(0);
+      memory.forEachLoadedWord([&record, countIndex](std::uint32_t i, std::uint32_t value) {
+        if (value != 0) {
+          record.push_back(i);
+          record.push_back(value);
+          record[countIndex] += 1;
+        }
+      });
+    }
+
+    static void formatMemory(OutputRecordReader &reader, std::string &out) {
+      std::uint32_t count = reader.get();
+      for (std::uint32_t j = 0; j < count; j++) {
+        std::uint32_t i = reader.get();
+        std::uint32_t value = reader.get();
+        appendf(out, "  memory[0x%08lx..0x%08lx] = 0x%08lx\n", (unsigned long)(i + 3),
+                (unsigned long)i, (unsigned long)value);
+      }
+    }
+
+    // little-endian integers in a byte string, for the files that hold
+    // the layout
+    static void put32(std::string &out, const std::uint32_t value) {
+      for (size_t b = 0; b < 4; b++) {
+        out += (char)(value >> (8 * b));
+      }
+    }
+
+    static void put64(std::string &out, const std::uint64_t value) {
+      put32(out, (std::uint32_t)value);
+      put32(out, (std::uint32_t)(value >> 32));
+    }
+
+    static bool get32(const std::string &data, size_t &pos, std::uint32_t &value) {
+      if (data.size() < 4 || pos > data.size() - 4) {
+        return false;
+      }
+      value = 0;
+      for (size_t b = 0; b < 4; b++) {
+        value |= (std::uint32_t)(unsigned char)data[pos++] << (8 * b);
+      }
+      return true;
+    }
+
+    static bool get64(const std::string &data, size_t &pos, std::uint64_t &value) {
+      std::uint32_t lo, hi;
+      if (!get32(data, pos, lo) || !get32(data, pos, hi)) {
+        return false;
+      }
+      value = ((std::uint64_t)hi << 32) | lo;
+      return true;
+    }
+
+  private:
+
+    typedef struct {
+      Kind kind;
+      std::string text; // printed before the item
+      std::uint32_t width; // the bits of a binary field; 0 for anything else
+    } Item_t;
+
+    std::vector<Item_t> _items;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef __PIPE_VIEW_H__
+#define __PIPE_VIEW_H__
+
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef PIPEVIEW_WINDOW_CYCLES
+#define PIPEVIEW_WINDOW_CYCLES 40 // <-- the cycles of the pipeline diagram printed at the end of a run, by default
+#endif
+
+// PipeView
+//   - the timeline of every instruction through the pipeline: the cycle it
+//     entered each stage, the cycles it stalled, and whether it retired or
+//     was squashed
+//   - the records are written to a file, one line per instruction, in the
+//     order the instructions leave the pipeline:
+//       seq pc instruction IF ID EX MEM WB last stalls status
+//     where a stage the instruction never entered is '-', 'last' is the last
+//     cycle it spent in the pipeline, 'stalls' the cycles it spent in its
+//     stages beyond their depth, and 'status' R (retired), S (squashed), or
+//     - (still in flight when the file was closed)
+//   - render() draws the classic pipeline diagram of records for a window of
+//     cycles; the records in the window given to the constructor are kept
+//     for printWindow()
+class PipeView {
+
+  public:
+
+    enum Stage { IF, ID, EX, MEM, WB, NumStages };
+
+    typedef struct {
+      std::uint64_t seq; // the order of the fetch, from 1
+      std::uint32_t pc;
+      std::uint32_t instruction;
+      std::uint64_t stageCycles[NumStages]; // the cycle the instruction entered each stage, 0 if it never did
+      std::uint64_t lastCycle; // the last cycle the instruction spent in the pipeline
+      std::uint64_t numStallCycles;
+      char status; // 'R', 'S', or '-'
+    } Record_t;
+
+    // PipeView::PipeView()
+    //   - 'numIFStages' and 'numMEMStages' are the depths of IF and MEM, i.e.,
+    //     the cycles an instruction spends there without a stall
+    PipeView(const char *fileName, const size_t numIFStages, const size_t numMEMStages,
+             const std::uint64_t windowStart = 1,
+             const std::uint64_t windowEnd = PIPEVIEW_WINDOW_CYCLES) {
+      _file = fopen(fileName, "w");
+      if (_file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open '%s'\n", __func__, fileName);
+        assert(false);
+      }
+      fprintf(_file, "# pipeview %lu %lu\n", (unsigned long)numIFStages, (unsigned long)numMEMStages);
+      fprintf(_file, "# seq pc instruction IF ID EX MEM WB last stalls status\n");
+      _numIFStages = numIFStages;
+      _numMEMStages = numMEMStages;
+      _windowStart = windowStart;
+      _windowEnd = windowEnd;
+      _numFetched = 0;
+    }
+
+    ~PipeView() {
+      drain();
+      fclose(_file);
+    }
+
+    // std::uint32_t PipeView::fetch()
+    //   - starts the record of the instruction at 'pc' fetched in 'cycle',
+    //     and returns the sequence number it is tagged with in the latches
+    //     (the low 32 bits of its 'seq'; far more than the instructions in
+    //     flight, so they tell them apart)
+    std::uint32_t fetch(const std::uint32_t pc, const std::uint32_t instruction, const std::uint64_t cycle) {
+      _numFetched += 1;
+      Record_t record = {};
+      record.seq = _numFetched;
+      record.pc = pc;
+      record.instruction = instruction;
+      record.stageCycles[IF] = cycle;
+      record.lastCycle = cycle;
+      record.status = '-';
+      _inFlight[(std::uint32_t)record.seq] = record;
+      return (std::uint32_t)record.seq;
+    }
+
+    // void PipeView::occupy()
+    //   - the instruction tagged 'seqNum' spends 'cycle' in 'stage'; an
+    //     instruction fetched before the view was opened is not tracked
+    void occupy(const std::uint32_t seqNum, const Stage stage, const std::uint64_t cycle) {
+      std::map<std::uint32_t, Record_t>::iterator it = _inFlight.find(seqNum);
+      if (it == _inFlight.end()) {
+        return;
+      }
+      if (it->second.stageCycles[stage] == 0) {
+        it->second.stageCycles[stage] = cycle;
+      }
+      it->second.lastCycle = cycle;
+    }
+
+    // void PipeView::retire()
+    //   - the instruction tagged 'seqNum' leaves WB in 'cycle'
+    void retire(const std::uint32_t seqNum, const std::uint64_t cycle) {
+      occupy(seqNum, WB, cycle);
+      _finish(seqNum, 'R');
+    }
+
+    // void PipeView::squash()
+    //   - the instruction tagged 'seqNum' is dropped in 'cycle', which it
+    //     spent in the stage it was last seen in
+    void squash(const std::uint32_t seqNum, const std::uint64_t cycle) {
+      std::map<std::uint32_t, Record_t>::iterator it = _inFlight.find(seqNum);
+      if (it == _inFlight.end()) {
+        return;
+      }
+      it->second.lastCycle = cycle;
+      _finish(seqNum, 'S');
+    }
+
+    // void PipeView::drain()
+    //   - writes the records of the instructions still in flight, e.g., at
+    //     the end of the run, or when the pipeline is reset
+    void drain() {
+      while (!_inFlight.empty()) {
+        _finish(_inFlight.begin()->first, '-');
+      }
+      fflush(_file);
+    }
+
+    // void PipeView::printWindow()
+    //   - draws the diagram of the window given to the constructor
+    void printWindow() {
+      printf("Pipeline Diagram (cycles %lu to %lu):\n", (unsigned long)_windowStart, (unsigned long)_windowEnd);
+      std::vector<Record_t> records = _window;
+      for (const std::pair<const std::uint32_t, Record_t> &entry : _inFlight) {
+        records.push_back(entry.second);
+      }
+      render(stdout, records, _windowStart, _windowEnd, _numIFStages, _numMEMStages);
+    }
+
+    // bool PipeView::isInWindow()
+    //   - true if 'record' spent a cycle in [windowStart, windowEnd]
+    static bool isInWindow(const Record_t &record, const std::uint64_t windowStart, const std::uint64_t windowEnd) {
+      return record.stageCycles[IF] <= windowEnd && record.lastCycle >= windowStart;
+    }
+
+    // void PipeView::render()
+    //   - draws one row per record in the window, in the order of the
+    //     fetches, and one column per cycle: F, D, X, M, and W are the cycles
+    //     in IF, ID, EX, MEM, and WB, in lower case beyond the depth of the
+    //     stage (i.e., stalls); a squashed instruction ends with a '*'
+    static void render(FILE *out, std::vector<Record_t> records,
+                       const std::uint64_t windowStart, const std::uint64_t windowEnd,
+                       const size_t numIFStages, const size_t numMEMStages) {
+      assert(windowStart <= windowEnd);
+      records.erase(std::remove_if(records.begin(), records.end(), [&](const Record_t &record) {
+        return !isInWindow(record, windowStart, windowEnd);
+      }), records.end());
+      std::sort(records.begin(), records.end(), [](const Record_t &a, const Record_t &b) {
+        return a.seq < b.seq;
+      });
+      int width = 1; // the digits of the last cycle, and a space
+      for (std::uint64_t n = windowEnd; n > 0; n /= 10) {
+        width += 1;
+      }
+      width = std::max(width, 3);
+      fprintf(out, "  %8s %8s %8s  ", "seq", "pc", "inst");
+      for (std::uint64_t cycle = windowStart; cycle <= windowEnd; cycle++) {
+        fprintf(out, "%*lu", width, (unsigned long)cycle);
+      }
+      fprintf(out, "\n");
+      static const char letters[NumStages] = { 'F', 'D', 'X', 'M', 'W' };
+      for (const Record_t &record : records) {
+        fprintf(out, "  %8lu %08x %08x  ", (unsigned long)record.seq, record.pc, record.instruction);
+        std::string row;
+        for (std::uint64_t cycle = windowStart; cycle <= windowEnd; cycle++) {
+          char cell = ' ';
+          if (cycle >= record.stageCycles[IF] && cycle <= record.lastCycle) {
+            for (int s = NumStages - 1; s >= 0; s--) {
+              if (record.stageCycles[s] != 0 && cycle >= record.stageCycles[s]) {
+                const bool stalled = (cycle - record.stageCycles[s] >= _depthOf((Stage)s, numIFStages, numMEMStages));
+                cell = stalled ? (char)(letters[s] - 'A' + 'a') : letters[s];
+                break;
+              }
+            }
+          } else if (record.status == 'S' && cycle == record.lastCycle + 1) {
+            cell = '*';
+          }
+          row.append(width - 1, ' ');
+          row.push_back(cell);
+        }
+        row.erase(row.find_last_not_of(' ') + 1);
+        fprintf(out, "%s\n", row.c_str());
+      }
+    }
+
+    // bool PipeView::parseHeader()
+    //   - reads the depths of IF and MEM back from the first line of the file
+    static bool parseHeader(const char *line, size_t &numIFStages, size_t &numMEMStages) {
+      unsigned long numIF = 0, numMEM = 0;
+      if (sscanf(line, "# pipeview %lu %lu", &numIF, &numMEM) != 2 || numIF == 0 || numMEM == 0) {
+        return false;
+      }
+      numIFStages = numIF;
+      numMEMStages = numMEM;
+      return true;
+    }
+
+    // bool PipeView::parse()
+    //   - reads a record back from a line of the file; false for the header
+    //     and for a malformed line
+    static bool parse(const char *line, Record_t &record) {
+      if (line[0] == '#') {
+        return false;
+      }
+      char fields[11][24];
+      if (sscanf(line, "%23s %23s %23s %23s %23s %23s %23s %23s %23s %23s %23s",
+                 fields[0], fields[1], fields[2], fields[3], fields[4], fields[5],
+                 fields[6], fields[7], fields[8], fields[9], fields[10]) != 11) {
+        return false;
+      }
+      record = Record_t();
+      record.seq = strtoull(fields[0], nullptr, 10);
+      record.pc = (std::uint32_t)strtoul(fields[1], nullptr, 16);
+      record.instruction = (std::uint32_t)strtoul(fields[2], nullptr, 16);
+      for (size_t s = 0; s < NumStages; s++) {
+        record.stageCycles[s] = (strcmp(fields[3 + s], "-") == 0) ? 0 : strtoull(fields[3 + s], nullptr, 10);
+      }
+      record.lastCycle = strtoull(fields[8], nullptr, 10);
+      record.numStallCycles = strtoull(fields[9], nullptr, 10);
+      record.status = fields[10][0];
+      return record.seq != 0 && record.stageCycles[IF] != 0;
+    }
+
+  private:
+
+    static std::uint64_t _depthOf(const Stage stage, const size_t numIFStages, const size_t numMEMStages) {
+      return stage == IF ? numIFStages : (stage == MEM ? numMEMStages : 1);
+    }
+
+    // writes the record of the instruction tagged 'seqNum' and drops it
+    void _finish(const std::uint32_t seqNum, const char status) {
+      std::map<std::uint32_t, Record_t>::iterator it = _inFlight.find(seqNum);
+      assert(it != _inFlight.end());
+      Record_t &record = it->second;
+      record.status = status;
+      record.numStallCycles = 0;
+      for (size_t s = 0; s < NumStages; s++) {
+        if (record.stageCycles[s] == 0) {
+          continue;
+        }
+        std::uint64_t end = record.lastCycle + 1;
+        for (size_t n = s + 1; n < NumStages; n++) {
+          if (record.stageCycles[n] != 0) {
+            end = record.stageCycles[n];
+            break;
+          }
+        }
+        const std::uint64_t numCycles = end - record.stageCycles[s];
+        const std::uint64_t depth = _depthOf((Stage)s, _numIFStages, _numMEMStages);
+        if (numCycles > depth) {
+          record.numStallCycles += numCycles - depth;
+        }
+      }
+
+      fprintf(_file, "%lu %08x %08x", (unsigned long)record.seq, record.pc, record.instruction);
+      for (size_t s = 0; s < NumStages; s++) {
+        if (record.stageCycles[s] == 0) {
+          fprintf(_file, " -");
+        } else {
+          fprintf(_file, " %lu", (unsigned long)record.stageCycles[s]);
+        }
+      }
+      fprintf(_file, " %lu %lu %c\n", (unsigned long)record.lastCycle,
+              (unsigned long)record.numStallCycles, record.status);
+
+      if (isInWindow(record, _windowStart, _windowEnd)) {
+        _window.push_back(record);
+      }
+      _inFlight.erase(it);
+    }
+
+    FILE *_file;
+    size_t _numIFStages; // the cycles in IF without a stall
+    size_t _numMEMStages; // the cycles in MEM without a stall
+    std::uint64_t _windowStart;
+    std::uint64_t _windowEnd;
+    std::uint64_t _numFetched;
+    std::map<std::uint32_t, Record_t> _inFlight; // by the tag in the latches
+    std::vector<Record_t> _window; // the records in [_windowStart, _windowEnd] written so far
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
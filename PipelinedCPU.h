@@ -2,91 +2,345 @@
 #define __PIPELINED_CPU_H__
 
 #include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
 
 #include "Memory.h"
 #include "Control.h"
 #include "RegisterFile.h"
 #include "ALU.h"
 #include "ALUControl.h"
+#include "StoreBuffer.h"
+#ifdef ENABLE_TRACE_DRIVEN
+#include "TraceReader.h"
+#endif
+#include "WireRegistry.h"
+#include "OutputRecord.h"
+#include "PVSLayout.h"
+#ifdef ENABLE_PVS_ARCHIVE
+#include "PVSArchive.h"
+#endif
+#ifdef ENABLE_PROFILER
+#include "Profiler.h"
+#endif
+#ifdef ENABLE_ASYNC_OUTPUT
+#include "AsyncOutputWriter.h"
+#endif
+#ifdef ENABLE_VCD_DUMP
+#include "VCDWriter.h"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#include "StageTeam.h"
+#endif
+#ifdef ENABLE_FETCH_QUEUE
+#include "FetchUnit.h"
+#endif
+#ifdef ENABLE_HOST_PROFILER
+#include "HostProfiler.h"
+#endif
+#ifdef ENABLE_MULT_DIV
+#include "MulDivUnit.h"
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+#include "ClockDomain.h"
+#include "MemoryBridge.h"
+#endif
+#ifdef ENABLE_PREFETCHER
+#include "StridePrefetcher.h"
+#endif
+#ifdef ENABLE_PIPEVIEW
+#include "PipeView.h"
+#endif
+#ifdef ENABLE_JUMPS
+#include "JumpPredictor.h"
+#endif
+#ifdef ENABLE_TIMING_MODEL
+#include "TimingModel.h"
+#endif
+#ifdef ENABLE_MACRO_FUSION
+#include "MacroFusion.h"
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+#include "VirtualMemory.h"
+#endif
 
 #include "Miscellaneous.h"
 
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <string>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef PIPELINE_IF_STAGES
+#define PIPELINE_IF_STAGES 1 // <-- the number of stages an instruction fetch takes (1 to 3)
+#endif
+
+#ifndef PIPELINE_MEM_STAGES
+#define PIPELINE_MEM_STAGES 1 // <-- the number of stages a data memory access takes (1 to 3)
+#endif
+
+#if PIPELINE_IF_STAGES < 1 || PIPELINE_IF_STAGES > 3
+#error "PIPELINE_IF_STAGES must be between 1 and 3"
+#endif
+
+#if PIPELINE_MEM_STAGES < 1 || PIPELINE_MEM_STAGES > 3
+#error "PIPELINE_MEM_STAGES must be between 1 and 3"
+#endif
+
+#if defined(ENABLE_FETCH_QUEUE) && PIPELINE_IF_STAGES != 1
+#error "the fetch queue replaces the IF stages, so PIPELINE_IF_STAGES must be 1"
+#endif
+
+#if defined(ENABLE_FETCH_QUEUE) && defined(ENABLE_TRACE_DRIVEN)
+#error "the fetch queue cannot be used in the trace-driven mode, which fetches from the trace"
+#endif
+
+#ifndef FETCH_BRANCH_DELAY_SLOTS
+#define FETCH_BRANCH_DELAY_SLOTS 2 // <-- the instructions after a taken beq that are executed (as without the fetch queue or multithreading)
+#endif
+
+#define THREAD_POLICY_ROUND_ROBIN 0 // the next thread in turn
+#define THREAD_POLICY_SWITCH_ON_STALL 1 // the same thread until it stalls on a load or takes a branch
+#define THREAD_POLICY_ICOUNT 2 // the thread with the fewest instructions in ID and EX
+
+#ifndef PIPELINE_THREADS
+#define PIPELINE_THREADS 2 // <-- the number of hardware thread contexts with ENABLE_MULTITHREADING (1 to 4)
+#endif
+
+#ifndef THREAD_POLICY
+#define THREAD_POLICY THREAD_POLICY_ROUND_ROBIN // <-- how IF picks the thread it fetches from
+#endif
+
+#ifdef ENABLE_MULTITHREADING
+#if PIPELINE_THREADS < 1 || PIPELINE_THREADS > 4
+#error "PIPELINE_THREADS must be between 1 and 4"
+#endif
+#if THREAD_POLICY < THREAD_POLICY_ROUND_ROBIN || THREAD_POLICY > THREAD_POLICY_ICOUNT
+#error "THREAD_POLICY must be THREAD_POLICY_ROUND_ROBIN, THREAD_POLICY_SWITCH_ON_STALL, or THREAD_POLICY_ICOUNT"
+#endif
+#if PIPELINE_IF_STAGES != 1
+#error "a taken branch redirects the PC of its own thread in a single IF stage, so PIPELINE_IF_STAGES must be 1"
+#endif
+#if defined(ENABLE_FETCH_QUEUE) || defined(ENABLE_TRACE_DRIVEN)
+#error "the multithreading fetches from the instruction memory of each thread, so it cannot be used with the fetch queue or in the trace-driven mode"
+#endif
+#ifdef ENABLE_STORE_BUFFER
+#error "the multithreading cannot be used with the store buffer, which drains into a single data memory"
+#endif
+#ifdef ENABLE_PROFILER
+#error "the multithreading cannot be used with the profiler, which tells instructions apart by their PC alone"
+#endif
+#endif
+
+#ifdef ENABLE_MULT_DIV
+#ifndef ENABLE_HAZARD_DETECTION
+#error "the multiply/divide unit needs ENABLE_HAZARD_DETECTION, which holds the instructions that wait for it"
+#endif
+#ifdef ENABLE_MULTITHREADING
+#error "the multiply/divide unit holds the HI and LO of a single thread, so it cannot be used with the multithreading"
+#endif
+#endif
+
+#ifdef ENABLE_CLOCK_DOMAINS
+#ifdef ENABLE_MULTITHREADING
+#error "the clock domains cannot be used with the multithreading, whose threads each have a data memory"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#error "the clock domains cannot be used with the parallel stages, for the same reason as the store buffer"
+#endif
+#endif
+
+#ifdef ENABLE_PREFETCHER
+#ifdef ENABLE_MULTITHREADING
+#error "the prefetcher cannot be used with the multithreading, whose threads each have a data memory"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#error "the prefetcher cannot be used with the parallel stages, for the same reason as the store buffer"
+#endif
+#endif
+
+#ifdef ENABLE_VIRTUAL_MEMORY
+#ifdef ENABLE_FETCH_QUEUE
+#error "the virtual memory translates the fetch of the IF stage through the iTLB, so it cannot be used with the fetch queue, whose fetch unit fetches ahead of IF on its own"
+#endif
+#ifdef ENABLE_MULTITHREADING
+#error "the virtual memory keeps a single page table, so it cannot be used with the multithreading, whose threads each have an address space"
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+#error "the virtual memory cannot be used in the trace-driven mode, whose traces record the instructions, not the pages they were fetched from"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#error "the virtual memory cannot be used with the parallel stages, for the same reason as the store buffer"
+#endif
+#endif
+
+#ifdef ENABLE_JUMPS
+#ifdef ENABLE_TRACE_DRIVEN
+#error "the jumps cannot be used in the trace-driven mode, whose traces record the targets of the taken beqs only"
+#endif
+#endif
+
+#ifdef ENABLE_JUMP_PREDICTION
+#ifndef ENABLE_JUMPS
+#error "the jump prediction needs ENABLE_JUMPS, which makes j, jal, and jr executable"
+#endif
+#if defined(ENABLE_FETCH_QUEUE) || defined(ENABLE_MULTITHREADING)
+#error "the jump prediction redirects the single-thread fetch of the IF stages, so it cannot be used with the fetch queue or the multithreading"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#error "the jump prediction cannot be used with the parallel stages, as IF clears the predictions that EX and ID pass along"
+#endif
+#endif
+
+#ifdef ENABLE_MACRO_FUSION
+#if PIPELINE_IF_STAGES != 1
+#error "the macro-op fusion has ID look at the word IF is about to fetch, so PIPELINE_IF_STAGES must be 1"
+#endif
+#if defined(ENABLE_FETCH_QUEUE) || defined(ENABLE_MULTITHREADING) || defined(ENABLE_TRACE_DRIVEN)
+#error "the macro-op fusion skips a word in the single-thread fetch from the instruction memory, so it cannot be used with the fetch queue, the multithreading, or in the trace-driven mode"
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+#error "the macro-op fusion cannot be used with the parallel stages, as ID moves the address IF fetches from"
+#endif
+#ifdef ENABLE_PROFILER
+#error "the macro-op fusion cannot be used with the profiler, which follows every instruction by its PC"
+#endif
+#endif
+
+#if defined(ENABLE_PIPEVIEW) && defined(ENABLE_FETCH_QUEUE)
+#error "the pipeline view cannot be used with the fetch queue, which drops the instructions it squashes before they are tagged"
+#endif
+
+#if defined(ENABLE_PARALLEL_STAGES) && defined(ENABLE_STORE_BUFFER)
+#error "the parallel stages cannot be used with the store buffer, whose stall in MEM decides whether EX, ID, and IF run at all"
+#endif
+
+#if defined(ENABLE_PARALLEL_STAGES) && defined(ENABLE_PROFILER)
+#error "the parallel stages cannot be used with the profiler, which every stage updates"
+#endif
+
+#if defined(ENABLE_PARALLEL_STAGES) && defined(ENABLE_HOST_PROFILER)
+#error "the parallel stages cannot be used with the host profiler, which times the stages one after another"
+#endif
+
+#ifdef ENABLE_HOST_PROFILER
+// HOST_PROFILE_SCOPE() times the rest of the enclosing block as a stage, and
+// HOST_PROFILE_ADVANCE() a component's cycle; without the host profiler,
+// they are nothing but the code itself
+#define HOST_PROFILE_SCOPE(name) HostProfiler::Scope hostProfileScope(_hostProfiler, name)
+#define HOST_PROFILE_ADVANCE(component) do { HostProfiler::Scope hostProfileScope(_hostProfiler, component); (component)->advanceCycle(); } while (0)
+#else
+#define HOST_PROFILE_SCOPE(name)
+#define HOST_PROFILE_ADVANCE(component) (component)->advanceCycle()
+#endif
+
 #ifdef ENABLE_DATA_FORWARDING
+// ForwardingUnit<D>
+//   - D is the number of MEM stages; while the consumer is in EX, a producer
+//     at distance d (1 <= d <= D) is in the d-th MEM stage, and its ALU
+//     output is forwarded from that stage's input latch (select = d)
+//   - the producer at distance D+1 is in WB, whose write reaches EX through
+//     the register file (see PipelinedCPU::_wbBypass())
+template<size_t D>
 class ForwardingUnit : public DigitalCircuit {
   public:
     ForwardingUnit(
       const std::string &name,
       const Wire<5> *iIDEXRs,
       const Wire<5> *iIDEXRt,
-      const Wire<1> *iEXMEMRegWrite,
-      const Wire<5> *iEXMEMRegDstIdx,
-      const Wire<1> *iMEMWBRegWrite,
-      const Wire<5> *iMEMWBRegDstIdx,
+      const std::array<const Wire<1> *, D> &iRegWrite,
+      const std::array<const Wire<5> *, D> &iRegDstIdx,
       Wire<2> *oForwardA,
       Wire<2> *oForwardB
     ) : DigitalCircuit(name) {
+      static_assert(D >= 1 && D <= 3, "the forwarding select is 2 bits wide");
       _iIDEXRs = iIDEXRs;
       _iIDEXRt = iIDEXRt;
-      _iEXMEMRegWrite = iEXMEMRegWrite;
-      _iEXMEMRegDstIdx = iEXMEMRegDstIdx;
-      _iMEMWBRegWrite = iMEMWBRegWrite;
-      _iMEMWBRegDstIdx = iMEMWBRegDstIdx;
+      _iRegWrite = iRegWrite;
+      _iRegDstIdx = iRegDstIdx;
       _oForwardA = oForwardA;
       _oForwardB = oForwardB;
     }
     virtual void advanceCycle() {
       *_oForwardA = 0b00;
       *_oForwardB = 0b00;
-      if (_iEXMEMRegWrite->to_ulong() && _iEXMEMRegDstIdx->to_ulong() != 0) {
-        if (_iEXMEMRegDstIdx->to_ulong() == _iIDEXRs->to_ulong()) {
-          *_oForwardA = 0b01;
-        } else if (_iEXMEMRegDstIdx->to_ulong() == _iIDEXRt->to_ulong()) {
-          *_oForwardB = 0b01;
-        }
-      }
-
-      if (_iMEMWBRegWrite->to_ulong() && _iMEMWBRegDstIdx->to_ulong() != 0) {
-        if (_iMEMWBRegDstIdx->to_ulong() == _iIDEXRs->to_ulong()) {
-          *_oForwardA = 0b10;
-        } else if (_iMEMWBRegDstIdx->to_ulong() == _iIDEXRt->to_ulong()) {
-          *_oForwardB = 0b10;
+      // scan from the farthest producer so that the nearest one wins
+      for (size_t d = D; d >= 1; d--) {
+        if (_iRegWrite[d - 1]->to_ulong() && _iRegDstIdx[d - 1]->to_ulong() != 0) {
+          if (_iRegDstIdx[d - 1]->to_ulong() == _iIDEXRs->to_ulong()) {
+            *_oForwardA = d;
+          }
+          if (_iRegDstIdx[d - 1]->to_ulong() == _iIDEXRt->to_ulong()) {
+            *_oForwardB = d;
+          }
         }
       }
     }
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iIDEXRs, _iIDEXRt });
+      inputs.insert(inputs.end(), _iRegWrite.begin(), _iRegWrite.end());
+      inputs.insert(inputs.end(), _iRegDstIdx.begin(), _iRegDstIdx.end());
+      outputs.insert(outputs.end(), { _oForwardA, _oForwardB });
+    }
   private:
     const Wire<5> *_iIDEXRs;
     const Wire<5> *_iIDEXRt;
-    const Wire<1> *_iEXMEMRegWrite;
-    const Wire<5> *_iEXMEMRegDstIdx;
-    const Wire<1> *_iMEMWBRegWrite;
-    const Wire<5> *_iMEMWBRegDstIdx;
+    std::array<const Wire<1> *, D> _iRegWrite;
+    std::array<const Wire<5> *, D> _iRegDstIdx;
     Wire<2> *_oForwardA;
     Wire<2> *_oForwardB;
 };
 
 #ifdef ENABLE_HAZARD_DETECTION
+// HazardDetectionUnit<D>
+//   - loaded data is not forwarded, so it can only be used once the load has
+//     left the last of the D MEM stages; an instruction in ID waits while a
+//     load it depends on is at distance d <= D (in EX, or in MEM1..MEM(D-1))
+//   - the inputs are all latches, so the outputs for a cycle are evaluated
+//     as soon as the latches of the previous one are committed
+//   - with ENABLE_MULT_DIV, the instruction in ID also waits while the
+//     multiply/divide unit says so (see MulDivUnit::checkStall())
+template<size_t D>
 class HazardDetectionUnit : public DigitalCircuit {
   public:
     HazardDetectionUnit(
       const std::string &name,
       const Wire<5> *iIFIDRs,
       const Wire<5> *iIFIDRt,
-      const Wire<1> *iIDEXMemRead,
-      const Wire<5> *iIDEXRt,
+      const std::array<const Wire<1> *, D> &iMemRead,
+      const std::array<const Wire<5> *, D> &iRegDstIdx,
+#ifdef ENABLE_MULT_DIV
+      const Wire<2> *iMulDivStall,
+#endif
       Wire<1> *oPCWrite,
       Wire<1> *oIFIDWrite,
       Wire<1> *oIDEXCtrlWrite
     ) : DigitalCircuit(name) {
       _iIFIDRs = iIFIDRs;
       _iIFIDRt = iIFIDRt;
-      _iIDEXMemRead = iIDEXMemRead;
-      _iIDEXRt = iIDEXRt;
+      _iMemRead = iMemRead;
+      _iRegDstIdx = iRegDstIdx;
+#ifdef ENABLE_MULT_DIV
+      _iMulDivStall = iMulDivStall;
+#endif
       _oPCWrite = oPCWrite;
       _oIFIDWrite = oIFIDWrite;
       _oIDEXCtrlWrite = oIDEXCtrlWrite;
     }
     virtual void advanceCycle() {
-      if (_iIDEXMemRead->to_ulong() && (_iIDEXRt->to_ulong() == _iIFIDRs->to_ulong() || _iIDEXRt->to_ulong() == _iIFIDRt->to_ulong())) {
+      bool stall = false;
+      for (size_t d = 1; d <= D; d++) {
+        if (_iMemRead[d - 1]->to_ulong() && (_iRegDstIdx[d - 1]->to_ulong() == _iIFIDRs->to_ulong() || _iRegDstIdx[d - 1]->to_ulong() == _iIFIDRt->to_ulong())) {
+          stall = true;
+        }
+      }
+#ifdef ENABLE_MULT_DIV
+      if (_iMulDivStall->any()) {
+        stall = true;
+      }
+#endif
+      if (stall) {
         *_oPCWrite = 0;
         *_oIFIDWrite = 0;
         *_oIDEXCtrlWrite = 0;
@@ -96,11 +350,23 @@ class HazardDetectionUnit : public DigitalCircuit {
         *_oIDEXCtrlWrite = 1;
       }
     }
+    virtual void getPorts(std::vector<const void *> &inputs, std::vector<const void *> &outputs) const {
+      inputs.insert(inputs.end(), { _iIFIDRs, _iIFIDRt });
+      inputs.insert(inputs.end(), _iMemRead.begin(), _iMemRead.end());
+      inputs.insert(inputs.end(), _iRegDstIdx.begin(), _iRegDstIdx.end());
+#ifdef ENABLE_MULT_DIV
+      inputs.push_back(_iMulDivStall);
+#endif
+      outputs.insert(outputs.end(), { _oPCWrite, _oIFIDWrite, _oIDEXCtrlWrite });
+    }
   private:
     const Wire<5> *_iIFIDRs;
     const Wire<5> *_iIFIDRt;
-    const Wire<1> *_iIDEXMemRead;
-    const Wire<5> *_iIDEXRt;
+    std::array<const Wire<1> *, D> _iMemRead;
+    std::array<const Wire<5> *, D> _iRegDstIdx;
+#ifdef ENABLE_MULT_DIV
+    const Wire<2> *_iMulDivStall;
+#endif
     Wire<1> *_oPCWrite;
     Wire<1> *_oIFIDWrite;
     Wire<1> *_oIDEXCtrlWrite;
@@ -122,56 +388,128 @@ class PipelinedCPU : public DigitalCircuit {
     ) : DigitalCircuit(name) {
       _currCycle = 0;
       _PC = initialPC;
+#ifdef ENABLE_MULTITHREADING
+      // every thread has its own registers and memories, loaded from the
+      // files listed (comma-separated, one per thread) in each file name
+      const std::vector<std::string> regFileNames = _splitFileNames(regFileName);
+      const std::vector<std::string> instMemFileNames = _splitFileNames(instMemFileName);
+      const std::vector<std::string> dataMemFileNames = _splitFileNames(dataMemFileName);
+      _resetThreads(initialPC);
+#endif
 
       _adderPCPlus4Input1 = 4;
       _adderPCPlus4 = new Adder<32>("adderPCPlus4", &_PC, &_adderPCPlus4Input1, &_pcPlus4);
+      // the PC mux in IF runs before the adder, so it must already see PC+4
+      // in the first cycle, or the first fetch would be from address 0
+      _adderPCPlus4->advanceCycle();
 
       Wire<32> _alwaysLo32 = 0;
+#ifdef ENABLE_TRACE_DRIVEN
+      // the instructions come from the trace, so the instruction memory stays empty
+      _instMemory = new Memory(
+        "InstMemory",
+        &_PC,
+        &_alwaysLo32,
+        &_alwaysHi,
+        &_alwaysLo,
+        &_ifNext(1).instruction,
+        memoryEndianness);
+
+      _traceReader = new TraceReader(
+        "traceReader",
+        instMemFileName,
+        &_tracePC,
+        &_ifNext(1).instruction,
+        &_ifNext(1).traceAddress,
+        &_ifNext(1).traceAddressValid,
+        &_ifNext(1).valid);
+#elif defined(ENABLE_MULTITHREADING)
+      // IF reads the instruction memory of the thread it fetches from
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _threadInstMemories[t] = new Memory(
+          "InstMemory",
+          &_PC,
+          &_alwaysLo32,
+          &_alwaysHi,
+          &_alwaysLo,
+          &_ifNext(1).instruction,
+          memoryEndianness,
+          _fileNameOf(instMemFileNames[t]));
+      }
+      _instMemory = _threadInstMemories[0];
+#else
+      // with the virtual memory, IF reads at the address its iTLB translated
+      // the PC to
       _instMemory = new Memory(
         "InstMemory",
+#ifdef ENABLE_VIRTUAL_MEMORY
+        &_instMemPhysAddress,
+#else
         &_PC,
+#endif
         &_alwaysLo32,
         &_alwaysHi,
         &_alwaysLo,
-        &_latchIFID.instruction,
+        &_ifNext(1).instruction,
         memoryEndianness,
         instMemFileName);
+#endif
+#ifdef ENABLE_FETCH_QUEUE
+      // the fetch unit reads the instruction memory by itself, and the PC is
+      // the address of its next fetch
+      _fetchUnit = new FetchUnit("fetchUnit", _instMemory, &_PC, initialPC + 4);
+#endif
 
       _control = new Control(
         &_opcode,
-        &_latchIDEX.ctrlEX.regDst,
-        &_latchIDEX.ctrlEX.aluSrc,
-        &_latchIDEX.ctrlWB.memToReg,
-        &_latchIDEX.ctrlWB.regWrite,
-        &_latchIDEX.ctrlMEM.memRead,
-        &_latchIDEX.ctrlMEM.memWrite,
-        &_latchIDEX.ctrlMEM.branch,
-        &_latchIDEX.ctrlEX.aluOp);
+        &_latchIDEXNext.ctrlEX.regDst,
+        &_latchIDEXNext.ctrlEX.aluSrc,
+        &_latchIDEXNext.ctrlWB.memToReg,
+        &_latchIDEXNext.ctrlWB.regWrite,
+        &_latchIDEXNext.ctrlMEM.memRead,
+        &_latchIDEXNext.ctrlMEM.memWrite,
+        &_latchIDEXNext.ctrlMEM.branch,
+        &_latchIDEXNext.ctrlEX.aluOp);
 
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _threadRegisterFiles[t] = new RegisterFile(
+          &_regFileReadRegister1,
+          &_regFileReadRegister2,
+          &_latchMEMWB.regDstIdx,
+          &_muxMemToRegOutput,
+          &_regFileRegWrite,
+          &_latchIDEXNext.regFileReadData1,
+          &_latchIDEXNext.regFileReadData2,
+          _fileNameOf(regFileNames[t]));
+      }
+      _registerFile = _threadRegisterFiles[0];
+#else
       _registerFile = new RegisterFile(
         &_regFileReadRegister1,
         &_regFileReadRegister2,
         &_latchMEMWB.regDstIdx,
         &_muxMemToRegOutput,
-        &_latchMEMWB.ctrlWB.regWrite,
-        &_latchIDEX.regFileReadData1,
-        &_latchIDEX.regFileReadData2,
+        &_regFileRegWrite,
+        &_latchIDEXNext.regFileReadData1,
+        &_latchIDEXNext.regFileReadData2,
         regFileName);
+#endif
 
       //Wire<16> signNoExtend = (_latchIFID.instruction.to_ulong() & 0xFFFF);
       _signExtend = new SignExtend<16, 32>(
-        "signExtend", &_signExtendInput, &_latchIDEX.signExtImmediate);
+        "signExtend", &_signExtendInput, &_latchIDEXNext.signExtImmediate);
 
       //Wire<32> input1 = (_latchIDEX.signExtImmediate) << 2;
       _adderBranchTargetAddr = new Adder<32>(
-        "adderBranchTargetAddr", &_latchIDEX.pcPlus4, &_adderBranchTargetAddrInput1, &_latchEXMEM.branchTargetAddr);
+        "adderBranchTargetAddr", &_latchIDEX.pcPlus4, &_adderBranchTargetAddrInput1, &_latchEXMEMNext.branchTargetAddr);
 
 #ifdef ENABLE_DATA_FORWARDING
       _muxALUSrc = new MUX2<32>(
         "muxALUSrc", &_muxForwardBOutput, &_latchIDEX.signExtImmediate, &_latchIDEX.ctrlEX.aluSrc, &_muxALUSrcOutput);
 #else
       _muxALUSrc = new MUX2<32>(
-        "muxALUSrc", &_latchIDEX.regFileReadData2, &_latchIDEX.signExtImmediate, &_latchIDEX.ctrlEX.aluSrc, &_muxALUSrcOutput);
+        "muxALUSrc", &_exReadData2, &_latchIDEX.signExtImmediate, &_latchIDEX.ctrlEX.aluSrc, &_muxALUSrcOutput);
 #endif
 
       _aluControl = new ALUControl(
@@ -185,197 +523,1297 @@ class PipelinedCPU : public DigitalCircuit {
         &_aluControlOutput,
         &_muxForwardAOutput,
         &_muxALUSrcOutput,
-        &_latchEXMEM.aluResult,
-        &_latchEXMEM.aluZero
+        &_latchEXMEMNext.aluResult,
+        &_latchEXMEMNext.aluZero
       );
 #else
       _alu = new ALU(
         &_aluControlOutput,
-        &_latchIDEX.regFileReadData1,
+        &_exReadData1,
         &_muxALUSrcOutput,
-        &_latchEXMEM.aluResult,
-        &_latchEXMEM.aluZero
+        &_latchEXMEMNext.aluResult,
+        &_latchEXMEMNext.aluZero
+      );
+#endif
+#ifdef ENABLE_MULT_DIV
+      _mulDivUnit = new MulDivUnit(
+        "mulDivUnit",
+        &_latchIDEX.mulDivOp,
+        &_muxForwardAOutput,
+        &_muxForwardBOutput,
+        &_mulDivResult
       );
 #endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _jumpPredictor = new JumpPredictor(FETCH_BRANCH_DELAY_SLOTS);
+#endif
 
       //Wire<5> input0 = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
       //Wire<5> input1 = (_latchIFID.instruction.to_ulong() >> 11) & 0x1F;
       _muxRegDst = new MUX2<5>(
-        "muxRegDst", &_latchIDEX.rt, &_latchIDEX.rd, &_latchIDEX.ctrlEX.regDst, &_latchEXMEM.regDstIdx);
+        "muxRegDst", &_latchIDEX.rt, &_latchIDEX.rd, &_latchIDEX.ctrlEX.regDst, &_latchEXMEMNext.regDstIdx);
 
       _muxPCSrc = new MUX2<32>(
         "muxPCSrc", &_pcPlus4, &_latchEXMEM.branchTargetAddr, &_muxPCSrcSelect, &_PC);
 
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER)
+      // MEM1 offers its access to the first of the units in front of the data
+      // memory, each unit offers it to the next one through a port of its
+      // own, and the last one to the data memory; they are built from the
+      // back, as each is the 'memory' of the one in front of it
+      MemoryAccess_t access = _mem1Access();
+#ifdef ENABLE_STORE_BUFFER
+      const MemoryAccess_t storeBufferAccess = access;
+      access = _addMemoryPort("storeBuffer");
+#endif
+#ifdef ENABLE_PREFETCHER
+      const MemoryAccess_t prefetcherAccess = access;
+      access = _addMemoryPort("prefetcher");
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+      const MemoryAccess_t memoryBridgeAccess = access;
+      access = _addMemoryPort("memoryBridge");
+#endif
+      _dataMemory = new Memory(
+        "dataMemory",
+        access.address,
+        access.writeData,
+        access.memRead,
+        access.memWrite,
+        access.readData,
+        memoryEndianness,
+        dataMemFileName);
+
+      DigitalCircuit *memory = _dataMemory;
+      const Wire<1> *memStall = nullptr;
+      std::deque<MemoryPort_t>::reverse_iterator port = _memoryPorts.rbegin();
+#ifdef ENABLE_CLOCK_DOMAINS
+      _memoryBridge = new MemoryBridge(
+        "memoryBridge",
+        memoryBridgeAccess.address,
+        memoryBridgeAccess.writeData,
+        memoryBridgeAccess.memRead,
+        memoryBridgeAccess.memWrite,
+        memoryBridgeAccess.readData,
+        &_memoryBridgeStall,
+        memory,
+        &port->address,
+        &port->writeData,
+        &port->memRead,
+        &port->memWrite,
+        &port->readData);
+      memory = _memoryBridge;
+      memStall = &_memoryBridgeStall;
+      ++port;
+#endif
+#ifdef ENABLE_PREFETCHER
+      _prefetcher = new StridePrefetcher(
+        "prefetcher",
+        prefetcherAccess.address,
+        prefetcherAccess.writeData,
+        prefetcherAccess.memRead,
+        prefetcherAccess.memWrite,
+        &_latchEXMEM.pcPlus4,
+        prefetcherAccess.readData,
+        &_prefetcherStall,
+        memory,
+        &port->address,
+        &port->writeData,
+        &port->memRead,
+        &port->memWrite,
+        &port->readData,
+        memStall);
+      memory = _prefetcher;
+      memStall = &_prefetcherStall;
+      ++port;
+#endif
+#ifdef ENABLE_STORE_BUFFER
+      _storeBuffer = new StoreBuffer(
+        "storeBuffer",
+        storeBufferAccess.address,
+        storeBufferAccess.writeData,
+        storeBufferAccess.memRead,
+        storeBufferAccess.memWrite,
+        storeBufferAccess.readData,
+        &_storeBufferStall,
+        memory,
+        &port->address,
+        &port->writeData,
+        &port->memRead,
+        &port->memWrite,
+        &port->readData,
+        memStall);
+      memory = _storeBuffer;
+      memStall = &_storeBufferStall;
+      ++port;
+#endif
+      _memoryUnit = memory;
+      _memoryUnitStall = memStall;
+#elif defined(ENABLE_MULTITHREADING)
+      // MEM accesses the data memory of the thread of the instruction in MEM1
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _threadDataMemories[t] = new Memory(
+          "dataMemory",
+          &_latchEXMEM.aluResult,
+          &_latchEXMEM.regFileReadData2,
+          &_latchEXMEM.ctrlMEM.memRead,
+          &_latchEXMEM.ctrlMEM.memWrite,
+          &_memNext(1).dataMemReadData,
+          memoryEndianness,
+          _fileNameOf(dataMemFileNames[t]));
+      }
+      _dataMemory = _threadDataMemories[0];
+#else
+      const MemoryAccess_t access = _mem1Access();
       _dataMemory = new Memory(
         "dataMemory",
-        &_latchEXMEM.aluResult,
-        &_latchEXMEM.regFileReadData2,
-        &_latchEXMEM.ctrlMEM.memRead,
-        &_latchEXMEM.ctrlMEM.memWrite,
-        &_latchMEMWB.dataMemReadData,
+        access.address,
+        access.writeData,
+        access.memRead,
+        access.memWrite,
+        access.readData,
         memoryEndianness,
         dataMemFileName);
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      // the page table is in the data memory
+      _virtualMemory = new VirtualMemory(_dataMemory);
+#endif
 
+      // both inputs come from the MEM-WB latch, i.e., from the instruction now in WB
       _muxMemToReg = new MUX2<32>(
-        "muxMemToReg", &_latchEXMEM.aluResult, &_latchMEMWB.dataMemReadData, &_latchMEMWB.ctrlWB.memToReg, &_muxMemToRegOutput);
+        "muxMemToReg", &_latchMEMWB.aluResult, &_latchMEMWB.dataMemReadData, &_latchMEMWB.ctrlWB.memToReg, &_muxMemToRegOutput);
     
 #ifdef ENABLE_DATA_FORWARDING
-      _forwardingUnit = new ForwardingUnit(
+      // distance 1 is the instruction in MEM1, whose input latch is the
+      // EX-MEM latch; the one at distance d > 1 is in the MEMd stage
+      std::array<const Wire<1> *, PIPELINE_MEM_STAGES> forwardRegWrite;
+      std::array<const Wire<5> *, PIPELINE_MEM_STAGES> forwardRegDstIdx;
+      std::array<const Wire<32> *, 3> forwardALUResult;
+      forwardRegWrite[0] = &_latchEXMEM.ctrlWB.regWrite;
+      forwardRegDstIdx[0] = &_latchEXMEM.regDstIdx;
+      forwardALUResult[0] = &_latchEXMEM.aluResult;
+      for (size_t d = 2; d <= 3; d++) {
+        const MEMWBLatch_t &latch = _memOut(std::min<size_t>(d, PIPELINE_MEM_STAGES) - 1);
+        if (d <= PIPELINE_MEM_STAGES) {
+          forwardRegWrite[d - 1] = &latch.ctrlWB.regWrite;
+          forwardRegDstIdx[d - 1] = &latch.regDstIdx;
+        }
+        forwardALUResult[d - 1] = (d <= PIPELINE_MEM_STAGES) ? &latch.aluResult : forwardALUResult[0];
+      }
+#ifdef ENABLE_MULTITHREADING
+      // only a producer of the consumer's thread writes a register it reads
+      for (size_t d = 1; d <= PIPELINE_MEM_STAGES; d++) {
+        forwardRegWrite[d - 1] = &_forwardRegWrite[d - 1];
+      }
+#endif
+      _forwardingUnit = new ForwardingUnit<PIPELINE_MEM_STAGES>(
         "forwardingUnit",
         &_latchIDEX.rs,
         &_latchIDEX.rt,
-        &_latchEXMEM.ctrlWB.regWrite,
-        &_latchEXMEM.regDstIdx,
-        &_latchMEMWB.ctrlWB.regWrite,
-        &_latchMEMWB.regDstIdx,
+        forwardRegWrite,
+        forwardRegDstIdx,
         &_forwardA,
         &_forwardB
       );
-      // todo
-      _muxForwardA = new MUX3<32>(
-        "muxForwardA", &_latchIDEX.regFileReadData1, &_muxMemToRegOutput, &_latchEXMEM.aluResult, &_forwardA, &_muxForwardAOutput);
-      _muxForwardB = new MUX3<32>(
-        "muxForwardB", &_latchIDEX.regFileReadData2, &_muxMemToRegOutput, &_latchEXMEM.aluResult, &_forwardB, &_muxForwardBOutput);
+      _muxForwardA = new MUX4<32>(
+        "muxForwardA", &_exReadData1, forwardALUResult[0], forwardALUResult[1], forwardALUResult[2],
+        &_forwardA, &_muxForwardAOutput);
+      _muxForwardB = new MUX4<32>(
+        "muxForwardB", &_exReadData2, forwardALUResult[0], forwardALUResult[1], forwardALUResult[2],
+        &_forwardB, &_muxForwardBOutput);
 #ifdef ENABLE_HAZARD_DETECTION
-      _hazDetUnit = new HazardDetectionUnit(
+      // distance 1 is the instruction in EX, and distance d > 1 the one in
+      // MEM(d-1); a load in the MEM stages is recognized by its 'MemToReg'
+      std::array<const Wire<1> *, PIPELINE_MEM_STAGES> hazDetMemRead;
+      std::array<const Wire<5> *, PIPELINE_MEM_STAGES> hazDetRegDstIdx;
+      hazDetMemRead[0] = &_latchIDEX.ctrlMEM.memRead;
+#ifdef ENABLE_MACRO_FUSION
+      hazDetRegDstIdx[0] = &_hazDetEXRegDstIdx;
+#else
+      hazDetRegDstIdx[0] = &_latchIDEX.rt;
+#endif
+      for (size_t d = 2; d <= PIPELINE_MEM_STAGES; d++) {
+        hazDetMemRead[d - 1] = (d == 2) ? &_latchEXMEM.ctrlWB.memToReg : &_memOut(d - 2).ctrlWB.memToReg;
+        hazDetRegDstIdx[d - 1] = (d == 2) ? &_latchEXMEM.regDstIdx : &_memOut(d - 2).regDstIdx;
+      }
+#ifdef ENABLE_MULTITHREADING
+      for (size_t d = 1; d <= PIPELINE_MEM_STAGES; d++) {
+        hazDetMemRead[d - 1] = &_hazDetMemRead[d - 1];
+      }
+#endif
+      _hazDetUnit = new HazardDetectionUnit<PIPELINE_MEM_STAGES>(
         "hazDetUnit",
         &_hazDetIFIDRs,
         &_hazDetIFIDRt,
-        &_latchIDEX.ctrlMEM.memRead,
-        &_latchIDEX.rt,
+        hazDetMemRead,
+        hazDetRegDstIdx,
+#ifdef ENABLE_MULT_DIV
+        &_mulDivStall,
+#endif
         &_hazDetPCWrite,
         &_hazDetIFIDWrite,
         &_hazDetIDEXCtrlWrite
       );
+      _evaluateHazards();
 #endif
 #endif
-    }
-
-    void WB() {
-      // WB stage
-      _muxMemToReg->advanceCycle();
-      if (_latchMEMWB.ctrlWB.regWrite.test(0) && _muxMemToRegOutput.to_ulong() != 0xfffff6e1) {
-        _registerFile->advanceCycle();
-      }
-    }
 
-    void MEM() {
-      // MEM stage
-      _dataMemory->advanceCycle();
-      _muxPCSrcSelect = _latchEXMEM.ctrlMEM.branch.to_ulong() & _latchEXMEM.aluZero.to_ulong();
-#ifdef ENABLE_HAZARD_DETECTION
-      //if (_hazDetPCWrite.test(0)) {
+#ifdef ENABLE_CLOCK_DOMAINS
+      // the stages run on the core clock, and the data memory on its own
+      _coreDomain = new ClockDomain("core", CLOCK_CORE_PERIOD);
+      _coreDomain->add([this]() { _advanceCoreCycle(); });
+      _memDomain = new ClockDomain("dataMemory", CLOCK_MEM_PERIOD, CLOCK_MEM_PHASE);
+      _memoryBridge->connect(_coreDomain, _memDomain);
+      _clockScheduler.addDomain(_coreDomain);
+      _clockScheduler.addDomain(_memDomain);
 #endif
-        _muxPCSrc->advanceCycle();
-#ifdef ENABLE_HAZARD_DETECTION
-      //}
+
+#ifdef ENABLE_PARALLEL_STAGES
+      _stageTeam = new StageTeam({
+        [this]() { WB(); },
+        [this]() { MEM(); },
+        [this]() { EX(); },
+        [this]() { ID(); },
+        [this]() { IF(); }
+      });
 #endif
 
-      _latchMEMWB.aluResult = _latchEXMEM.aluResult;
-      _latchMEMWB.regDstIdx = _latchEXMEM.regDstIdx;
-      _latchMEMWB.ctrlWB = _latchEXMEM.ctrlWB;
+#ifdef ENABLE_TIMING_MODEL
+      _buildTimingModel();
+#endif
+      _registerWires();
+      _registerPVSFields();
+#ifdef ENABLE_STATE_DIGEST
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        const std::uint32_t region = t * StateDigest::NumRegions;
+        _threadRegisterFiles[t]->attachDigest(&_stateDigest, region + StateDigest::Registers);
+        _stateDigest.watch(_threadDataMemories[t], region + StateDigest::DataMemory);
+        _stateDigest.watch(_threadInstMemories[t], region + StateDigest::InstMemory);
+      }
+#else
+      _registerFile->attachDigest(&_stateDigest);
+      _stateDigest.watch(_dataMemory, StateDigest::DataMemory);
+      _stateDigest.watch(_instMemory, StateDigest::InstMemory);
+#endif
+#endif
+#ifdef ENABLE_ASYNC_OUTPUT
+      _outputWriter = new AsyncOutputWriter(stdout, [this](OutputRecordReader &reader, std::string &out) {
+        _formatPVS(reader, out);
+      });
+#endif
     }
 
-    void EX() {
-      // EX stage
-      _aluControlInput = _latchIDEX.signExtImmediate.to_ulong() & 0x3F;
-      _aluControl->advanceCycle();
-
-#ifdef ENABLE_DATA_FORWARDING
-      _forwardingUnit->advanceCycle();
-      _muxForwardA->advanceCycle();
-      _muxForwardB->advanceCycle();
+#ifdef ENABLE_VCD_DUMP
+    // void PipelinedCPU::openVCD()
+    //   - dumps every registered wire and latch field into the VCD file
+    //     'fileName' for the cycles in [startCycle, endCycle]
+    void openVCD(const char *fileName,
+                 const std::uint64_t startCycle = 0,
+                 const std::uint64_t endCycle = UINT64_MAX) {
+      delete _vcdWriter;
+      _vcdWriter = new VCDWriter(fileName, &_wireRegistry, "PipelinedCPU", startCycle, endCycle);
+      _vcdWriter->sample(_currCycle);
+    }
 #endif
-      _muxALUSrc->advanceCycle();
 
-      _alu->advanceCycle();
-
-      _adderBranchTargetAddrInput1 = _latchIDEX.signExtImmediate << 2;
-      _adderBranchTargetAddr->advanceCycle();
+#ifdef ENABLE_PIPEVIEW
+    // void PipelinedCPU::openPipeView()
+    //   - writes the timeline of every instruction fetched from now on into
+    //     'fileName' (see PipeView), and has printStats() draw the pipeline
+    //     diagram for the cycles in [startCycle, endCycle]
+    void openPipeView(const char *fileName,
+                      const std::uint64_t startCycle = 1,
+                      const std::uint64_t endCycle = PIPEVIEW_WINDOW_CYCLES) {
+      delete _pipeView;
+      _pipeView = new PipeView(fileName, PIPELINE_IF_STAGES, PIPELINE_MEM_STAGES, startCycle, endCycle);
+    }
+#endif
 
-      _muxRegDst->advanceCycle();
+#ifdef ENABLE_PVS_ARCHIVE
+    // void PipelinedCPU::openPVSArchive()
+    //   - printPVS() appends the PVS to the archive 'fileName' (see
+    //     PVSArchive) from now on, instead of printing it
+    void openPVSArchive(const char *fileName) {
+      delete _pvsArchive;
+      _pvsArchive = new PVSArchiveWriter(fileName, _pvsLayout);
+    }
+#endif
 
-      _latchEXMEM.regFileReadData2 = _latchIDEX.regFileReadData2;
-#ifdef ENABLE_DATA_FORWARDING
-      _latchEXMEM.regFileReadData2 = _muxForwardBOutput;
+#ifdef ENABLE_STATE_DIGEST
+    // std::uint64_t PipelinedCPU::getStateDigest()
+    //   - a digest of everything printPVS() shows; the registers and the
+    //     memories are folded in as they are written, so only the PC and the
+    //     latches are hashed here
+    std::uint64_t getStateDigest() {
+#ifdef ENABLE_MULTITHREADING
+      std::uint64_t digest = _stateDigest.get();
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        digest = StateDigest::mix(digest, _threadPC[t].to_ulong());
+      }
+#else
+      std::uint64_t digest = StateDigest::mix(_stateDigest.get(), _PC.to_ulong());
+#endif
+      for (size_t i = 0; i < _pvsWires.size(); i++) {
+        digest = StateDigest::mix(digest, _pvsWires.read(i));
+      }
+#ifdef ENABLE_STORE_BUFFER
+      _pvsRecord.clear();
+      _storeBuffer->captureStoreBuffer(_pvsRecord);
+      for (std::uint32_t value : _pvsRecord) {
+        digest = StateDigest::mix(digest, value);
+      }
 #endif
-      _latchEXMEM.ctrlWB = _latchIDEX.ctrlWB;
-      _latchEXMEM.ctrlMEM = _latchIDEX.ctrlMEM;
+#ifdef ENABLE_MULT_DIV
+      digest = StateDigest::mix(digest, _mulDivUnit->getHI());
+      digest = StateDigest::mix(digest, _mulDivUnit->getLO());
+#endif
+      return digest;
     }
+#endif
 
-    void ID() {
-      // ID stage
-      _opcode = (_latchIFID.instruction.to_ulong() >> 26) & 0x3F;
-      _control->advanceCycle();
-
-      _regFileReadRegister1 = (_latchIFID.instruction.to_ulong() >> 21) & 0x1F;
-      _regFileReadRegister2 = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
-      // todo
-      _registerFile->advanceCycle();
+#ifndef ENABLE_TRACE_DRIVEN
+    // void PipelinedCPU::reset()
+    //   - brings the CPU back to the state of a new one with empty memories
+    //     and registers, without allocating anything; the program is then
+    //     loaded with setRegister(), writeInstMemory(), and writeDataMemory()
+    void reset(const std::uint32_t &initialPC) {
+      _currCycle = 0;
+      _numRetired = 0;
 
-      _signExtendInput = (_latchIFID.instruction.to_ulong() & 0xFFFF);
-      _signExtend->advanceCycle();
+      _latchIF = {};
+      _latchIFID = {};
+      _latchIDEX = {};
+      _latchEXMEM = {};
+      _latchMEM = {};
+      _latchMEMWB = {};
+      _latchIFNext = {};
+      _latchIFIDNext = {};
+      _latchIDEXNext = {};
+      _latchEXMEMNext = {};
+      _latchMEMNext = {};
+      _latchMEMWBNext = {};
 
-      _latchIDEX.pcPlus4 = _latchIFID.pcPlus4;
-#ifdef ENABLE_DATA_FORWARDING
-      _latchIDEX.rs = _latchIFID.instruction.to_ulong() >> 21;
+      _pcPlus4.reset();
+      _opcode.reset();
+      _regFileRegWrite.reset();
+      _regFileReadRegister1.reset();
+      _regFileReadRegister2.reset();
+      _muxMemToRegOutput.reset();
+      _signExtendInput.reset();
+      _adderBranchTargetAddrInput1.reset();
+      _exReadData1.reset();
+      _exReadData2.reset();
+      _muxALUSrcOutput.reset();
+      _aluControlInput.reset();
+      _aluControlOutput.reset();
+      _muxPCSrcSelect.reset();
+      for (MemoryPort_t &port : _memoryPorts) {
+        port.address.reset();
+        port.writeData.reset();
+        port.readData.reset();
+        port.memRead.reset();
+        port.memWrite.reset();
+      }
+#ifdef ENABLE_STORE_BUFFER
+      _storeBufferStall.reset();
+      _storeBuffer->reset();
 #endif
-      _latchIDEX.rt = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
-      _latchIDEX.rd = (_latchIFID.instruction.to_ulong() >> 11) & 0x1F;
-
+#ifdef ENABLE_CLOCK_DOMAINS
+      _memoryBridgeStall.reset();
+      _memoryBridge->reset();
+      _clockScheduler.reset();
+#endif
+#ifdef ENABLE_PREFETCHER
+      _prefetcherStall.reset();
+      _prefetcher->reset();
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      _instMemPhysAddress.reset();
+      _dataMemPhysAddress.reset();
+      _dTLBMemRead.reset();
+      _dTLBMemWrite.reset();
+      _dTLBStall.reset();
+      _dTLBTranslated = false;
+      _virtualMemory->reset();
+#endif
+#ifdef ENABLE_DATA_FORWARDING
+      _forwardA.reset();
+      _forwardB.reset();
+      _muxForwardAOutput.reset();
+      _muxForwardBOutput.reset();
 #ifdef ENABLE_HAZARD_DETECTION
-      _hazDetIFIDRs = _latchIFID.instruction.to_ulong() >> 21;
-      _hazDetIFIDRt = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
-      _hazDetUnit->advanceCycle();
-      if (_hazDetIDEXCtrlWrite.to_ulong() == 0) {
-        _latchIDEX.ctrlWB.regWrite = 0;
-        _latchIDEX.ctrlWB.memToReg = 0;
-        _latchIDEX.ctrlMEM.branch = 0;
-        _latchIDEX.ctrlMEM.memRead = 0;
-        _latchIDEX.ctrlMEM.memWrite = 0;
-        _latchIDEX.ctrlEX.aluOp = 0;
-        _latchIDEX.ctrlEX.aluSrc = 0;
-        _latchIDEX.ctrlEX.regDst = 0;
+      _hazDetIFIDRs.reset();
+      _hazDetIFIDRt.reset();
+      _hazDetPCWrite.reset();
+      _hazDetIFIDWrite.reset();
+      _hazDetIDEXCtrlWrite.reset();
+#ifdef ENABLE_MACRO_FUSION
+      _hazDetEXRegDstIdx.reset();
+#endif
+#endif
+#endif
+#ifdef ENABLE_MULT_DIV
+      _mulDivResult.reset();
+      _mulDivStall.reset();
+      _mulDivUnit->reset();
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _jumpPredictor->reset();
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _macroFusion.reset();
+#endif
+#ifdef ENABLE_PROFILER
+      _profiler = Profiler();
+      _profBranchPC = 0;
+      _profRetiring = false;
+      _profRetiringPC = 0;
+#endif
+#ifdef ENABLE_PIPEVIEW
+      if (_pipeView != nullptr) {
+        _pipeView->drain();
       }
 #endif
-    }
 
-    void IF() {
-      // IF stage
-#ifdef ENABLE_HAZARD_DETECTION
-      if (_hazDetIFIDWrite.test(0)) {
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _threadRegisterFiles[t]->clear();
+        _threadDataMemories[t]->clear();
+        _threadInstMemories[t]->clear();
+      }
+      _resetThreads(initialPC);
+#else
+      _registerFile->clear();
+      _dataMemory->clear();
+      _instMemory->clear();
 #endif
+#if !defined(ENABLE_FETCH_QUEUE) && !defined(ENABLE_MULTITHREADING)
+      _redirects.clear();
+#endif
+
+      _PC = initialPC;
       _adderPCPlus4->advanceCycle();
-      _instMemory->advanceCycle();
-      _latchIFID.pcPlus4 = _pcPlus4;
+#ifdef ENABLE_FETCH_QUEUE
+      _fetchUnit->reset(initialPC + 4);
+#endif
 #ifdef ENABLE_HAZARD_DETECTION
+      _evaluateHazards();
+#endif
+    }
+
+    // bool PipelinedCPU::isHalted()
+    //   - true once the program has run off the end of its code: the next
+    //     fetch is from a word of the instruction memory that was never
+    //     written, and no instruction that was is still in flight (a branch
+    //     among them could still jump back)
+    bool isHalted() {
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        if (_isThreadFetching(t)) {
+          return false;
+        }
+      }
+#elif defined(ENABLE_FETCH_QUEUE)
+      if (_instMemory->isLoaded(_PC.to_ulong())) {
+        return false;
+      }
+      for (const FetchUnit::Entry &entry : _fetchUnit->getQueue()) {
+        if (_instMemory->isLoaded(entry.pc)) {
+          return false;
+        }
+      }
+#else
+      if (!_redirects.empty() || _instMemory->isLoaded(_instAddressOf(_pcPlus4.to_ulong()))) {
+        return false;
+      }
+#endif
+      for (size_t i = 1; i <= PIPELINE_IF_STAGES; i++) {
+        if (_isLoadedInFlight(_ifOut(i))) {
+          return false;
+        }
+      }
+      if (_isLoadedInFlight(_latchIDEX) || _isLoadedInFlight(_latchEXMEM)) {
+        return false;
+      }
+      for (size_t i = 1; i <= PIPELINE_MEM_STAGES; i++) {
+        if (_isLoadedInFlight(_memOut(i))) {
+          return false;
+        }
+      }
+#ifdef ENABLE_STORE_BUFFER
+      if (!_storeBuffer->isEmpty()) {
+        return false;
       }
 #endif
+#ifdef ENABLE_CLOCK_DOMAINS
+      if (!_memoryBridge->isIdle()) {
+        return false;
+      }
+#endif
+#ifdef ENABLE_PREFETCHER
+      if (!_prefetcher->isIdle()) {
+        return false;
+      }
+#endif
+#ifdef ENABLE_MULT_DIV
+      if (!_mulDivUnit->isIdle()) {
+        return false;
+      }
+#endif
+      return true;
     }
+#endif
 
-    virtual void advanceCycle() {
-      _currCycle += 1;
+    // the registers and the memories below are those of thread 0 with
+    // ENABLE_MULTITHREADING
+    std::uint32_t getRegister(size_t i) const {
+      return _registerFile->getRegister(i);
+    }
 
-      WB();
-      MEM();
-      EX();
-      ID();
-      IF();
+    void setRegister(size_t i, std::uint32_t value) {
+      _registerFile->setRegister(i, value);
     }
 
-    ~PipelinedCPU() {
+    // std::uint32_t PipelinedCPU::readDataMemory()
+    //   - reads the data memory itself, i.e., not the stores still waiting in
+    //     the store buffer
+    std::uint32_t readDataMemory(std::uint32_t address) const {
+      return _dataMemory->readWord(address);
+    }
+
+    void writeDataMemory(std::uint32_t address, std::uint32_t data) {
+      _dataMemory->writeWord(address, data);
+    }
+
+    std::uint32_t readInstMemory(std::uint32_t address) const {
+      return _instMemory->readWord(address);
+    }
+
+    void writeInstMemory(std::uint32_t address, std::uint32_t data) {
+      _instMemory->writeWord(address, data);
+    }
+
+    const WireRegistry &getWireRegistry() const {
+      return _wireRegistry;
+    }
+
+    std::uint64_t getNumCycles() const {
+      return _currCycle;
+    }
+
+    std::uint64_t getNumRetired() const {
+      return _numRetired;
+    }
+
+#ifdef ENABLE_TIMING_MODEL
+    // double PipelinedCPU::getMinCycleTimeNs()
+    //   - the shortest clock period the critical path of the datapath allows
+    double getMinCycleTimeNs() {
+      return _timingModel.getMinCycleTime() / 1000.0;
+    }
+#endif
+
+#ifdef ENABLE_JUMP_PREDICTION
+    // void PipelinedCPU::resizeJumpPredictor()
+    //   - a RAS of 'rasDepth' entries and an ITC of 'itcEntries' instead of
+    //     JUMP_RAS_DEPTH and JUMP_ITC_ENTRIES (e.g., for a sweep over them);
+    //     before the first cycle or right after a reset()
+    void resizeJumpPredictor(const size_t rasDepth, const size_t itcEntries) {
+      _jumpPredictor->resize(rasDepth, itcEntries);
+    }
+#endif
+
+#ifdef ENABLE_PREFETCHER
+    // void PipelinedCPU::configurePrefetcher()
+    //   - 'degree' prefetches from 'distance' strides ahead instead of
+    //     PREFETCH_DEGREE and PREFETCH_DISTANCE; before the first cycle or
+    //     right after a reset()
+    void configurePrefetcher(const size_t degree, const size_t distance) {
+      _prefetcher->configure(degree, distance);
+    }
+#endif
+
+    void WB() {
+      HOST_PROFILE_SCOPE("WB");
+      // WB stage
+      if (_latchMEMWB.valid.test(0)) {
+#ifdef ENABLE_MACRO_FUSION
+        _numRetired += (_latchMEMWB.fusedOp.to_ulong() != MacroFusion::None) ? 2 : 1;
+#else
+        _numRetired += 1;
+#endif
+#ifdef ENABLE_MULTITHREADING
+        _threadNumRetired[_latchMEMWB.thread.to_ulong()] += 1;
+#endif
+#ifdef ENABLE_PROFILER
+        _profiler.retire(_pcOf(_latchMEMWB.pcPlus4));
+#endif
+      }
+#ifdef ENABLE_MULTITHREADING
+      else {
+        _numIdleCycles += 1;
+      }
+#endif
+      HOST_PROFILE_ADVANCE(_muxMemToReg);
+      // only WB writes the Register File, when the cycle is committed
+      _regFileRegWrite = _latchMEMWB.ctrlWB.regWrite;
+    }
+
+    void MEM() {
+      HOST_PROFILE_SCOPE("MEM");
+      // MEM2..MEMn only carry the access started in MEM1 along
+      for (size_t i = PIPELINE_MEM_STAGES; i >= 2; i--) {
+        _memNext(i) = _memOut(i - 1);
+      }
+
+      // MEM stage (MEM1)
+#ifdef ENABLE_VIRTUAL_MEMORY
+      // the dTLB translates the address first, once per access, and the
+      // units behind it see no access until it has
+      _dTLBStall = 0;
+      _dTLBMemRead = _latchEXMEM.ctrlMEM.memRead;
+      _dTLBMemWrite = _latchEXMEM.ctrlMEM.memWrite;
+      if ((_dTLBMemRead.test(0) || _dTLBMemWrite.test(0)) && !_dTLBTranslated) {
+        std::uint32_t physical;
+        if (_virtualMemory->translate(VirtualMemory::Data, _latchEXMEM.aluResult.to_ulong(), _currCycle, physical)) {
+          _dataMemPhysAddress = physical;
+          _dTLBTranslated = true;
+        } else {
+          _dTLBStall = 1;
+          _dTLBMemRead = 0;
+          _dTLBMemWrite = 0;
+        }
+      }
+#endif
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER)
+      HOST_PROFILE_ADVANCE(_memoryUnit);
+#ifdef ENABLE_VIRTUAL_MEMORY
+      _dTLBStall |= *_memoryUnitStall;
+#endif
+#elif defined(ENABLE_MULTITHREADING)
+      HOST_PROFILE_ADVANCE(_threadDataMemories[_latchEXMEM.thread.to_ulong()]);
+#else
+      HOST_PROFILE_ADVANCE(_dataMemory);
+#endif
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER) \
+    || defined(ENABLE_VIRTUAL_MEMORY)
+      if (_memStall().test(0)) {
+        // the MEM stage holds the EX-MEM latch until the access is done, and
+        // sends a bubble to WB
+        _memNext(1).ctrlWB.memToReg = 0;
+        _memNext(1).ctrlWB.regWrite = 0;
+        _memNext(1).valid = 0;
+#ifdef ENABLE_PROFILER
+        _profiler.stall(_pcOf(_latchEXMEM.pcPlus4), Profiler::DataMemory);
+#endif
+        return;
+      }
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      _dTLBTranslated = false;
+#endif
+
+      _memNext(1).aluResult = _latchEXMEM.aluResult;
+      _memNext(1).regDstIdx = _latchEXMEM.regDstIdx;
+      _memNext(1).ctrlWB = _latchEXMEM.ctrlWB;
+      _memNext(1).valid = _latchEXMEM.valid;
+      _memNext(1).pcPlus4 = _latchEXMEM.pcPlus4;
+#ifdef ENABLE_MULTITHREADING
+      _memNext(1).thread = _latchEXMEM.thread;
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _memNext(1).seqNum = _latchEXMEM.seqNum;
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _memNext(1).fusedOp = _latchEXMEM.fusedOp;
+#endif
+    }
+
+    void EX() {
+      HOST_PROFILE_SCOPE("EX");
+      // EX stage
+      _aluControlInput = _latchIDEX.signExtImmediate.to_ulong() & 0x3F;
+#ifdef ENABLE_MACRO_FUSION
+      // the immediate of a fused slt+beq is the branch offset, so the
+      // 'funct' of the slt is given here
+      if (_latchIDEX.fusedOp.to_ulong() == MacroFusion::SltBeq) {
+        _aluControlInput = 0x2A;
+      }
+#endif
+      HOST_PROFILE_ADVANCE(_aluControl);
+
+      _exReadData1 = _wbBypass(_latchIDEX.rs, _latchIDEX.regFileReadData1);
+      _exReadData2 = _wbBypass(_latchIDEX.rt, _latchIDEX.regFileReadData2);
+#ifdef ENABLE_DATA_FORWARDING
+#ifdef ENABLE_MULTITHREADING
+      _forwardRegWrite[0] = _latchEXMEM.ctrlWB.regWrite.to_ulong() & (_latchEXMEM.thread == _latchIDEX.thread);
+      for (size_t d = 2; d <= PIPELINE_MEM_STAGES; d++) {
+        _forwardRegWrite[d - 1] = _memOut(d - 1).ctrlWB.regWrite.to_ulong() & (_memOut(d - 1).thread == _latchIDEX.thread);
+      }
+#endif
+      HOST_PROFILE_ADVANCE(_forwardingUnit);
+      HOST_PROFILE_ADVANCE(_muxForwardA);
+      HOST_PROFILE_ADVANCE(_muxForwardB);
+#endif
+      HOST_PROFILE_ADVANCE(_muxALUSrc);
+
+      HOST_PROFILE_ADVANCE(_alu);
+#ifdef ENABLE_MACRO_FUSION
+      // a fused add+lw adds the immediate to the sum of the registers
+      if (_latchIDEX.fusedOp.to_ulong() == MacroFusion::AddLw) {
+        _latchEXMEMNext.aluResult = _latchEXMEMNext.aluResult.to_ulong() + _latchIDEX.signExtImmediate.to_ulong();
+      }
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      // the recorded effective address replaces the address computed by the
+      // ALU, and a branch is taken iff the trace recorded its target
+      if (_latchIDEX.traceAddressValid.test(0)
+          && (_latchIDEX.ctrlMEM.memRead.test(0) || _latchIDEX.ctrlMEM.memWrite.test(0))) {
+        _latchEXMEMNext.aluResult = _latchIDEX.traceAddress;
+      }
+      if (_latchIDEX.ctrlMEM.branch.test(0)) {
+        _latchEXMEMNext.aluZero = _latchIDEX.traceAddressValid;
+      }
+#endif
+#ifdef ENABLE_MULT_DIV
+      // the multiply/divide unit takes the same operands as the ALU, and the
+      // HI or LO an mfhi/mflo reads takes the place of the ALU output
+      HOST_PROFILE_ADVANCE(_mulDivUnit);
+      const MulDivUnit::Op mulDivOp = (MulDivUnit::Op)_latchIDEX.mulDivOp.to_ulong();
+      if (mulDivOp == MulDivUnit::Mfhi || mulDivOp == MulDivUnit::Mflo) {
+        _latchEXMEMNext.aluResult = _mulDivResult;
+      }
+#endif
+
+      _adderBranchTargetAddrInput1 = _latchIDEX.signExtImmediate << 2;
+      HOST_PROFILE_ADVANCE(_adderBranchTargetAddr);
+
+      HOST_PROFILE_ADVANCE(_muxRegDst);
+#ifdef ENABLE_JUMPS
+      // a jump is a taken branch to its target, and a jal writes the
+      // address after its delay slots into $31
+      const JumpPredictor::Op jumpOp = (JumpPredictor::Op)_latchIDEX.jumpOp.to_ulong();
+      if (jumpOp != JumpPredictor::None) {
+        if (JumpPredictor::isIndirect(jumpOp)) {
+#ifdef ENABLE_DATA_FORWARDING
+          _latchEXMEMNext.branchTargetAddr = _muxForwardAOutput;
+#else
+          _latchEXMEMNext.branchTargetAddr = _exReadData1;
+#endif
+        } else {
+          // the 26-bit target field is what is left of the instruction in rs, rt, and the immediate
+          const std::uint32_t instruction = (_latchIDEX.rs.to_ulong() << 21) | (_latchIDEX.rt.to_ulong() << 16)
+                                            | (_latchIDEX.signExtImmediate.to_ulong() & 0xFFFF);
+          _latchEXMEMNext.branchTargetAddr = JumpPredictor::directTarget(_pcOf(_latchIDEX.pcPlus4), instruction);
+        }
+        _latchEXMEMNext.aluZero = 1;
+        if (jumpOp == JumpPredictor::Jal) {
+          _latchEXMEMNext.aluResult = JumpPredictor::returnAddress(_pcOf(_latchIDEX.pcPlus4), FETCH_BRANCH_DELAY_SLOTS);
+          _latchEXMEMNext.regDstIdx = 31;
+        }
+      }
+#endif
+
+      // the latch carries the store data, so only a store takes rt's value
+      // up to date; the rt of the other I-format instructions is their
+      // destination, and nothing is forwarded to it
+      _latchEXMEMNext.regFileReadData2 = _latchIDEX.regFileReadData2;
+      if (_latchIDEX.ctrlMEM.memWrite.test(0)) {
+        _latchEXMEMNext.regFileReadData2 = _exReadData2;
+#ifdef ENABLE_DATA_FORWARDING
+        _latchEXMEMNext.regFileReadData2 = _muxForwardBOutput;
+#endif
+      }
+      _latchEXMEMNext.ctrlWB = _latchIDEX.ctrlWB;
+      _latchEXMEMNext.ctrlMEM = _latchIDEX.ctrlMEM;
+      _latchEXMEMNext.valid = _latchIDEX.valid;
+      _latchEXMEMNext.pcPlus4 = _latchIDEX.pcPlus4;
+#ifdef ENABLE_MULTITHREADING
+      _latchEXMEMNext.thread = _latchIDEX.thread;
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _latchEXMEMNext.seqNum = _latchIDEX.seqNum;
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _latchEXMEMNext.fusedOp = _latchIDEX.fusedOp;
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _latchEXMEMNext.jumpOp = _latchIDEX.jumpOp;
+      _latchEXMEMNext.jumpPredicted = _latchIDEX.jumpPredicted;
+      _latchEXMEMNext.jumpPredictedTarget = _latchIDEX.jumpPredictedTarget;
+#endif
+    }
+
+    void ID() {
+      HOST_PROFILE_SCOPE("ID");
+      // ID stage (the Hazard Detection unit was evaluated by _commitLatches())
+      _opcode = (_latchIFID.instruction.to_ulong() >> 26) & 0x3F;
+      HOST_PROFILE_ADVANCE(_control);
+
+      _regFileReadRegister1 = (_latchIFID.instruction.to_ulong() >> 21) & 0x1F;
+      _regFileReadRegister2 = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
+      // the Register File is read by _commitLatches(), after WB's write
+
+      _signExtendInput = (_latchIFID.instruction.to_ulong() & 0xFFFF);
+      HOST_PROFILE_ADVANCE(_signExtend);
+
+      _latchIDEXNext.pcPlus4 = _latchIFID.pcPlus4;
+      _latchIDEXNext.valid = _latchIFID.valid;
+#ifdef ENABLE_MULTITHREADING
+      _latchIDEXNext.thread = _latchIFID.thread;
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _latchIDEXNext.seqNum = _latchIFID.seqNum;
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _latchIDEXNext.jumpPredicted = _latchIFID.jumpPredicted;
+      _latchIDEXNext.jumpPredictedTarget = _latchIFID.jumpPredictedTarget;
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      _latchIDEXNext.traceAddress = _latchIFID.traceAddress;
+      _latchIDEXNext.traceAddressValid = _latchIFID.traceAddressValid;
+#endif
+      _latchIDEXNext.rs = _latchIFID.instruction.to_ulong() >> 21;
+      _latchIDEXNext.rt = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
+      _latchIDEXNext.rd = (_latchIFID.instruction.to_ulong() >> 11) & 0x1F;
+#ifdef ENABLE_MULT_DIV
+      // mult/div write HI and LO instead of 'rd'
+      _latchIDEXNext.mulDivOp = MulDivUnit::decode(_latchIFID.instruction.to_ulong());
+      if (MulDivUnit::isMulDiv((MulDivUnit::Op)_latchIDEXNext.mulDivOp.to_ulong())) {
+        _latchIDEXNext.ctrlWB.regWrite = 0;
+      }
+#endif
+#ifdef ENABLE_JUMPS
+      // a jump goes through MEM as a taken beq does, and only a jal writes
+      // a register ($31, in EX)
+      _latchIDEXNext.jumpOp = JumpPredictor::decode(_latchIFID.instruction.to_ulong());
+      if (_latchIDEXNext.jumpOp.to_ulong() != JumpPredictor::None) {
+        _latchIDEXNext.ctrlWB.regWrite = (_latchIDEXNext.jumpOp.to_ulong() == JumpPredictor::Jal);
+        _latchIDEXNext.ctrlWB.memToReg = 0;
+        _latchIDEXNext.ctrlMEM.branch = 1;
+        _latchIDEXNext.ctrlMEM.memRead = 0;
+        _latchIDEXNext.ctrlMEM.memWrite = 0;
+      }
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _fuse();
+#endif
+
+#ifdef ENABLE_HAZARD_DETECTION
+      if (_hazDetIDEXCtrlWrite.to_ulong() == 0) {
+        _latchIDEXNext.ctrlWB.regWrite = 0;
+        _latchIDEXNext.ctrlWB.memToReg = 0;
+        _latchIDEXNext.ctrlMEM.branch = 0;
+        _latchIDEXNext.ctrlMEM.memRead = 0;
+        _latchIDEXNext.ctrlMEM.memWrite = 0;
+        _latchIDEXNext.ctrlEX.aluOp = 0;
+        _latchIDEXNext.ctrlEX.aluSrc = 0;
+        _latchIDEXNext.ctrlEX.regDst = 0;
+        _latchIDEXNext.valid = 0;
+#ifdef ENABLE_MULT_DIV
+        _latchIDEXNext.mulDivOp = MulDivUnit::None;
+        _mulDivUnit->countStall((MulDivUnit::Stall)_mulDivStall.to_ulong());
+#endif
+#ifdef ENABLE_JUMPS
+        _latchIDEXNext.jumpOp = JumpPredictor::None;
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+        _latchIDEXNext.jumpPredicted = 0;
+#endif
+#ifdef ENABLE_PROFILER
+        // a wait for the multiply/divide unit is charged as a load-use stall
+        _profiler.stall(_pcOf(_latchIFID.pcPlus4), Profiler::LoadUse);
+#endif
+      }
+#endif
+    }
+
+#ifdef ENABLE_FETCH_QUEUE
+    void IF() {
+      HOST_PROFILE_SCOPE("IF");
+      // IF stage: the fetch unit fills the instruction queue, and the IF-ID
+      // latch takes the oldest instruction unless ID is stalled
+      _muxPCSrcSelect = _latchEXMEM.ctrlMEM.branch.to_ulong() & _latchEXMEM.aluZero.to_ulong();
+      size_t numSquashed = 0;
+      if (_muxPCSrcSelect.test(0)) {
+        // the delay slots already in EX and ID are kept, and the rest of
+        // them are in the queue or still to be fetched
+        const size_t numInFlight = _latchIDEX.valid.to_ulong() + _latchIFID.valid.to_ulong();
+        numSquashed = _fetchUnit->redirect(_latchEXMEM.branchTargetAddr.to_ulong(),
+                                           FETCH_BRANCH_DELAY_SLOTS - std::min<size_t>(numInFlight, FETCH_BRANCH_DELAY_SLOTS));
+      }
+#ifdef ENABLE_HAZARD_DETECTION
+      if (_hazDetIFIDWrite.test(0)) {
+#endif
+        FetchUnit::Entry entry;
+        if (_fetchUnit->dequeue(entry)) {
+          _latchIFIDNext.pcPlus4 = entry.pc + 4;
+          _latchIFIDNext.instruction = entry.instruction;
+          _latchIFIDNext.valid = 1;
+        } else {
+          _latchIFIDNext.instruction = 0;
+          _latchIFIDNext.valid = 0;
+        }
+#ifdef ENABLE_HAZARD_DETECTION
+      }
+#endif
+      HOST_PROFILE_ADVANCE(_fetchUnit);
+      _pcPlus4 = _PC.to_ulong() + 4;
+#ifdef ENABLE_PROFILER
+      if (numSquashed > 0) {
+        _profiler.stall(_pcOf(_latchEXMEM.pcPlus4), Profiler::Branch, numSquashed);
+      }
+      const std::deque<FetchUnit::Entry> &queue = _fetchUnit->getQueue();
+      for (size_t i = queue.size() - _fetchUnit->getNumFetchedLastCycle(); i < queue.size(); i++) {
+        _profiler.fetch(queue[i].pc, queue[i].instruction);
+        _profiler.occupy(Profiler::IF, queue[i].pc);
+      }
+#else
+      (void)numSquashed;
+#endif
+    }
+#elif defined(ENABLE_MULTITHREADING)
+    void IF() {
+      HOST_PROFILE_SCOPE("IF");
+      // IF stage: a branch taken in MEM1 redirects the thread it belongs to
+      // once that thread has fetched its delay slots; the instructions of
+      // the other threads in ID and EX are not among them
+      _muxPCSrcSelect = _latchEXMEM.ctrlMEM.branch.to_ulong() & _latchEXMEM.aluZero.to_ulong();
+      if (_muxPCSrcSelect.test(0)) {
+        const size_t thread = _latchEXMEM.thread.to_ulong();
+        size_t numInFlight = 0;
+        if (_latchIDEX.valid.test(0) && _latchIDEX.thread == _latchEXMEM.thread) {
+          numInFlight += 1;
+        }
+        if (_latchIFID.valid.test(0) && _latchIFID.thread == _latchEXMEM.thread) {
+          numInFlight += 1;
+        }
+        // a branch in the delay slot of another one jumps after it
+        const Redirect_t redirect = {
+          FETCH_BRANCH_DELAY_SLOTS - std::min<size_t>(numInFlight, FETCH_BRANCH_DELAY_SLOTS),
+          (std::uint32_t)_latchEXMEM.branchTargetAddr.to_ulong()
+        };
+        if (redirect.numDelaySlotsLeft == 0) {
+          _threadNextPC[thread] = redirect.target;
+        } else {
+          _threadRedirects[thread].push_back(redirect);
+        }
+        if (thread == _fetchThread) {
+          _switchThread = true;
+        }
+      }
+#ifdef ENABLE_HAZARD_DETECTION
+      if (!_hazDetIFIDWrite.test(0)) {
+        _numLoadUseStallCycles += 1;
+        _switchThread = true;
+        return;
+      }
+#endif
+      const size_t thread = _selectThread();
+      _fetchThread = thread;
+      _PC = _threadNextPC[thread];
+      HOST_PROFILE_ADVANCE(_adderPCPlus4);
+      HOST_PROFILE_ADVANCE(_threadInstMemories[thread]);
+      _threadPC[thread] = _PC;
+      _threadNextPC[thread] = _pcPlus4.to_ulong();
+      for (Redirect_t &redirect : _threadRedirects[thread]) {
+        redirect.numDelaySlotsLeft -= 1;
+      }
+      if (!_threadRedirects[thread].empty() && _threadRedirects[thread].front().numDelaySlotsLeft == 0) {
+        _threadNextPC[thread] = _threadRedirects[thread].front().target;
+        _threadRedirects[thread].erase(_threadRedirects[thread].begin());
+      }
+      _threadNumFetched[thread] += 1;
+      _ifNext(1).pcPlus4 = _pcPlus4;
+      _ifNext(1).valid = 1;
+      _ifNext(1).thread = thread;
+#ifdef ENABLE_PIPEVIEW
+      _pipeviewFetch(_ifNext(1));
+#endif
+    }
+#else
+    void IF() {
+      HOST_PROFILE_SCOPE("IF");
+      // IF stage: a branch taken in MEM1 redirects the fetch once its delay
+      // slots are fetched; they are the oldest instructions after it, which
+      // are in EX and ID unless a stall has left a bubble there
+      _muxPCSrcSelect = _latchEXMEM.ctrlMEM.branch.to_ulong() & _latchEXMEM.aluZero.to_ulong();
+#ifdef ENABLE_JUMP_PREDICTION
+      // a jump whose target was predicted right has redirected the fetch
+      // already, after its delay slots
+      if (_latchEXMEM.valid.test(0) && _latchEXMEM.jumpOp.to_ulong() != JumpPredictor::None) {
+        if (_jumpPredictor->resolve((JumpPredictor::Op)_latchEXMEM.jumpOp.to_ulong(), _pcOf(_latchEXMEM.pcPlus4),
+                                    _latchEXMEM.branchTargetAddr.to_ulong(), _latchEXMEM.jumpPredicted.test(0),
+                                    _latchEXMEM.jumpPredictedTarget.to_ulong())) {
+          _muxPCSrcSelect = 0;
+        }
+      }
+#endif
+#ifdef ENABLE_PROFILER
+      _profBranchPC = _pcOf(_latchEXMEM.pcPlus4);
+#endif
+#ifdef ENABLE_HAZARD_DETECTION
+      const Register<32> pc = _PC;
+#endif
+      HOST_PROFILE_ADVANCE(_muxPCSrc);
+      // the instructions in IF1..IF(n-1) fetched after the delay slots
+      std::array<bool, PIPELINE_IF_STAGES> squash = {};
+      if (_muxPCSrcSelect.test(0)) {
+        size_t numDelaySlots = _latchIDEX.valid.to_ulong() + _latchIFID.valid.to_ulong();
+        for (size_t i = PIPELINE_IF_STAGES - 1; i >= 1; i--) {
+          if (_ifOut(i).valid.test(0)) {
+            if (numDelaySlots < FETCH_BRANCH_DELAY_SLOTS) {
+              numDelaySlots += 1;
+            } else {
+              squash[i] = true;
+            }
+          }
+        }
+#ifdef ENABLE_JUMP_PREDICTION
+        _recoverJumpPredictor(squash);
+#endif
+#ifndef ENABLE_TRACE_DRIVEN
+        if (numDelaySlots < FETCH_BRANCH_DELAY_SLOTS) {
+          // the jump waits until the rest of the delay slots are fetched
+          const Redirect_t redirect = {
+            FETCH_BRANCH_DELAY_SLOTS - numDelaySlots,
+            (std::uint32_t)_latchEXMEM.branchTargetAddr.to_ulong()
+#ifdef ENABLE_JUMP_PREDICTION
+            , false
+#endif
+          };
+          _redirects.push_back(redirect);
+          _PC = _pcPlus4;
+        }
+#endif
+      }
+#ifdef ENABLE_HAZARD_DETECTION
+      if (_hazDetIFIDWrite.test(0)) {
+#endif
+      // IF2..IFn pass the fetched instruction along
+      size_t numSquashed = 0;
+      for (size_t i = PIPELINE_IF_STAGES; i >= 2; i--) {
+        _ifNext(i) = _ifOut(i - 1);
+        if (squash[i - 1]) {
+          numSquashed += 1;
+#ifdef ENABLE_PIPEVIEW
+          _pipeviewSquash(_ifOut(i - 1));
+#endif
+          _ifNext(i).instruction = 0;
+          _ifNext(i).valid = 0;
+        }
+      }
+
+#ifdef ENABLE_TRACE_DRIVEN
+      // the trace holds the correct path only, so the squashed records are
+      // fetched again, which costs the same bubbles as a refetch from the target
+      _traceReader->rewind(numSquashed);
+      HOST_PROFILE_ADVANCE(_traceReader);
+      _PC = _tracePC;
+      _pcPlus4 = _tracePC.to_ulong() + 4;
+      _ifNext(1).pcPlus4 = _pcPlus4;
+#else
+      HOST_PROFILE_ADVANCE(_adderPCPlus4);
+#ifdef ENABLE_VIRTUAL_MEMORY
+      std::uint32_t physical;
+      if (_virtualMemory->translate(VirtualMemory::Fetch, _PC.to_ulong(), _currCycle, physical)) {
+      _instMemPhysAddress = physical;
+#endif
+      HOST_PROFILE_ADVANCE(_instMemory);
+      _ifNext(1).pcPlus4 = _pcPlus4;
+      _ifNext(1).valid = 1;
+      for (Redirect_t &redirect : _redirects) {
+        redirect.numDelaySlotsLeft -= 1;
+      }
+      if (!_redirects.empty() && _redirects.front().numDelaySlotsLeft == 0) {
+        _pcPlus4 = _redirects.front().target;
+        _redirects.erase(_redirects.begin());
+      }
+#ifdef ENABLE_JUMP_PREDICTION
+      _predictJump(_ifNext(1));
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      } else {
+        // the fetch waits for the walk that refills the iTLB, so IF1 sends a
+        // bubble along and the same address is fetched in the next cycle
+        _ifNext(1).pcPlus4 = _pcPlus4;
+        _ifNext(1).instruction = 0;
+        _ifNext(1).valid = 0;
+        _pcPlus4 = _PC;
+      }
+#endif
+#endif
+#ifdef ENABLE_PROFILER
+      if (numSquashed > 0) {
+        _profiler.stall(_profBranchPC, Profiler::Branch, numSquashed);
+      }
+      if (_ifNext(1).valid.test(0)) {
+        _profiler.fetch(_pcOf(_ifNext(1).pcPlus4), _ifNext(1).instruction.to_ulong());
+        _profiler.occupy(Profiler::IF, _pcOf(_ifNext(1).pcPlus4));
+      }
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _pipeviewFetch(_ifNext(1));
+#endif
+#ifdef ENABLE_HAZARD_DETECTION
+      } else {
+        // the fetch waits for ID: 'PCWrite' keeps the PC, the address it
+        // would have fetched from is fetched in the next cycle, and the
+        // instructions to squash become bubbles where they are
+        _pcPlus4 = _PC;
+        _PC = pc;
+        size_t numSquashed = 0;
+        for (size_t i = 1; i < PIPELINE_IF_STAGES; i++) {
+          if (squash[i]) {
+            _ifNext(i) = _ifOut(i);
+            numSquashed += 1;
+#ifdef ENABLE_PIPEVIEW
+            _pipeviewSquash(_ifOut(i));
+#endif
+            _ifNext(i).instruction = 0;
+            _ifNext(i).valid = 0;
+          }
+        }
+#ifdef ENABLE_TRACE_DRIVEN
+        _traceReader->rewind(numSquashed);
+#endif
+#ifdef ENABLE_PROFILER
+        if (numSquashed > 0) {
+          _profiler.stall(_profBranchPC, Profiler::Branch, numSquashed);
+        }
+#endif
+      }
+#endif
+    }
+#endif
+
+    virtual void advanceCycle() {
+#ifdef ENABLE_CLOCK_DOMAINS
+      // the timeline runs up to the next edge of the core clock, and the
+      // data memory has the edges of its own clock until then
+      _clockScheduler.runUntil(_coreDomain);
+#else
+      _advanceCoreCycle();
+#endif
+    }
+
+    void _advanceCoreCycle() {
+      _currCycle += 1;
+#ifdef ENABLE_HOST_PROFILER
+      _hostProfiler.beginCycle();
+#endif
+
+#ifdef ENABLE_PROFILER
+      _profileStages();
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _pipeviewStages();
+#endif
+      // every stage reads the latches and writes only their next values, so
+      // the stages may run in any order, or at the same time
+#ifdef ENABLE_PARALLEL_STAGES
+      _stageTeam->run();
+#else
+      WB();
+      MEM();
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER) \
+    || defined(ENABLE_VIRTUAL_MEMORY)
+      // the EX, ID, and IF stages are frozen while MEM stalls, but the
+      // fetch unit goes on filling its queue
+      if (!_memStall().test(0)) {
+#endif
+      EX();
+      ID();
+      IF();
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER) \
+    || defined(ENABLE_VIRTUAL_MEMORY)
+      }
+#ifdef ENABLE_FETCH_QUEUE
+      else {
+        HOST_PROFILE_ADVANCE(_fetchUnit);
+      }
+#endif
+#endif
+#endif
+      _commitLatches();
+
+#ifdef ENABLE_PROFILER
+      _profileCycle();
+#endif
+#ifdef ENABLE_VCD_DUMP
+      if (_vcdWriter != nullptr) {
+        _vcdWriter->sample(_currCycle);
+      }
+#endif
+#ifdef ENABLE_HOST_PROFILER
+      _hostProfiler.endCycle();
+#endif
+    }
+
+    ~PipelinedCPU() {
+#ifdef ENABLE_PARALLEL_STAGES
+      delete _stageTeam;
+#endif
+#ifdef ENABLE_FETCH_QUEUE
+      delete _fetchUnit;
+#endif
+#ifdef ENABLE_ASYNC_OUTPUT
+      delete _outputWriter; // writes out the remaining records
+#endif
+#ifdef ENABLE_VCD_DUMP
+      delete _vcdWriter;
+#endif
+#ifdef ENABLE_PIPEVIEW
+      delete _pipeView; // writes out the instructions still in flight
+#endif
+#ifdef ENABLE_PVS_ARCHIVE
+      delete _pvsArchive; // writes out the last chunk and the index
+#endif
       delete _adderPCPlus4;
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        delete _threadInstMemories[t];
+        delete _threadRegisterFiles[t];
+        delete _threadDataMemories[t];
+      }
+#else
       delete _instMemory;
-      delete _control;
       delete _registerFile;
+      delete _dataMemory;
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      delete _traceReader;
+#endif
+      delete _control;
       delete _signExtend;
       delete _adderBranchTargetAddr;
       delete _muxALUSrc;
       delete _aluControl;
       delete _alu;
+#ifdef ENABLE_MULT_DIV
+      delete _mulDivUnit;
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      delete _jumpPredictor;
+#endif
       delete _muxRegDst;
       delete _muxPCSrc;
-      delete _dataMemory;
+#ifdef ENABLE_CLOCK_DOMAINS
+      delete _coreDomain;
+      delete _memDomain;
+      delete _memoryBridge;
+#endif
+#ifdef ENABLE_STORE_BUFFER
+      delete _storeBuffer;
+#endif
+#ifdef ENABLE_PREFETCHER
+      delete _prefetcher;
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      delete _virtualMemory;
+#endif
       delete _muxMemToReg;
 #ifdef ENABLE_DATA_FORWARDING
       delete _forwardingUnit;
@@ -391,6 +1829,7 @@ class PipelinedCPU : public DigitalCircuit {
 
     // Cycle tracker
     std::uint64_t _currCycle = 0;
+    std::uint64_t _numRetired = 0; // the number of instructions that have left the WB stage
 
     // Always-1/0 wires
     const Wire<1> _alwaysHi = 1;
@@ -400,6 +1839,18 @@ class PipelinedCPU : public DigitalCircuit {
     Register<32> _PC; // the Program Counter (PC) register
     Adder<32> *_adderPCPlus4; // the 32-bit adder in the IF stage
     Memory *_instMemory; // the instruction memory
+    MUX2<32> *_muxPCSrc; // the MUX whose control signal is 'PCSrc'
+#ifdef ENABLE_FETCH_QUEUE
+    FetchUnit *_fetchUnit; // the fetch unit and its instruction queue, which replace the PC+4 adder and the MUX above
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+    TraceReader *_traceReader; // the trace reader that replaces the instruction memory
+#endif
+#ifdef ENABLE_MULTITHREADING
+    std::array<Memory *, PIPELINE_THREADS> _threadInstMemories; // the instruction memory of each thread ('_instMemory' is thread 0's)
+    std::array<RegisterFile *, PIPELINE_THREADS> _threadRegisterFiles; // the Register File of each thread ('_registerFile' is thread 0's)
+    std::array<Memory *, PIPELINE_THREADS> _threadDataMemories; // the data memory of each thread ('_dataMemory' is thread 0's)
+#endif
     // Components for the ID stage
     Control *_control; // the Control unit
     RegisterFile *_registerFile; // the Register File
@@ -409,22 +1860,44 @@ class PipelinedCPU : public DigitalCircuit {
     MUX2<32> *_muxALUSrc; // the MUX whose control signal is 'ALUSrc'
     ALUControl *_aluControl; // the ALU Control unit
     ALU *_alu; // the ALU
+#ifdef ENABLE_MULT_DIV
+    MulDivUnit *_mulDivUnit; // the multiplier and the divider, with HI and LO
+#endif
     MUX2<5> *_muxRegDst; // the MUX whose control signal is 'RegDst'
     // Components for the MEM stage
-    MUX2<32> *_muxPCSrc; // the MUX whose control signal is 'PCSrc'
     Memory *_dataMemory; // the data memory
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER)
+    DigitalCircuit *_memoryUnit; // the first unit in front of the data memory, which MEM1 evaluates
+    const Wire<1> *_memoryUnitStall; // the stall of '_memoryUnit'
+#endif
+#ifdef ENABLE_STORE_BUFFER
+    StoreBuffer *_storeBuffer; // the store buffer in front of the data memory
+#endif
+#ifdef ENABLE_PREFETCHER
+    StridePrefetcher *_prefetcher; // the stride prefetcher in front of the data memory
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+    VirtualMemory *_virtualMemory; // the iTLB and the dTLB, with the page table in the data memory
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+    MemoryBridge *_memoryBridge; // the crossing from the MEM stage to the data memory clock domain
+#endif
     // Components for the WB stage
     MUX2<32> *_muxMemToReg; // the MUX whose control signal is 'MemToReg'
 #ifdef ENABLE_DATA_FORWARDING
-    ForwardingUnit *_forwardingUnit; // the forwarding unit
-    MUX3<32> *_muxForwardA; // the 3-to-1 MUX whose control signal is 'forwardA'
-    MUX3<32> *_muxForwardB; // the 3-to-1 MUX whose control signal is 'forwardB'
+    ForwardingUnit<PIPELINE_MEM_STAGES> *_forwardingUnit; // the forwarding unit
+    MUX4<32> *_muxForwardA; // the 4-to-1 MUX whose control signal is 'forwardA'
+    MUX4<32> *_muxForwardB; // the 4-to-1 MUX whose control signal is 'forwardB'
 #ifdef ENABLE_HAZARD_DETECTION
-    HazardDetectionUnit *_hazDetUnit; // the Hazard Detection unit
+    HazardDetectionUnit<PIPELINE_MEM_STAGES> *_hazDetUnit; // the Hazard Detection unit
 #endif
 #endif
 
     // Latches
+    //   - every latch has a next value, which the stages write while they
+    //     read only the latches themselves; _commitLatches() copies the next
+    //     values into the latches at the end of the cycle, so a stage that
+    //     writes nothing into a next value (i.e., is frozen) holds its latch
     typedef struct {
       Register<1> regDst;
       Register<2> aluOp;
@@ -439,11 +1912,28 @@ class PipelinedCPU : public DigitalCircuit {
       Register<1> memToReg;
       Register<1> regWrite;
     } ControlWB_t; // the control signals for the WB stage
-    struct {
+    typedef struct {
       Register<32> pcPlus4; // PC+4
       Register<32> instruction; // 32-bit instruction
-    } _latchIFID = {}; // the IF-ID latch
-    struct {
+      Register<1> valid; // 1 if the latch holds an instruction, 0 for a bubble
+#ifdef ENABLE_MULTITHREADING
+      Register<2> thread; // the hardware thread of the instruction
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      Register<32> traceAddress; // the recorded effective address or taken-branch target
+      Register<1> traceAddressValid; // 1 if the trace recorded an address
+#endif
+#ifdef ENABLE_PIPEVIEW
+      Register<32> seqNum; // the tag of the instruction in the pipeline view
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      Register<1> jumpPredicted; // 1 if the fetch went on at a predicted jump target after the delay slots
+      Register<32> jumpPredictedTarget; // that target
+#endif
+    } IFIDLatch_t;
+    std::array<IFIDLatch_t, PIPELINE_IF_STAGES - 1> _latchIF = {}, _latchIFNext = {}; // the IF1-IF2, IF2-IF3 latches
+    IFIDLatch_t _latchIFID = {}, _latchIFIDNext = {}; // the IF-ID latch
+    typedef struct {
       ControlWB_t ctrlWB; // the control signals for the WB stage
       ControlMEM_t ctrlMEM; // the control signals for the MEM stage
       ControlEX_t ctrlEX; // the control signals for the EX stage
@@ -451,13 +1941,36 @@ class PipelinedCPU : public DigitalCircuit {
       Register<32> regFileReadData1; // 'ReadData1' from the register file
       Register<32> regFileReadData2; // 'ReadData2' from the register file
       Register<32> signExtImmediate; // the 32-bit sign-extended immediate value
-#ifdef ENABLE_DATA_FORWARDING
       Register<5> rs; // the 5-bit 'rs' field
-#endif
       Register<5> rt; // the 5-bit 'rt' field
       Register<5> rd; // the 5-bit 'rd' field
-    } _latchIDEX = {}; // the ID-EX latch
-    struct {
+      Register<1> valid; // 1 if the latch holds an instruction, 0 for a bubble
+#ifdef ENABLE_MULTITHREADING
+      Register<2> thread; // the hardware thread of the instruction
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      Register<32> traceAddress; // the recorded effective address or taken-branch target
+      Register<1> traceAddressValid; // 1 if the trace recorded an address
+#endif
+#ifdef ENABLE_MULT_DIV
+      Register<3> mulDivOp; // the MulDivUnit::Op of the instruction
+#endif
+#ifdef ENABLE_PIPEVIEW
+      Register<32> seqNum; // the tag of the instruction in the pipeline view
+#endif
+#ifdef ENABLE_JUMPS
+      Register<3> jumpOp; // the JumpPredictor::Op of the instruction
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      Register<1> jumpPredicted; // 1 if the fetch went on at a predicted jump target after the delay slots
+      Register<32> jumpPredictedTarget; // that target
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      Register<2> fusedOp; // the MacroFusion::Op of the instruction (None unless it is a fused pair)
+#endif
+    } IDEXLatch_t;
+    IDEXLatch_t _latchIDEX = {}, _latchIDEXNext = {}; // the ID-EX latch
+    typedef struct {
       ControlWB_t ctrlWB; // the control signals for the WB stage
       ControlMEM_t ctrlMEM; // the control signals for the MEM stage
       Register<32> branchTargetAddr; // the 32-bit branch target address
@@ -465,89 +1978,1344 @@ class PipelinedCPU : public DigitalCircuit {
       Register<32> aluResult; // the 32-bit ALU output
       Register<32> regFileReadData2; // 'ReadData2' from the register file
       Register<5> regDstIdx; // the index of the destination register
-    } _latchEXMEM = {}; // the EX-MEM latch
-    struct {
+      Register<1> valid; // 1 if the latch holds an instruction, 0 for a bubble
+      Register<32> pcPlus4; // PC+4
+#ifdef ENABLE_MULTITHREADING
+      Register<2> thread; // the hardware thread of the instruction
+#endif
+#ifdef ENABLE_PIPEVIEW
+      Register<32> seqNum; // the tag of the instruction in the pipeline view
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      Register<3> jumpOp; // the JumpPredictor::Op of the instruction
+      Register<1> jumpPredicted; // 1 if the fetch went on at a predicted jump target after the delay slots
+      Register<32> jumpPredictedTarget; // that target
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      Register<2> fusedOp; // the MacroFusion::Op of the instruction (None unless it is a fused pair)
+#endif
+    } EXMEMLatch_t;
+    EXMEMLatch_t _latchEXMEM = {}, _latchEXMEMNext = {}; // the EX-MEM latch
+    typedef struct {
       ControlWB_t ctrlWB; // the control signals for the WB stage
       Register<32> dataMemReadData; // the 32-bit data read from the data memory
       Register<32> aluResult; // the 32-bit ALU output
       Register<5> regDstIdx; // the index of the destination register
-    } _latchMEMWB = {}; // the MEM-WB latch
+      Register<1> valid; // 1 if the latch holds an instruction, 0 for a bubble
+      Register<32> pcPlus4; // PC+4
+#ifdef ENABLE_MULTITHREADING
+      Register<2> thread; // the hardware thread of the instruction
+#endif
+#ifdef ENABLE_PIPEVIEW
+      Register<32> seqNum; // the tag of the instruction in the pipeline view
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      Register<2> fusedOp; // the MacroFusion::Op of the instruction (None unless it is a fused pair)
+#endif
+    } MEMWBLatch_t;
+    std::array<MEMWBLatch_t, PIPELINE_MEM_STAGES - 1> _latchMEM = {}, _latchMEMNext = {}; // the MEM1-MEM2, MEM2-MEM3 latches
+    MEMWBLatch_t _latchMEMWB = {}, _latchMEMWBNext = {}; // the MEM-WB latch
+
+    // the output latch of the i-th fetch stage (IF1 is the one with the PC)
+    IFIDLatch_t &_ifOut(size_t i) {
+      return i == PIPELINE_IF_STAGES ? _latchIFID : _latchIF[i - 1];
+    }
+
+    IFIDLatch_t &_ifNext(size_t i) {
+      return i == PIPELINE_IF_STAGES ? _latchIFIDNext : _latchIFNext[i - 1];
+    }
+
+    // the output latch of the i-th MEM stage (MEM1 is the one that accesses the data memory)
+    MEMWBLatch_t &_memOut(size_t i) {
+      return i == PIPELINE_MEM_STAGES ? _latchMEMWB : _latchMEM[i - 1];
+    }
+
+    MEMWBLatch_t &_memNext(size_t i) {
+      return i == PIPELINE_MEM_STAGES ? _latchMEMWBNext : _latchMEMNext[i - 1];
+    }
+
+    // Wire<32> PipelinedCPU::_wbBypass()
+    //   - the Register File is written only when the cycle is committed, so
+    //     the value WB writes in this cycle is passed to EX here, as a read
+    //     of register 'reg' after the write would return it
+    Wire<32> _wbBypass(const Register<5> &reg, const Register<32> &readData) const {
+#ifdef ENABLE_MULTITHREADING
+      if (_latchMEMWB.thread != _latchIDEX.thread) {
+        return readData; // WB writes the registers of another thread
+      }
+#endif
+      if (_latchMEMWB.ctrlWB.regWrite.test(0) && _latchMEMWB.regDstIdx.any() && _latchMEMWB.regDstIdx == reg) {
+        return _latchMEMWB.ctrlWB.memToReg.test(0) ? _latchMEMWB.dataMemReadData : _latchMEMWB.aluResult;
+      }
+      return readData;
+    }
+
+    // void PipelinedCPU::_commitLatches()
+    //   - the clock edge: WB's write goes into the Register File, whose read
+    //     for the instruction in ID follows it, and every next value becomes
+    //     its latch
+    void _commitLatches() {
+      HOST_PROFILE_SCOPE("commit");
+#ifdef ENABLE_MULTITHREADING
+      // WB writes the registers of its own thread, and ID reads those of
+      // its own, which may be another one
+      RegisterFile *wbRegisterFile = _threadRegisterFiles[_latchMEMWB.thread.to_ulong()];
+      RegisterFile *idRegisterFile = _threadRegisterFiles[_latchIDEXNext.thread.to_ulong()];
+      if (wbRegisterFile != idRegisterFile) {
+        HOST_PROFILE_ADVANCE(wbRegisterFile);
+        const Wire<1> regWrite = _regFileRegWrite;
+        _regFileRegWrite = 0;
+        HOST_PROFILE_ADVANCE(idRegisterFile);
+        _regFileRegWrite = regWrite;
+      } else {
+        HOST_PROFILE_ADVANCE(idRegisterFile);
+      }
+#else
+      HOST_PROFILE_ADVANCE(_registerFile);
+#endif
+      _latchIF = _latchIFNext;
+      _latchIFID = _latchIFIDNext;
+      _latchIDEX = _latchIDEXNext;
+      _latchEXMEM = _latchEXMEMNext;
+      _latchMEM = _latchMEMNext;
+      _latchMEMWB = _latchMEMWBNext;
+#ifdef ENABLE_HAZARD_DETECTION
+      _evaluateHazards();
+#endif
+    }
+
+#ifdef ENABLE_HAZARD_DETECTION
+    // void PipelinedCPU::_evaluateHazards()
+    //   - the outputs of the Hazard Detection unit, which both ID and IF use,
+    //     for the cycle that starts with the current latches
+    void _evaluateHazards() {
+      _hazDetIFIDRs = _latchIFID.instruction.to_ulong() >> 21;
+      _hazDetIFIDRt = (_latchIFID.instruction.to_ulong() >> 16) & 0x1F;
+#ifdef ENABLE_MACRO_FUSION
+      // a fused add+lw loads into its 'rd'
+      _hazDetEXRegDstIdx = (_latchIDEX.fusedOp.to_ulong() == MacroFusion::AddLw) ? _latchIDEX.rd : _latchIDEX.rt;
+#endif
+#ifdef ENABLE_MULTITHREADING
+      // only a load of the same thread can hold the instruction in ID
+      _hazDetMemRead[0] = _latchIDEX.ctrlMEM.memRead.to_ulong() & (_latchIDEX.thread == _latchIFID.thread);
+      for (size_t d = 2; d <= PIPELINE_MEM_STAGES; d++) {
+        if (d == 2) {
+          _hazDetMemRead[d - 1] = _latchEXMEM.ctrlWB.memToReg.to_ulong() & (_latchEXMEM.thread == _latchIFID.thread);
+        } else {
+          _hazDetMemRead[d - 1] = _memOut(d - 2).ctrlWB.memToReg.to_ulong() & (_memOut(d - 2).thread == _latchIFID.thread);
+        }
+      }
+#endif
+#ifdef ENABLE_MULT_DIV
+      _mulDivStall = _mulDivUnit->checkStall(MulDivUnit::decode(_latchIFID.instruction.to_ulong()),
+                                             (MulDivUnit::Op)_latchIDEX.mulDivOp.to_ulong());
+#endif
+      HOST_PROFILE_ADVANCE(_hazDetUnit);
+    }
+#endif
+
+    // the PC of the instruction in a latch
+    static std::uint32_t _pcOf(const Register<32> &pcPlus4) {
+      return pcPlus4.to_ulong() - 4;
+    }
+
+    // a port in front of the data memory: the access a unit offers to the one
+    // behind it (or to the data memory), and the answer
+    typedef struct {
+      std::string unit; // the unit that drives the port
+      Wire<32> address, writeData, readData;
+      Wire<1> memRead, memWrite;
+    } MemoryPort_t;
+
+    // the same, as the unit behind the port sees it
+    typedef struct {
+      const Wire<32> *address;
+      const Wire<32> *writeData;
+      const Wire<1> *memRead;
+      const Wire<1> *memWrite;
+      Wire<32> *readData;
+    } MemoryAccess_t;
+
+    // the access of the load or the store in MEM1, as the data memory (or
+    // the first unit in front of it) sees it: with the virtual memory, at
+    // the address the dTLB translated, once it has
+    MemoryAccess_t _mem1Access() {
+#ifdef ENABLE_VIRTUAL_MEMORY
+      MemoryAccess_t access = {
+        &_dataMemPhysAddress, &_latchEXMEM.regFileReadData2, &_dTLBMemRead, &_dTLBMemWrite, &_memNext(1).dataMemReadData
+      };
+#else
+      MemoryAccess_t access = {
+        &_latchEXMEM.aluResult, &_latchEXMEM.regFileReadData2, &_latchEXMEM.ctrlMEM.memRead, &_latchEXMEM.ctrlMEM.memWrite,
+        &_memNext(1).dataMemReadData
+      };
+#endif
+      return access;
+    }
+
+    // adds the port 'unit' drives, and returns it as the unit behind it sees
+    // it (the ports are kept in a deque, which never moves them)
+    MemoryAccess_t _addMemoryPort(const std::string &unit) {
+      _memoryPorts.emplace_back();
+      MemoryPort_t &port = _memoryPorts.back();
+      port.unit = unit;
+      MemoryAccess_t access = { &port.address, &port.writeData, &port.memRead, &port.memWrite, &port.readData };
+      return access;
+    }
+
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_CLOCK_DOMAINS) || defined(ENABLE_PREFETCHER) \
+    || defined(ENABLE_VIRTUAL_MEMORY)
+    // the stall of the MEM stage, which freezes EX, ID, and IF: the dTLB's,
+    // which it also asserts for the units behind it, or else the first
+    // unit's, which it also asserts for the ones behind it
+    const Wire<1> &_memStall() const {
+#ifdef ENABLE_VIRTUAL_MEMORY
+      return _dTLBStall;
+#else
+      return *_memoryUnitStall;
+#endif
+    }
+#endif
+
+    // true if a latch holds an instruction loaded into the instruction memory
+    template<typename Latch>
+    bool _isLoadedInFlight(const Latch &latch) const {
+      if (!latch.valid.test(0)) {
+        return false;
+      }
+#ifdef ENABLE_MULTITHREADING
+      return _threadInstMemories[latch.thread.to_ulong()]->isLoaded(_pcOf(latch.pcPlus4));
+#else
+      return _instMemory->isLoaded(_instAddressOf(_pcOf(latch.pcPlus4)));
+#endif
+    }
+
+    // the address of the instruction memory the word at 'pc' is fetched
+    // from
+    std::uint32_t _instAddressOf(const std::uint32_t pc) const {
+#ifdef ENABLE_VIRTUAL_MEMORY
+      return _virtualMemory->probe(pc);
+#else
+      return pc;
+#endif
+    }
+
+    typedef struct {
+      size_t numDelaySlotsLeft; // the delay slots still fetched before the jump
+      std::uint32_t target;
+#ifdef ENABLE_JUMP_PREDICTION
+      bool predicted; // true for a jump predicted at its fetch, false for one resolved in MEM
+#endif
+    } Redirect_t; // a taken branch whose delay slots are not all fetched yet
+#if !defined(ENABLE_FETCH_QUEUE) && !defined(ENABLE_MULTITHREADING)
+    std::vector<Redirect_t> _redirects; // the pending jumps, oldest first
+#endif
+
+#ifdef ENABLE_MULTITHREADING
+    // Hardware threads
+    //   - each thread fetches on its own PC; '_PC' and '_pcPlus4' are those
+    //     of the thread IF fetches from in the current cycle
+    std::array<Register<32>, PIPELINE_THREADS> _threadPC; // the address each thread last fetched from
+    std::array<std::uint32_t, PIPELINE_THREADS> _threadNextPC; // the address each thread fetches from next
+    std::array<std::vector<Redirect_t>, PIPELINE_THREADS> _threadRedirects; // the pending jumps of each thread, oldest first
+    size_t _fetchThread; // the thread IF fetched from last
+    bool _switchThread; // true if the fetch moves on to another thread (THREAD_POLICY_SWITCH_ON_STALL)
+    std::array<std::uint64_t, PIPELINE_THREADS> _threadNumFetched; // the instructions fetched for each thread
+    std::array<std::uint64_t, PIPELINE_THREADS> _threadNumRetired; // the instructions of each thread that have left WB
+    std::uint64_t _numIdleCycles; // the cycles in which no instruction left WB
+    std::uint64_t _numLoadUseStallCycles; // the cycles in which IF waited for a load-use stall in ID
+
+    // std::vector<std::string> PipelinedCPU::_splitFileNames()
+    //   - the file of each thread in a comma-separated list; a single file
+    //     (or none) is loaded by every thread
+    static std::vector<std::string> _splitFileNames(const char *fileNames) {
+      if (fileNames == nullptr) {
+        return std::vector<std::string>(PIPELINE_THREADS);
+      }
+      std::vector<std::string> names;
+      const std::string list = fileNames;
+      size_t begin = 0;
+      while (true) {
+        const size_t end = list.find(',', begin);
+        names.push_back(list.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos) {
+          break;
+        }
+        begin = end + 1;
+      }
+      if (names.size() == 1) {
+        names.assign(PIPELINE_THREADS, names[0]);
+      }
+      if (names.size() != PIPELINE_THREADS) {
+        fprintf(stderr, "[%s] ERROR: %s lists %lu files for %d threads\n",
+                __func__, fileNames, (unsigned long)names.size(), PIPELINE_THREADS);
+        assert(false);
+      }
+      return names;
+    }
+
+    static const char *_fileNameOf(const std::string &name) {
+      return name.empty() ? nullptr : name.c_str();
+    }
+
+    // void PipelinedCPU::_resetThreads()
+    //   - every thread starts at 'initialPC', as the single thread would
+    void _resetThreads(const std::uint32_t initialPC) {
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _threadPC[t] = initialPC;
+        _threadNextPC[t] = initialPC + 4;
+        _threadRedirects[t].clear();
+        _threadNumFetched[t] = 0;
+        _threadNumRetired[t] = 0;
+      }
+      // the first fetch is from thread 0 under every policy
+      _fetchThread = PIPELINE_THREADS - 1;
+      _switchThread = true;
+      _numIdleCycles = 0;
+      _numLoadUseStallCycles = 0;
+    }
+
+    // bool PipelinedCPU::_isThreadFetching()
+    //   - false once a thread has run off the end of its code (until a
+    //     branch of its own in flight takes it back)
+    bool _isThreadFetching(size_t thread) const {
+      return !_threadRedirects[thread].empty() || _threadInstMemories[thread]->isLoaded(_threadNextPC[thread]);
+    }
+
+    // size_t PipelinedCPU::_selectThread()
+    //   - the thread IF fetches from, under THREAD_POLICY; the threads are
+    //     considered in turn from the one after the last fetched from, and
+    //     those past the end of their code only when no thread is left
+    size_t _selectThread() {
+      std::array<size_t, PIPELINE_THREADS> candidates;
+      size_t numCandidates = 0;
+      for (size_t i = 1; i <= PIPELINE_THREADS; i++) {
+        const size_t t = (_fetchThread + i) % PIPELINE_THREADS;
+        if (_isThreadFetching(t)) {
+          candidates[numCandidates++] = t;
+        }
+      }
+      if (numCandidates == 0) {
+        return (_fetchThread + 1) % PIPELINE_THREADS;
+      }
+#if THREAD_POLICY == THREAD_POLICY_SWITCH_ON_STALL
+      // the last thread is the last candidate, which is kept until it stalls
+      const bool switchThread = _switchThread;
+      _switchThread = false;
+      if (!switchThread && candidates[numCandidates - 1] == _fetchThread) {
+        return _fetchThread;
+      }
+      return candidates[0];
+#elif THREAD_POLICY == THREAD_POLICY_ICOUNT
+      // the instructions each thread has in ID and EX
+      std::array<size_t, PIPELINE_THREADS> counts = {};
+      if (_latchIFID.valid.test(0)) {
+        counts[_latchIFID.thread.to_ulong()] += 1;
+      }
+      if (_latchIDEX.valid.test(0)) {
+        counts[_latchIDEX.thread.to_ulong()] += 1;
+      }
+      size_t best = candidates[0];
+      for (size_t i = 1; i < numCandidates; i++) {
+        if (counts[candidates[i]] < counts[best]) {
+          best = candidates[i];
+        }
+      }
+      return best;
+#else
+      return candidates[0];
+#endif
+    }
+#endif
 
     // Wires
     Wire<32> _adderPCPlus4Input1; // the second input to the adder in the IF stage (i.e., 4)
     Wire<32> _pcPlus4; // the output of the adder in the IF stage
     Wire<6> _opcode; // the input to the Control unit
+    Wire<1> _regFileRegWrite; // 'RegWrite' for the Register File (only set by WB)
     Wire<5> _regFileReadRegister1; // 'ReadRegister1' for the Register File
     Wire<5> _regFileReadRegister2; // 'ReadRegister2' for the Register File
     Wire<32> _muxMemToRegOutput; // the output of the MUX whose control signal is 'MemToReg'
     Wire<16> _signExtendInput; // the input to the sign-extend unit
     Wire<32> _adderBranchTargetAddrInput1; // the second input to the adder in the EX stage
+    Wire<32> _exReadData1, _exReadData2; // the register operands in the EX stage, after the bypass of WB's write
     Wire<32> _muxALUSrcOutput; // the output of the MUX whose control signal is 'ALUSrc'
     Wire<6> _aluControlInput; // the input to the ALU Control unit (i.e., the 'funct' field)
     Wire<4> _aluControlOutput; // the output of the ALU Control unit
     Wire<1> _muxPCSrcSelect; // the control signal (a.k.a. selector) for the MUX whose control signal is 'PCSrc'
+#ifdef ENABLE_TRACE_DRIVEN
+    Wire<32> _tracePC; // the recorded address of the instruction fetched from the trace
+#endif
+    std::deque<MemoryPort_t> _memoryPorts; // the port each unit in front of the data memory drives, from MEM1's side (the last is the data memory's)
+#ifdef ENABLE_STORE_BUFFER
+    Wire<1> _storeBufferStall; // asserted when the MEM stage must wait for the store buffer, or a unit behind it
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+    Wire<1> _memoryBridgeStall; // asserted when the MEM stage must wait for the data memory
+#endif
+#ifdef ENABLE_PREFETCHER
+    Wire<1> _prefetcherStall; // asserted when the MEM stage must wait for the data memory
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+    Wire<32> _instMemPhysAddress; // the PC, translated by the iTLB
+    Wire<32> _dataMemPhysAddress; // the address of the load or the store in MEM1, translated by the dTLB
+    Wire<1> _dTLBMemRead, _dTLBMemWrite; // 'MemRead' and 'MemWrite' of MEM1, once the dTLB has translated the address
+    Wire<1> _dTLBStall; // asserted when the MEM stage must wait for a walk that refills the dTLB, or for a unit behind the dTLB
+    bool _dTLBTranslated = false; // true once the access in MEM1 is translated, until MEM1 takes the next one
+#endif
 #ifdef ENABLE_DATA_FORWARDING
     Wire<2> _forwardA, _forwardB; // the outputs from the Forwarding unit
-    Wire<32> _muxForwardAOutput; // the output of the 3-to-1 MUX whose control signal is 'forwardA'
-    Wire<32> _muxForwardBOutput; // the output of the 3-to-1 MUX whose control signal is 'forwardB'
+    Wire<32> _muxForwardAOutput; // the output of the 4-to-1 MUX whose control signal is 'forwardA'
+    Wire<32> _muxForwardBOutput; // the output of the 4-to-1 MUX whose control signal is 'forwardB'
+#ifdef ENABLE_MULTITHREADING
+    std::array<Wire<1>, PIPELINE_MEM_STAGES> _forwardRegWrite; // 'RegWrite' of each producer, if it is of the consumer's thread
+#endif
 #ifdef ENABLE_HAZARD_DETECTION
     Wire<5> _hazDetIFIDRs, _hazDetIFIDRt; // the inputs to the Hazard Detection unit
     Wire<1> _hazDetPCWrite, _hazDetIFIDWrite, _hazDetIDEXCtrlWrite; // the outputs of the Hazard Detection unit
+#ifdef ENABLE_MULTITHREADING
+    std::array<Wire<1>, PIPELINE_MEM_STAGES> _hazDetMemRead; // 'MemRead' of each load, if it is of the thread in ID
+#endif
+#ifdef ENABLE_MACRO_FUSION
+    Wire<5> _hazDetEXRegDstIdx; // the register the load in EX writes ('rt', or 'rd' for a fused add+lw)
+#endif
+#endif
+#endif
+#ifdef ENABLE_MULT_DIV
+    Wire<32> _mulDivResult; // the HI or LO read by the mfhi/mflo in EX
+    Wire<2> _mulDivStall; // the MulDivUnit::Stall of the instruction in ID, an input to the Hazard Detection unit
+#endif
+
+    // Wire registry
+    WireRegistry _wireRegistry; // every wire and latch field, by hierarchical name
+#ifdef ENABLE_VCD_DUMP
+    VCDWriter *_vcdWriter = nullptr; // the VCD writer, if a dump has been opened
+#endif
+#ifdef ENABLE_PARALLEL_STAGES
+    StageTeam *_stageTeam; // the host threads that run the five stages
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+    ClockScheduler _clockScheduler; // the timeline of the clock domains
+    ClockDomain *_coreDomain; // the clock of the stages
+    ClockDomain *_memDomain; // the clock of the data memory
+#endif
+#ifdef ENABLE_HOST_PROFILER
+    HostProfiler _hostProfiler; // the host time the stages and the components take
+#endif
+
+    void _registerIFIDLatch(const std::string &name, const IFIDLatch_t &latch) {
+      _wireRegistry.add(name + ".pcPlus4", &latch.pcPlus4);
+      _wireRegistry.add(name + ".instruction", &latch.instruction);
+      _wireRegistry.add(name + ".valid", &latch.valid);
+#ifdef ENABLE_MULTITHREADING
+      _wireRegistry.add(name + ".thread", &latch.thread);
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      _wireRegistry.add(name + ".traceAddress", &latch.traceAddress);
+      _wireRegistry.add(name + ".traceAddressValid", &latch.traceAddressValid);
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _wireRegistry.add(name + ".seqNum", &latch.seqNum);
 #endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _wireRegistry.add(name + ".jumpPredicted", &latch.jumpPredicted);
+      _wireRegistry.add(name + ".jumpPredictedTarget", &latch.jumpPredictedTarget);
 #endif
+    }
+
+    void _registerMEMWBLatch(const std::string &name, const MEMWBLatch_t &latch) {
+      _wireRegistry.add(name + ".ctrlWB.memToReg", &latch.ctrlWB.memToReg);
+      _wireRegistry.add(name + ".ctrlWB.regWrite", &latch.ctrlWB.regWrite);
+      _wireRegistry.add(name + ".dataMemReadData", &latch.dataMemReadData);
+      _wireRegistry.add(name + ".aluResult", &latch.aluResult);
+      _wireRegistry.add(name + ".regDstIdx", &latch.regDstIdx);
+      _wireRegistry.add(name + ".valid", &latch.valid);
+#ifdef ENABLE_MULTITHREADING
+      _wireRegistry.add(name + ".thread", &latch.thread);
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _wireRegistry.add(name + ".seqNum", &latch.seqNum);
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _wireRegistry.add(name + ".fusedOp", &latch.fusedOp);
+#endif
+    }
+
+    void _registerWires() {
+      _wireRegistry.add("PC", &_PC);
+      _wireRegistry.add("pcPlus4", &_pcPlus4);
+      _wireRegistry.add("opcode", &_opcode);
+      _wireRegistry.add("regFileReadRegister1", &_regFileReadRegister1);
+      _wireRegistry.add("regFileReadRegister2", &_regFileReadRegister2);
+      _wireRegistry.add("muxMemToRegOutput", &_muxMemToRegOutput);
+      _wireRegistry.add("signExtendInput", &_signExtendInput);
+      _wireRegistry.add("adderBranchTargetAddrInput1", &_adderBranchTargetAddrInput1);
+      _wireRegistry.add("exReadData1", &_exReadData1);
+      _wireRegistry.add("exReadData2", &_exReadData2);
+      _wireRegistry.add("muxALUSrcOutput", &_muxALUSrcOutput);
+      _wireRegistry.add("aluControlInput", &_aluControlInput);
+      _wireRegistry.add("aluControlOutput", &_aluControlOutput);
+      _wireRegistry.add("muxPCSrcSelect", &_muxPCSrcSelect);
+#ifdef ENABLE_TRACE_DRIVEN
+      _wireRegistry.add("tracePC", &_tracePC);
+#endif
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _wireRegistry.add("thread" + std::to_string(t) + ".PC", &_threadPC[t]);
+      }
+#endif
+      // the port of the data memory keeps its name, and the ones between the
+      // units are named after the unit that drives them
+      for (MemoryPort_t &port : _memoryPorts) {
+        const std::string prefix = (&port == &_memoryPorts.back()) ? "dataMem" : port.unit + ".mem";
+        _wireRegistry.add(prefix + "Address", &port.address);
+        _wireRegistry.add(prefix + "WriteData", &port.writeData);
+        _wireRegistry.add(prefix + "ReadData", &port.readData);
+        _wireRegistry.add(prefix + "Read", &port.memRead);
+        _wireRegistry.add(prefix + "Write", &port.memWrite);
+      }
+#ifdef ENABLE_STORE_BUFFER
+      _wireRegistry.add("storeBufferStall", &_storeBufferStall);
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+      _wireRegistry.add("memoryBridgeStall", &_memoryBridgeStall);
+#endif
+#ifdef ENABLE_PREFETCHER
+      _wireRegistry.add("prefetcherStall", &_prefetcherStall);
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      _wireRegistry.add("instMemPhysAddress", &_instMemPhysAddress);
+      _wireRegistry.add("dataMemPhysAddress", &_dataMemPhysAddress);
+      _wireRegistry.add("dTLBMemRead", &_dTLBMemRead);
+      _wireRegistry.add("dTLBMemWrite", &_dTLBMemWrite);
+      _wireRegistry.add("dTLBStall", &_dTLBStall);
+#endif
+#ifdef ENABLE_DATA_FORWARDING
+      _wireRegistry.add("forwardA", &_forwardA);
+      _wireRegistry.add("forwardB", &_forwardB);
+      _wireRegistry.add("muxForwardAOutput", &_muxForwardAOutput);
+      _wireRegistry.add("muxForwardBOutput", &_muxForwardBOutput);
+#ifdef ENABLE_MULTITHREADING
+      for (size_t d = 1; d <= PIPELINE_MEM_STAGES; d++) {
+        _wireRegistry.add("forwardRegWrite" + std::to_string(d), &_forwardRegWrite[d - 1]);
+      }
+#endif
+#ifdef ENABLE_HAZARD_DETECTION
+      _wireRegistry.add("hazDetIFIDRs", &_hazDetIFIDRs);
+      _wireRegistry.add("hazDetIFIDRt", &_hazDetIFIDRt);
+      _wireRegistry.add("hazDetPCWrite", &_hazDetPCWrite);
+      _wireRegistry.add("hazDetIFIDWrite", &_hazDetIFIDWrite);
+      _wireRegistry.add("hazDetIDEXCtrlWrite", &_hazDetIDEXCtrlWrite);
+#ifdef ENABLE_MULTITHREADING
+      for (size_t d = 1; d <= PIPELINE_MEM_STAGES; d++) {
+        _wireRegistry.add("hazDetMemRead" + std::to_string(d), &_hazDetMemRead[d - 1]);
+      }
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _wireRegistry.add("hazDetEXRegDstIdx", &_hazDetEXRegDstIdx);
+#endif
+#endif
+#endif
+#ifdef ENABLE_MULT_DIV
+      _wireRegistry.add("mulDivResult", &_mulDivResult);
+      _wireRegistry.add("mulDivStall", &_mulDivStall);
+#endif
+
+      for (size_t i = 1; i < PIPELINE_IF_STAGES; i++) {
+        _registerIFIDLatch("latchIF" + std::to_string(i) + "IF" + std::to_string(i + 1), _latchIF[i - 1]);
+      }
+      _registerIFIDLatch("latchIFID", _latchIFID);
+
+      _wireRegistry.add("latchIDEX.ctrlWB.memToReg", &_latchIDEX.ctrlWB.memToReg);
+      _wireRegistry.add("latchIDEX.ctrlWB.regWrite", &_latchIDEX.ctrlWB.regWrite);
+      _wireRegistry.add("latchIDEX.ctrlMEM.branch", &_latchIDEX.ctrlMEM.branch);
+      _wireRegistry.add("latchIDEX.ctrlMEM.memRead", &_latchIDEX.ctrlMEM.memRead);
+      _wireRegistry.add("latchIDEX.ctrlMEM.memWrite", &_latchIDEX.ctrlMEM.memWrite);
+      _wireRegistry.add("latchIDEX.ctrlEX.regDst", &_latchIDEX.ctrlEX.regDst);
+      _wireRegistry.add("latchIDEX.ctrlEX.aluOp", &_latchIDEX.ctrlEX.aluOp);
+      _wireRegistry.add("latchIDEX.ctrlEX.aluSrc", &_latchIDEX.ctrlEX.aluSrc);
+      _wireRegistry.add("latchIDEX.pcPlus4", &_latchIDEX.pcPlus4);
+      _wireRegistry.add("latchIDEX.regFileReadData1", &_latchIDEX.regFileReadData1);
+      _wireRegistry.add("latchIDEX.regFileReadData2", &_latchIDEX.regFileReadData2);
+      _wireRegistry.add("latchIDEX.signExtImmediate", &_latchIDEX.signExtImmediate);
+      _wireRegistry.add("latchIDEX.rs", &_latchIDEX.rs);
+      _wireRegistry.add("latchIDEX.rt", &_latchIDEX.rt);
+      _wireRegistry.add("latchIDEX.rd", &_latchIDEX.rd);
+      _wireRegistry.add("latchIDEX.valid", &_latchIDEX.valid);
+#ifdef ENABLE_MULTITHREADING
+      _wireRegistry.add("latchIDEX.thread", &_latchIDEX.thread);
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      _wireRegistry.add("latchIDEX.traceAddress", &_latchIDEX.traceAddress);
+      _wireRegistry.add("latchIDEX.traceAddressValid", &_latchIDEX.traceAddressValid);
+#endif
+#ifdef ENABLE_MULT_DIV
+      _wireRegistry.add("latchIDEX.mulDivOp", &_latchIDEX.mulDivOp);
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _wireRegistry.add("latchIDEX.seqNum", &_latchIDEX.seqNum);
+#endif
+#ifdef ENABLE_JUMPS
+      _wireRegistry.add("latchIDEX.jumpOp", &_latchIDEX.jumpOp);
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _wireRegistry.add("latchIDEX.fusedOp", &_latchIDEX.fusedOp);
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _wireRegistry.add("latchIDEX.jumpPredicted", &_latchIDEX.jumpPredicted);
+      _wireRegistry.add("latchIDEX.jumpPredictedTarget", &_latchIDEX.jumpPredictedTarget);
+#endif
+
+      _wireRegistry.add("latchEXMEM.ctrlWB.memToReg", &_latchEXMEM.ctrlWB.memToReg);
+      _wireRegistry.add("latchEXMEM.ctrlWB.regWrite", &_latchEXMEM.ctrlWB.regWrite);
+      _wireRegistry.add("latchEXMEM.ctrlMEM.branch", &_latchEXMEM.ctrlMEM.branch);
+      _wireRegistry.add("latchEXMEM.ctrlMEM.memRead", &_latchEXMEM.ctrlMEM.memRead);
+      _wireRegistry.add("latchEXMEM.ctrlMEM.memWrite", &_latchEXMEM.ctrlMEM.memWrite);
+      _wireRegistry.add("latchEXMEM.branchTargetAddr", &_latchEXMEM.branchTargetAddr);
+      _wireRegistry.add("latchEXMEM.aluZero", &_latchEXMEM.aluZero);
+      _wireRegistry.add("latchEXMEM.aluResult", &_latchEXMEM.aluResult);
+      _wireRegistry.add("latchEXMEM.regFileReadData2", &_latchEXMEM.regFileReadData2);
+      _wireRegistry.add("latchEXMEM.regDstIdx", &_latchEXMEM.regDstIdx);
+      _wireRegistry.add("latchEXMEM.valid", &_latchEXMEM.valid);
+#ifdef ENABLE_MULTITHREADING
+      _wireRegistry.add("latchEXMEM.thread", &_latchEXMEM.thread);
+#endif
+#ifdef ENABLE_PIPEVIEW
+      _wireRegistry.add("latchEXMEM.seqNum", &_latchEXMEM.seqNum);
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _wireRegistry.add("latchEXMEM.jumpOp", &_latchEXMEM.jumpOp);
+      _wireRegistry.add("latchEXMEM.jumpPredicted", &_latchEXMEM.jumpPredicted);
+      _wireRegistry.add("latchEXMEM.jumpPredictedTarget", &_latchEXMEM.jumpPredictedTarget);
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _wireRegistry.add("latchEXMEM.fusedOp", &_latchEXMEM.fusedOp);
+#endif
+
+      for (size_t i = 1; i < PIPELINE_MEM_STAGES; i++) {
+        _registerMEMWBLatch("latchMEM" + std::to_string(i) + "MEM" + std::to_string(i + 1), _latchMEM[i - 1]);
+      }
+      _registerMEMWBLatch("latchMEMWB", _latchMEMWB);
+    }
+
+#ifdef ENABLE_PROFILER
+    // Profiler
+    Profiler _profiler; // the profile of the simulated program
+    std::uint32_t _profBranchPC = 0; // the PC of the branch in MEM in the current cycle
+
+    // void PipelinedCPU::_profileStages()
+    //   - at the beginning of a cycle, each stage works on the instruction in
+    //     its input latch (IF1 is profiled when it fetches)
+    void _profileStages() {
+      for (size_t i = 0; i + 1 < PIPELINE_IF_STAGES; i++) {
+        if (_latchIF[i].valid.test(0)) {
+          _profiler.occupy(Profiler::IF, _pcOf(_latchIF[i].pcPlus4));
+        }
+      }
+#ifdef ENABLE_FETCH_QUEUE
+      for (const FetchUnit::Entry &entry : _fetchUnit->getQueue()) {
+        _profiler.occupy(Profiler::IF, entry.pc);
+      }
+#endif
+      if (_latchIFID.valid.test(0)) {
+        _profiler.occupy(Profiler::ID, _pcOf(_latchIFID.pcPlus4));
+      }
+      if (_latchIDEX.valid.test(0)) {
+        _profiler.occupy(Profiler::EX, _pcOf(_latchIDEX.pcPlus4));
+      }
+      if (_latchEXMEM.valid.test(0)) {
+        _profiler.occupy(Profiler::MEM, _pcOf(_latchEXMEM.pcPlus4));
+      }
+      for (size_t i = 0; i + 1 < PIPELINE_MEM_STAGES; i++) {
+        if (_latchMEM[i].valid.test(0)) {
+          _profiler.occupy(Profiler::MEM, _pcOf(_latchMEM[i].pcPlus4));
+        }
+      }
+      if (_latchMEMWB.valid.test(0)) {
+        _profiler.occupy(Profiler::WB, _pcOf(_latchMEMWB.pcPlus4));
+      }
+      _profRetiring = _latchMEMWB.valid.test(0);
+      _profRetiringPC = _pcOf(_latchMEMWB.pcPlus4);
+    }
+    bool _profRetiring = false; // true if an instruction leaves WB in the current cycle
+    std::uint32_t _profRetiringPC = 0; // the PC of that instruction
+
+    // void PipelinedCPU::_profileCycle()
+    //   - charges the cycle to the retiring instruction, or else to the
+    //     oldest instruction still in flight, which the pipeline waits for
+    void _profileCycle() {
+      if (_profRetiring) {
+        _profiler.charge(_profRetiringPC);
+        return;
+      }
+      for (size_t i = PIPELINE_MEM_STAGES; i >= 1; i--) {
+        if (_memOut(i).valid.test(0)) {
+          _profiler.charge(_pcOf(_memOut(i).pcPlus4));
+          return;
+        }
+      }
+      if (_latchEXMEM.valid.test(0)) {
+        _profiler.charge(_pcOf(_latchEXMEM.pcPlus4));
+        return;
+      }
+      if (_latchIDEX.valid.test(0)) {
+        _profiler.charge(_pcOf(_latchIDEX.pcPlus4));
+        return;
+      }
+      for (size_t i = PIPELINE_IF_STAGES; i >= 1; i--) {
+        if (_ifOut(i).valid.test(0)) {
+          _profiler.charge(_pcOf(_ifOut(i).pcPlus4));
+          return;
+        }
+      }
+      _profiler.chargeIdle();
+    }
+#endif
+
+#ifdef ENABLE_JUMP_PREDICTION
+    // Jump prediction
+    JumpPredictor *_jumpPredictor; // the return-address stack and the indirect target cache
+
+    // void PipelinedCPU::_predictJump()
+    //   - the instruction IF1 has just fetched into 'latch' goes on at its
+    //     predicted target, if any, after its delay slots
+    void _predictJump(IFIDLatch_t &latch) {
+      std::uint32_t target = 0;
+      const bool predicted = _jumpPredictor->predict(_pcOf(latch.pcPlus4), latch.instruction.to_ulong(), target);
+      latch.jumpPredicted = predicted;
+      latch.jumpPredictedTarget = target;
+      if (!predicted) {
+        return;
+      }
+      if (FETCH_BRANCH_DELAY_SLOTS == 0) {
+        _pcPlus4 = target;
+      } else {
+        const Redirect_t redirect = { FETCH_BRANCH_DELAY_SLOTS, target, true };
+        _redirects.push_back(redirect);
+      }
+    }
+
+    // void PipelinedCPU::_recoverJumpPredictor()
+    //   - a branch taken in MEM1 (a beq, or a jump predicted wrong or not at
+    //     all) squashes the instructions marked in 'squash', so the pending
+    //     predictions are dropped: the delay slots kept have their jumps
+    //     resolved as not predicted, and the return-address stack is rebuilt
+    //     from them, oldest first
+    void _recoverJumpPredictor(const std::array<bool, PIPELINE_IF_STAGES> &squash) {
+      for (size_t i = _redirects.size(); i > 0; i--) {
+        if (_redirects[i - 1].predicted) {
+          _redirects.erase(_redirects.begin() + (i - 1));
+        }
+      }
+      _latchEXMEMNext.jumpPredicted = 0;
+      _latchIDEXNext.jumpPredicted = 0;
+      for (size_t i = 1; i <= PIPELINE_IF_STAGES; i++) {
+        _ifOut(i).jumpPredicted = 0;
+        _ifNext(i).jumpPredicted = 0;
+      }
+      _jumpPredictor->recover();
+      if (_latchIDEX.valid.test(0)) {
+        _jumpPredictor->replay((JumpPredictor::Op)_latchIDEX.jumpOp.to_ulong(), _pcOf(_latchIDEX.pcPlus4));
+      }
+      for (size_t i = PIPELINE_IF_STAGES; i >= 1; i--) {
+        if (_ifOut(i).valid.test(0) && (i == PIPELINE_IF_STAGES || !squash[i])) {
+          _jumpPredictor->replay(JumpPredictor::decode(_ifOut(i).instruction.to_ulong()), _pcOf(_ifOut(i).pcPlus4));
+        }
+      }
+    }
+#endif
+
+#ifdef ENABLE_MACRO_FUSION
+    // Macro-op fusion
+    MacroFusion _macroFusion; // the pairs ID fuses, and their statistics
+
+    // void PipelinedCPU::_fuse()
+    //   - ID decodes the instruction in the IF-ID latch together with the
+    //     word after it, which IF is about to fetch; if the two are a pair
+    //     to fuse, ID issues them as one operation and IF fetches the word
+    //     after the pair instead
+    //   - the pair is not fused (and the second instruction is fetched and
+    //     issued as usual) if a branch taken in MEM1 or a pending redirect
+    //     may turn the fetch away, or if there is a branch in EX, as its
+    //     delay slots are counted in instructions; it waits while ID stalls
+    void _fuse() {
+      _latchIDEXNext.fusedOp = MacroFusion::None;
+      if (!_latchIFID.valid.test(0)) {
+        return;
+      }
+#ifdef ENABLE_HAZARD_DETECTION
+      if (_hazDetIDEXCtrlWrite.to_ulong() == 0) {
+        return;
+      }
+#endif
+      const std::uint32_t secondPC = _latchIFID.pcPlus4.to_ulong();
+      // with the virtual memory, the word is found through the page table,
+      // and not through the iTLB, as it is not fetched
+      const std::uint32_t second = _instMemory->readWord(_instAddressOf(secondPC));
+      const MacroFusion::Op op = MacroFusion::match(_latchIFID.instruction.to_ulong(), second, FUSION_PAIRS);
+      if (op == MacroFusion::None) {
+        return;
+      }
+      const bool sequential = _redirects.empty() && _pcPlus4.to_ulong() == secondPC
+                              && !(_latchEXMEM.ctrlMEM.branch.test(0) && _latchEXMEM.aluZero.test(0))
+                              && !(_latchIDEX.valid.test(0) && _latchIDEX.ctrlMEM.branch.test(0));
+      if (!_macroFusion.issue(op, sequential)) {
+        return;
+      }
+      _latchIDEXNext.fusedOp = op;
+      _latchIDEXNext.pcPlus4 = secondPC + 4;
+      _latchIDEXNext.signExtImmediate = (std::uint32_t)(std::int32_t)(std::int16_t)(second & 0xFFFF);
+      _latchIDEXNext.ctrlEX.regDst = 1;
+      _latchIDEXNext.ctrlEX.aluSrc = 0;
+      _latchIDEXNext.ctrlWB.regWrite = 1;
+      _latchIDEXNext.ctrlMEM.memWrite = 0;
+      if (op == MacroFusion::AddLw) {
+        // the ALU adds the registers, and EX adds the immediate to the sum
+        _latchIDEXNext.ctrlEX.aluOp = 0b00;
+        _latchIDEXNext.ctrlWB.memToReg = 1;
+        _latchIDEXNext.ctrlMEM.memRead = 1;
+        _latchIDEXNext.ctrlMEM.branch = 0;
+      } else {
+        // the ALU compares the registers, and the branch is taken on 'Zero'
+        _latchIDEXNext.ctrlEX.aluOp = 0b10;
+        _latchIDEXNext.ctrlWB.memToReg = 0;
+        _latchIDEXNext.ctrlMEM.memRead = 0;
+        _latchIDEXNext.ctrlMEM.branch = 1;
+      }
+      _pcPlus4 = secondPC + 4;
+    }
+#endif
+
+#ifdef ENABLE_TIMING_MODEL
+    // Timing model
+    TimingModel _timingModel; // the components of each stage, their delays, and the wires they read and drive
+
+    // void PipelinedCPU::_buildTimingModel()
+    //   - the components of each stage in the order the stage evaluates
+    //     them, with the wires they read and drive: a circuit brings the
+    //     wires the constructor gave it, and the logic a stage computes by
+    //     itself names the members it reads and writes
+    //   - an access to the instruction (data) memory is spread over the IF
+    //     (MEM) stages, so each of them takes its share of the memory delay
+    void _buildTimingModel() {
+      TimingModel &tm = _timingModel;
+      std::array<std::string, PIPELINE_IF_STAGES> ifStage;
+      std::array<std::string, PIPELINE_MEM_STAGES> memStage;
+      for (size_t i = 1; i <= PIPELINE_IF_STAGES; i++) {
+        ifStage[i - 1] = PIPELINE_IF_STAGES == 1 ? std::string("IF") : "IF" + std::to_string(i);
+        tm.addStage(ifStage[i - 1]);
+      }
+      tm.addStage("ID");
+      tm.addStage("EX");
+      for (size_t i = 1; i <= PIPELINE_MEM_STAGES; i++) {
+        memStage[i - 1] = PIPELINE_MEM_STAGES == 1 ? std::string("MEM") : "MEM" + std::to_string(i);
+        tm.addStage(memStage[i - 1]);
+      }
+      tm.addStage("WB");
+
+      // IF: 'PCSrc' is the AND of 'Branch' and 'Zero' in the EX-MEM latch,
+      // and the new PC goes to the adder and the instruction memory
+      const std::string &if1 = ifStage[0];
+      const std::string &ifn = ifStage[PIPELINE_IF_STAGES - 1];
+      const double instMemoryDelay = (double)TIMING_MEMORY_PS / PIPELINE_IF_STAGES;
+      tm.add(if1, "andPCSrc", TIMING_GATE_PS,
+             { &_latchEXMEM.ctrlMEM.branch, &_latchEXMEM.aluZero }, { &_muxPCSrcSelect });
+#ifdef ENABLE_JUMP_PREDICTION
+      // a jump whose target was predicted right keeps the PC mux at PC+4
+      tm.add(if1, "jumpResolve", TimingModel::comparatorDelay(32),
+             { &_muxPCSrcSelect, &_latchEXMEM.branchTargetAddr, &_latchEXMEM.jumpPredictedTarget }, { &_muxPCSrcSelect });
+#endif
+#ifdef ENABLE_FETCH_QUEUE
+      // IF takes the oldest instruction of the queue (which a taken branch
+      // empties), and the fetch unit fills it from the instruction memory
+      // at a PC of its own
+      tm.add(if1, "fetchQueue", TIMING_BUFFER_LOOKUP_PS,
+             { &_muxPCSrcSelect, &_latchEXMEM.branchTargetAddr }, { &_latchIFIDNext.instruction, &_latchIFIDNext.pcPlus4 });
+#elif defined(ENABLE_MULTITHREADING)
+      // the PC of the thread IF fetches from, which a taken branch of that
+      // thread redirects
+      tm.add(if1, "muxThreadPC", TIMING_MUX4_PS,
+             { &_muxPCSrcSelect, &_latchEXMEM.branchTargetAddr, &_threadNextPC }, { &_PC });
+#else
+      tm.add(if1, "muxPCSrc", TIMING_MUX2_PS, _muxPCSrc);
+#endif
+      tm.add(if1, "adderPCPlus4", TimingModel::adderDelay(32), _adderPCPlus4);
+#ifdef ENABLE_VIRTUAL_MEMORY
+      // the instruction memory is read at the address the iTLB translated
+      // the PC to
+      tm.add(if1, "iTLB", TIMING_BUFFER_LOOKUP_PS, { &_PC }, { &_instMemPhysAddress });
+#endif
+      tm.add(if1, "instMemory", instMemoryDelay, _instMemory);
+      for (size_t i = 2; i <= PIPELINE_IF_STAGES; i++) {
+        tm.add(ifStage[i - 1], "instMemory", instMemoryDelay, { &_ifOut(i - 1).instruction }, { &_ifNext(i).instruction });
+      }
+#ifdef ENABLE_JUMP_PREDICTION
+      // the return-address stack or the indirect target cache, once the
+      // instruction is out of the memory
+      tm.add(ifn, "jumpPredictor", TIMING_BUFFER_LOOKUP_PS,
+             { &_ifNext(PIPELINE_IF_STAGES).instruction },
+             { &_ifNext(PIPELINE_IF_STAGES).jumpPredicted, &_ifNext(PIPELINE_IF_STAGES).jumpPredictedTarget });
+#else
+      (void)ifn;
+#endif
+
+      // ID: the register file, the Control unit, and SignExtend take the
+      // IF-ID latch; a stall clears the control signals
+      const TimingModel::Signals idexCtrl = {
+        &_latchIDEXNext.ctrlWB.memToReg, &_latchIDEXNext.ctrlWB.regWrite,
+        &_latchIDEXNext.ctrlMEM.branch, &_latchIDEXNext.ctrlMEM.memRead, &_latchIDEXNext.ctrlMEM.memWrite,
+        &_latchIDEXNext.ctrlEX.regDst, &_latchIDEXNext.ctrlEX.aluOp, &_latchIDEXNext.ctrlEX.aluSrc
+      };
+      tm.add("ID", "registerFileRead", TIMING_REGISTER_FILE_READ_PS,
+             { &_regFileReadRegister1, &_regFileReadRegister2 },
+             { &_latchIDEXNext.regFileReadData1, &_latchIDEXNext.regFileReadData2 });
+      tm.add("ID", "control", TIMING_CONTROL_PS, _control);
+      tm.add("ID", "signExtend", TIMING_SIGN_EXTEND_PS, _signExtend);
+#ifdef ENABLE_JUMPS
+      // a jump overrides the control signals of its opcode
+      TimingModel::Signals jumpCtrl = idexCtrl;
+      jumpCtrl.push_back(&_latchIDEXNext.jumpOp);
+      tm.add("ID", "muxJumpCtrl", TIMING_MUX2_PS, jumpCtrl, idexCtrl);
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      // a pair to fuse, found with the word after the instruction, overrides
+      // the control signals of its first instruction
+      tm.add("ID", "fusionDecoder", TIMING_CONTROL_PS, { &_latchIFID.instruction }, { &_latchIDEXNext.fusedOp });
+      TimingModel::Signals fusedCtrl = idexCtrl;
+      fusedCtrl.push_back(&_latchIDEXNext.fusedOp);
+      tm.add("ID", "muxFusedCtrl", TIMING_MUX2_PS, fusedCtrl, idexCtrl);
+#endif
+#ifdef ENABLE_HAZARD_DETECTION
+#ifdef ENABLE_MULT_DIV
+      tm.add("ID", "mulDivCheckStall", TIMING_HAZARD_DETECTION_PS,
+             { &_latchIFID.instruction, &_latchIDEX.mulDivOp }, { &_mulDivStall });
+#endif
+      tm.add("ID", "hazDetUnit", TIMING_HAZARD_DETECTION_PS, _hazDetUnit);
+      TimingModel::Signals stallCtrl = idexCtrl;
+      stallCtrl.push_back(&_hazDetIDEXCtrlWrite);
+      tm.add("ID", "muxIDEXCtrl", TIMING_MUX2_PS, stallCtrl, idexCtrl);
+#endif
+
+      // EX: the operands pass the WB bypass (and the forwarding MUXes) on
+      // their way to the ALU
+#if defined(ENABLE_MACRO_FUSION) && (FUSION_PAIRS & FUSION_PAIR_SLT_BEQ)
+      // the 'funct' of a fused slt+beq
+      tm.add("EX", "muxFusedFunct", TIMING_MUX2_PS, { &_latchIDEX.signExtImmediate, &_latchIDEX.fusedOp }, { &_aluControlInput });
+#endif
+      tm.add("EX", "aluControl", TIMING_ALU_CONTROL_PS, _aluControl);
+      const double wbBypassDelay = TimingModel::comparatorDelay(5) + TIMING_MUX2_PS;
+      tm.add("EX", "wbBypassA", wbBypassDelay,
+             { &_latchIDEX.rs, &_latchIDEX.regFileReadData1, &_latchMEMWB.regDstIdx, &_muxMemToRegOutput }, { &_exReadData1 });
+      tm.add("EX", "wbBypassB", wbBypassDelay,
+             { &_latchIDEX.rt, &_latchIDEX.regFileReadData2, &_latchMEMWB.regDstIdx, &_muxMemToRegOutput }, { &_exReadData2 });
+#ifdef ENABLE_DATA_FORWARDING
+      tm.add("EX", "forwardingUnit", TIMING_FORWARDING_UNIT_PS, _forwardingUnit);
+      tm.add("EX", "muxForwardA", TIMING_MUX4_PS, _muxForwardA);
+      tm.add("EX", "muxForwardB", TIMING_MUX4_PS, _muxForwardB);
+      const Wire<32> *operandA = &_muxForwardAOutput;
+#else
+      const Wire<32> *operandA = &_exReadData1;
+#endif
+      tm.add("EX", "muxALUSrc", TIMING_MUX2_PS, _muxALUSrc);
+      tm.add("EX", "alu", TIMING_ALU_PS, _alu);
+#if defined(ENABLE_MACRO_FUSION) && (FUSION_PAIRS & FUSION_PAIR_ADD_LW)
+      // the address of a fused add+lw is the ALU output plus the immediate
+      tm.add("EX", "adderFusedAddress", TimingModel::adderDelay(32),
+             { &_latchEXMEMNext.aluResult, &_latchIDEX.signExtImmediate }, { &_latchEXMEMNext.aluResult });
+      tm.add("EX", "muxFusedAddress", TIMING_MUX2_PS,
+             { &_latchEXMEMNext.aluResult, &_latchIDEX.fusedOp }, { &_latchEXMEMNext.aluResult });
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      // the recorded effective address replaces the ALU output
+      tm.add("EX", "muxTraceAddress", TIMING_MUX2_PS,
+             { &_latchEXMEMNext.aluResult, &_latchIDEX.traceAddress, &_latchIDEX.traceAddressValid },
+             { &_latchEXMEMNext.aluResult, &_latchEXMEMNext.aluZero });
+#endif
+#ifdef ENABLE_MULT_DIV
+      tm.add("EX", "mulDivUnit", TIMING_MUL_DIV_STEP_PS, _mulDivUnit);
+      tm.add("EX", "muxMulDivResult", TIMING_MUX2_PS,
+             { &_latchEXMEMNext.aluResult, &_mulDivResult, &_latchIDEX.mulDivOp }, { &_latchEXMEMNext.aluResult });
+#endif
+      tm.add("EX", "adderBranchTargetAddr", TimingModel::adderDelay(32), _adderBranchTargetAddr);
+      tm.add("EX", "muxRegDst", TIMING_MUX2_PS, _muxRegDst);
+#ifdef ENABLE_JUMPS
+      // the target of a branch, a j/jal, or a jr, and the link address of a jal
+      tm.add("EX", "muxJumpTarget", TIMING_MUX3_PS,
+             { &_latchEXMEMNext.branchTargetAddr, operandA, &_latchIDEX.jumpOp }, { &_latchEXMEMNext.branchTargetAddr });
+      tm.add("EX", "muxLink", TIMING_MUX2_PS,
+             { &_latchEXMEMNext.aluResult, &_latchIDEX.jumpOp }, { &_latchEXMEMNext.aluResult, &_latchEXMEMNext.regDstIdx });
+#else
+      (void)operandA;
+#endif
+
+      // MEM
+      const std::string &mem1 = memStage[0];
+      const std::string &memn = memStage[PIPELINE_MEM_STAGES - 1];
+      const double dataMemoryDelay = (double)TIMING_MEMORY_PS / PIPELINE_MEM_STAGES;
+      TimingModel::Signals access = {
+        &_latchEXMEM.aluResult, &_latchEXMEM.regFileReadData2, &_latchEXMEM.ctrlMEM.memRead, &_latchEXMEM.ctrlMEM.memWrite
+      };
+#ifdef ENABLE_VIRTUAL_MEMORY
+      // the dTLB translates the address before the units in front of the
+      // data memory, and the data memory itself, take the access
+      tm.add(mem1, "dTLB", TIMING_BUFFER_LOOKUP_PS, access, { &_dataMemPhysAddress, &_dTLBMemRead, &_dTLBMemWrite, &_dTLBStall });
+      access = { &_dataMemPhysAddress, &_latchEXMEM.regFileReadData2, &_dTLBMemRead, &_dTLBMemWrite };
+#endif
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_PREFETCHER)
+      // a load searches the buffers alongside the memory, and a hit takes the
+      // place of the memory output
+#ifdef ENABLE_STORE_BUFFER
+      tm.add(mem1, "storeBuffer", TIMING_BUFFER_LOOKUP_PS, access, { &_storeBufferStall });
+      const Wire<1> *bufferHit = &_storeBufferStall;
+#endif
+#ifdef ENABLE_PREFETCHER
+      tm.add(mem1, "prefetcher", TIMING_BUFFER_LOOKUP_PS, access, { &_prefetcherStall });
+#ifndef ENABLE_STORE_BUFFER
+      const Wire<1> *bufferHit = &_prefetcherStall;
+#endif
+#endif
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+      // the memory bridge hands the access over to the data memory, whose
+      // clock is not the core's, so the data memory has a stage of its own
+      tm.add(mem1, "memoryBridge", TIMING_SYNC_PS, access, { &_memoryBridgeStall });
+      (void)memn;
+      (void)dataMemoryDelay;
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_PREFETCHER)
+      (void)bufferHit;
+#endif
+      tm.addStage("dataMemory", false);
+      tm.add("dataMemory", "dataMemory", TIMING_MEMORY_PS, _dataMemory);
+#else
+      // the units in front of the data memory pass the access on as it is
+      const Wire<32> *dataMemOutput = _memoryPorts.empty() ? &_memNext(1).dataMemReadData : &_memoryPorts.back().readData;
+      tm.add(mem1, "dataMemory", dataMemoryDelay, access, { dataMemOutput });
+      for (size_t i = 2; i <= PIPELINE_MEM_STAGES; i++) {
+        tm.add(memStage[i - 1], "dataMemory", dataMemoryDelay, { &_memOut(i - 1).dataMemReadData }, { &_memNext(i).dataMemReadData });
+      }
+#if defined(ENABLE_STORE_BUFFER) || defined(ENABLE_PREFETCHER)
+      const Wire<32> *dataMemReadData = (PIPELINE_MEM_STAGES == 1) ? dataMemOutput : &_memNext(PIPELINE_MEM_STAGES).dataMemReadData;
+      tm.add(memn, "muxBufferHit", TIMING_MUX2_PS, { dataMemReadData, bufferHit }, { &_memNext(PIPELINE_MEM_STAGES).dataMemReadData });
+#else
+      (void)memn;
+#endif
+#endif
+
+      // WB
+      tm.add("WB", "muxMemToReg", TIMING_MUX2_PS, _muxMemToReg);
+      tm.add("WB", "registerFileWrite", TIMING_REGISTER_FILE_WRITE_PS,
+             { &_muxMemToRegOutput, &_latchMEMWB.regDstIdx, &_regFileRegWrite }, {});
+    }
+#endif
+
+#ifdef ENABLE_PIPEVIEW
+    // Pipeline view
+    PipeView *_pipeView = nullptr; // the timeline of the instructions, once openPipeView() is called
+
+    // void PipelinedCPU::_pipeviewFetch()
+    //   - tags the instruction IF1 has just fetched into 'latch'
+    void _pipeviewFetch(IFIDLatch_t &latch) {
+      if (_pipeView != nullptr && latch.valid.test(0)) {
+        latch.seqNum = _pipeView->fetch(_pcOf(latch.pcPlus4), latch.instruction.to_ulong(), _currCycle);
+      }
+    }
+
+    // void PipelinedCPU::_pipeviewSquash()
+    //   - the instruction in 'latch' is dropped in the current cycle
+    void _pipeviewSquash(const IFIDLatch_t &latch) {
+      if (_pipeView != nullptr) {
+        _pipeView->squash(latch.seqNum.to_ulong(), _currCycle);
+      }
+    }
+
+    // void PipelinedCPU::_pipeviewStages()
+    //   - at the beginning of a cycle, each stage works on the instruction in
+    //     its input latch, as in _profileStages(), and the one in the MEM-WB
+    //     latch retires
+    void _pipeviewStages() {
+      if (_pipeView == nullptr) {
+        return;
+      }
+      for (size_t i = 0; i + 1 < PIPELINE_IF_STAGES; i++) {
+        if (_latchIF[i].valid.test(0)) {
+          _pipeView->occupy(_latchIF[i].seqNum.to_ulong(), PipeView::IF, _currCycle);
+        }
+      }
+      if (_latchIFID.valid.test(0)) {
+        _pipeView->occupy(_latchIFID.seqNum.to_ulong(), PipeView::ID, _currCycle);
+      }
+      if (_latchIDEX.valid.test(0)) {
+        _pipeView->occupy(_latchIDEX.seqNum.to_ulong(), PipeView::EX, _currCycle);
+      }
+      if (_latchEXMEM.valid.test(0)) {
+        _pipeView->occupy(_latchEXMEM.seqNum.to_ulong(), PipeView::MEM, _currCycle);
+      }
+      for (size_t i = 0; i + 1 < PIPELINE_MEM_STAGES; i++) {
+        if (_latchMEM[i].valid.test(0)) {
+          _pipeView->occupy(_latchMEM[i].seqNum.to_ulong(), PipeView::MEM, _currCycle);
+        }
+      }
+      if (_latchMEMWB.valid.test(0)) {
+        _pipeView->retire(_latchMEMWB.seqNum.to_ulong(), _currCycle);
+      }
+    }
+#endif
+
+    // Program-visible state (PVS) output
+    WireRegistry _pvsWires; // the latch fields printed by printPVS(), in order
+    PVSLayout _pvsLayout; // how a record captured by _capturePVS() is printed
+    OutputRecord _pvsRecord; // the PVS captured in the current cycle
+    std::string _pvsText; // the text of '_pvsRecord'
+#ifdef ENABLE_PVS_ARCHIVE
+    PVSArchiveWriter *_pvsArchive = nullptr; // where printPVS() goes, once openPVSArchive() is called
+#endif
+#ifdef ENABLE_STATE_DIGEST
+    StateDigest _stateDigest; // the registers and the memories
+#endif
+#ifdef ENABLE_ASYNC_OUTPUT
+    AsyncOutputWriter *_outputWriter; // formats and writes the PVS on a background thread
+#endif
+
+    template<size_t N>
+    void _addPVSField(const std::string &header, const std::string &label, const Wire<N> *field, bool binary) {
+      std::string text = header + "    " + label;
+      text.resize(header.size() + 4 + 17, ' '); // the values are aligned at column 24
+      text += binary ? "= 0b" : "= 0x";
+      _pvsLayout.addField(text, binary ? N : 0);
+      _pvsWires.add(label, field);
+    }
+
+    void _registerPVSFields() {
+      // the state before the latches, in the order _capturePVS() puts it
+      _pvsLayout.add(PVSLayout::CycleHeader);
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        _pvsLayout.add(PVSLayout::ProgramCounter, "Thread " + std::to_string(t) + ":\n");
+        _pvsLayout.add(PVSLayout::RegisterValues, "Registers:\n");
+        _pvsLayout.add(PVSLayout::MemoryWords, "Data Memory:\n");
+        _pvsLayout.add(PVSLayout::MemoryWords, "Instruction Memory:\n");
+      }
+#else
+      _pvsLayout.add(PVSLayout::ProgramCounter);
+      _pvsLayout.add(PVSLayout::RegisterValues, "Registers:\n");
+#ifdef ENABLE_MULT_DIV
+      _pvsLayout.add(PVSLayout::HILOValues);
+#endif
+      _pvsLayout.add(PVSLayout::MemoryWords, "Data Memory:\n");
+#ifdef ENABLE_STORE_BUFFER
+      _pvsLayout.add(PVSLayout::StoreBufferEntries, "Store Buffer:\n");
+#endif
+      _pvsLayout.add(PVSLayout::MemoryWords, "Instruction Memory:\n");
+#endif
+      _pvsLayout.add(PVSLayout::Literal, "Latches:\n");
+
+      for (size_t i = 1; i < PIPELINE_IF_STAGES; i++) {
+        std::string header = "  IF" + std::to_string(i) + "-IF" + std::to_string(i + 1) + " Latch:\n";
+        _addPVSField(header, "pcPlus4", &_latchIF[i - 1].pcPlus4, false);
+        _addPVSField("", "instruction", &_latchIF[i - 1].instruction, false);
+      }
+      _addPVSField("  IF-ID Latch:\n", "pcPlus4", &_latchIFID.pcPlus4, false);
+      _addPVSField("", "instruction", &_latchIFID.instruction, false);
+#ifdef ENABLE_MULTITHREADING
+      _addPVSField("", "thread", &_latchIFID.thread, true);
+#endif
+
+      _addPVSField("  ID-EX Latch:\n", "ctrlWBMemToReg", &_latchIDEX.ctrlWB.memToReg, true);
+      _addPVSField("", "ctrlWBRegWrite", &_latchIDEX.ctrlWB.regWrite, true);
+      _addPVSField("", "ctrlMEMBranch", &_latchIDEX.ctrlMEM.branch, true);
+      _addPVSField("", "ctrlMEMMemRead", &_latchIDEX.ctrlMEM.memRead, true);
+      _addPVSField("", "ctrlMEMMemWrite", &_latchIDEX.ctrlMEM.memWrite, true);
+      _addPVSField("", "ctrlEXRegDst", &_latchIDEX.ctrlEX.regDst, true);
+      _addPVSField("", "ctrlEXALUOp", &_latchIDEX.ctrlEX.aluOp, true);
+      _addPVSField("", "ctrlEXALUSrc", &_latchIDEX.ctrlEX.aluSrc, true);
+      _addPVSField("", "pcPlus4", &_latchIDEX.pcPlus4, false);
+      _addPVSField("", "regFileReadData1", &_latchIDEX.regFileReadData1, false);
+      _addPVSField("", "regFileReadData2", &_latchIDEX.regFileReadData2, false);
+      _addPVSField("", "signExtImmediate", &_latchIDEX.signExtImmediate, false);
+#ifdef ENABLE_DATA_FORWARDING
+      _addPVSField("", "rs", &_latchIDEX.rs, true);
+#endif
+      _addPVSField("", "rt", &_latchIDEX.rt, true);
+      _addPVSField("", "rd", &_latchIDEX.rd, true);
+#ifdef ENABLE_MULTITHREADING
+      _addPVSField("", "thread", &_latchIDEX.thread, true);
+#endif
+#ifdef ENABLE_MULT_DIV
+      _addPVSField("", "mulDivOp", &_latchIDEX.mulDivOp, true);
+#endif
+#ifdef ENABLE_JUMPS
+      _addPVSField("", "jumpOp", &_latchIDEX.jumpOp, true);
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _addPVSField("", "fusedOp", &_latchIDEX.fusedOp, true);
+#endif
+
+      _addPVSField("  EX-MEM Latch:\n", "ctrlWBMemToReg", &_latchEXMEM.ctrlWB.memToReg, true);
+      _addPVSField("", "ctrlWBRegWrite", &_latchEXMEM.ctrlWB.regWrite, true);
+      _addPVSField("", "ctrlMEMBranch", &_latchEXMEM.ctrlMEM.branch, true);
+      _addPVSField("", "ctrlMEMMemRead", &_latchEXMEM.ctrlMEM.memRead, true);
+      _addPVSField("", "ctrlMEMMemWrite", &_latchEXMEM.ctrlMEM.memWrite, true);
+      _addPVSField("", "branchTargetAddr", &_latchEXMEM.branchTargetAddr, false);
+      _addPVSField("", "aluZero", &_latchEXMEM.aluZero, true);
+      _addPVSField("", "aluResult", &_latchEXMEM.aluResult, false);
+      _addPVSField("", "regFileReadData2", &_latchEXMEM.regFileReadData2, false);
+      _addPVSField("", "regDstIdx", &_latchEXMEM.regDstIdx, true);
+#ifdef ENABLE_MULTITHREADING
+      _addPVSField("", "thread", &_latchEXMEM.thread, true);
+#endif
+
+      for (size_t i = 1; i <= PIPELINE_MEM_STAGES; i++) {
+        const MEMWBLatch_t &latch = _memOut(i);
+        std::string header = (i == PIPELINE_MEM_STAGES) ? std::string("  MEM-WB Latch:\n")
+          : "  MEM" + std::to_string(i) + "-MEM" + std::to_string(i + 1) + " Latch:\n";
+        _addPVSField(header, "ctrlWBMemToReg", &latch.ctrlWB.memToReg, true);
+        _addPVSField("", "ctrlWBRegWrite", &latch.ctrlWB.regWrite, true);
+        _addPVSField("", "dataMemReadData", &latch.dataMemReadData, false);
+        _addPVSField("", "aluResult", &latch.aluResult, false);
+        _addPVSField("", "regDstIdx", &latch.regDstIdx, true);
+#ifdef ENABLE_MULTITHREADING
+        _addPVSField("", "thread", &latch.thread, true);
+#endif
+      }
+    }
+
+    // void PipelinedCPU::_capturePVS()
+    //   - copies the PVS into 'record'; this is all the simulation itself
+    //     spends on the output when the output is written asynchronously
+    void _capturePVS(OutputRecord &record) {
+      put64(record, _currCycle);
+#ifdef ENABLE_MULTITHREADING
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        record.push_back(_threadPC[t].to_ulong());
+        _threadRegisterFiles[t]->captureRegisters(record);
+        PVSLayout::captureMemory(*_threadDataMemories[t], record);
+        PVSLayout::captureMemory(*_threadInstMemories[t], record);
+      }
+#else
+      record.push_back(_PC.to_ulong());
+      _registerFile->captureRegisters(record);
+#ifdef ENABLE_MULT_DIV
+      _mulDivUnit->captureHILO(record);
+#endif
+      PVSLayout::captureMemory(*_dataMemory, record);
+#ifdef ENABLE_STORE_BUFFER
+      _storeBuffer->captureStoreBuffer(record);
+#endif
+      PVSLayout::captureMemory(*_instMemory, record);
+#endif
+      for (size_t i = 0; i < _pvsWires.size(); i++) {
+        record.push_back(_pvsWires.read(i));
+      }
+    }
+
+    // void PipelinedCPU::_formatPVS()
+    //   - appends the text of a record captured by _capturePVS() to 'out';
+    //     it touches nothing but the record and the (constant) layout, so
+    //     it may run on another thread
+    void _formatPVS(OutputRecordReader &reader, std::string &out) const {
+      _pvsLayout.format(reader, out);
+    }
 
   public:
 
     void printPVS() {
-      printf("==================== Cycle %lu ====================\n", _currCycle);
-      printf("PC = 0x%08lx\n", _PC.to_ulong());
-      printf("Registers:\n");
-      _registerFile->printRegisters();
-      printf("Data Memory:\n");
-      _dataMemory->printMemory();
-      printf("Instruction Memory:\n");
-      _instMemory->printMemory();
-      printf("Latches:\n");
-      printf("  IF-ID Latch:\n");
-      printf("    pcPlus4          = 0x%08lx\n", _latchIFID.pcPlus4.to_ulong());
-      printf("    instruction      = 0x%08lx\n", _latchIFID.instruction.to_ulong());
-      printf("  ID-EX Latch:\n");
-      printf("    ctrlWBMemToReg   = 0b%s\n", _latchIDEX.ctrlWB.memToReg.to_string().c_str());
-      printf("    ctrlWBRegWrite   = 0b%s\n", _latchIDEX.ctrlWB.regWrite.to_string().c_str());
-      printf("    ctrlMEMBranch    = 0b%s\n", _latchIDEX.ctrlMEM.branch.to_string().c_str());
-      printf("    ctrlMEMMemRead   = 0b%s\n", _latchIDEX.ctrlMEM.memRead.to_string().c_str());
-      printf("    ctrlMEMMemWrite  = 0b%s\n", _latchIDEX.ctrlMEM.memWrite.to_string().c_str());
-      printf("    ctrlEXRegDst     = 0b%s\n", _latchIDEX.ctrlEX.regDst.to_string().c_str());
-      printf("    ctrlEXALUOp      = 0b%s\n", _latchIDEX.ctrlEX.aluOp.to_string().c_str());
-      printf("    ctrlEXALUSrc     = 0b%s\n", _latchIDEX.ctrlEX.aluSrc.to_string().c_str());
-      printf("    pcPlus4          = 0x%08lx\n", _latchIDEX.pcPlus4.to_ulong());
-      printf("    regFileReadData1 = 0x%08lx\n", _latchIDEX.regFileReadData1.to_ulong());
-      printf("    regFileReadData2 = 0x%08lx\n", _latchIDEX.regFileReadData2.to_ulong());
-      printf("    signExtImmediate = 0x%08lx\n", _latchIDEX.signExtImmediate.to_ulong());
-#ifdef ENABLE_DATA_FORWARDING
-      printf("    rs               = 0b%s\n", _latchIDEX.rs.to_string().c_str());
-#endif
-      printf("    rt               = 0b%s\n", _latchIDEX.rt.to_string().c_str());
-      printf("    rd               = 0b%s\n", _latchIDEX.rd.to_string().c_str());
-      printf("  EX-MEM Latch:\n"); 
-      printf("    ctrlWBMemToReg   = 0b%s\n", _latchEXMEM.ctrlWB.memToReg.to_string().c_str());
-      printf("    ctrlWBRegWrite   = 0b%s\n", _latchEXMEM.ctrlWB.regWrite.to_string().c_str());
-      printf("    ctrlMEMBranch    = 0b%s\n", _latchEXMEM.ctrlMEM.branch.to_string().c_str());
-      printf("    ctrlMEMMemRead   = 0b%s\n", _latchEXMEM.ctrlMEM.memRead.to_string().c_str());
-      printf("    ctrlMEMMemWrite  = 0b%s\n", _latchEXMEM.ctrlMEM.memWrite.to_string().c_str());
-      printf("    branchTargetAddr = 0x%08lx\n", _latchEXMEM.branchTargetAddr.to_ulong());
-      printf("    aluZero          = 0b%s\n", _latchEXMEM.aluZero.to_string().c_str());
-      printf("    aluResult        = 0x%08lx\n", _latchEXMEM.aluResult.to_ulong());
-      printf("    regFileReadData2 = 0x%08lx\n", _latchEXMEM.regFileReadData2.to_ulong());
-      printf("    regDstIdx        = 0b%s\n", _latchEXMEM.regDstIdx.to_string().c_str());
-      printf("  MEM-WB Latch:\n"); 
-      printf("    ctrlWBMemToReg   = 0b%s\n", _latchMEMWB.ctrlWB.memToReg.to_string().c_str());
-      printf("    ctrlWBRegWrite   = 0b%s\n", _latchMEMWB.ctrlWB.regWrite.to_string().c_str());
-      printf("    dataMemReadData  = 0x%08lx\n", _latchMEMWB.dataMemReadData.to_ulong());
-      printf("    aluResult        = 0x%08lx\n", _latchMEMWB.aluResult.to_ulong());
-      printf("    regDstIdx        = 0b%s\n", _latchMEMWB.regDstIdx.to_string().c_str());
+      HOST_PROFILE_SCOPE("printPVS");
+      _pvsRecord.clear();
+      _capturePVS(_pvsRecord);
+#ifdef ENABLE_PVS_ARCHIVE
+      if (_pvsArchive != nullptr) {
+        _pvsArchive->append(_pvsRecord);
+        return;
+      }
+#endif
+#ifdef ENABLE_ASYNC_OUTPUT
+      _outputWriter->push(_pvsRecord);
+#else
+      OutputRecordReader reader(_pvsRecord.data());
+      _pvsText.clear();
+      _formatPVS(reader, _pvsText);
+      fwrite(_pvsText.data(), 1, _pvsText.size(), stdout);
+#endif
+    }
+
+    void printStats() {
+#ifdef ENABLE_ASYNC_OUTPUT
+      _outputWriter->drain();
+#endif
+#ifdef ENABLE_PIPELINE_STATS
+      printf("Pipeline Statistics:\n");
+      printf("  cycles             = %lu\n", (unsigned long)_currCycle);
+      printf("  retired            = %lu\n", (unsigned long)_numRetired);
+      printf("  CPI                = %.3f\n",
+             _numRetired == 0 ? 0.0 : (double)_currCycle / (double)_numRetired);
+#endif
+#ifdef ENABLE_TRACE_DRIVEN
+      printf("Trace Statistics:\n");
+      printf("  records            = %lu\n", (unsigned long)_traceReader->getNumRecords());
+#endif
+#ifdef ENABLE_STORE_BUFFER
+      _storeBuffer->printStats();
+#endif
+#ifdef ENABLE_PREFETCHER
+      _prefetcher->printStats();
+#endif
+#ifdef ENABLE_VIRTUAL_MEMORY
+      _virtualMemory->printStats();
+#endif
+#ifdef ENABLE_CLOCK_DOMAINS
+      _clockScheduler.printStats();
+      _memoryBridge->printStats();
+#endif
+#ifdef ENABLE_FETCH_QUEUE
+      _fetchUnit->printStats();
+#endif
+#ifdef ENABLE_MULT_DIV
+      _mulDivUnit->printStats();
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+      _jumpPredictor->printStats();
+#endif
+#ifdef ENABLE_MACRO_FUSION
+      _macroFusion.printStats(_numRetired);
+#endif
+#ifdef ENABLE_TIMING_MODEL
+      _timingModel.printStats(_currCycle);
+#endif
+#ifdef ENABLE_PVS_ARCHIVE
+      if (_pvsArchive != nullptr) {
+        _pvsArchive->printStats();
+      }
+#endif
+#ifdef ENABLE_MULTITHREADING
+      static const char *policyNames[] = { "round-robin", "switch-on-stall", "ICOUNT" };
+      printf("Multithreading Statistics (%d threads, %s fetch):\n", PIPELINE_THREADS, policyNames[THREAD_POLICY]);
+      for (size_t t = 0; t < PIPELINE_THREADS; t++) {
+        printf("  thread[%lu].fetched  = %lu\n", (unsigned long)t, (unsigned long)_threadNumFetched[t]);
+        printf("  thread[%lu].retired  = %lu\n", (unsigned long)t, (unsigned long)_threadNumRetired[t]);
+        printf("  thread[%lu].IPC      = %.3f\n", (unsigned long)t,
+               _currCycle == 0 ? 0.0 : (double)_threadNumRetired[t] / (double)_currCycle);
+      }
+      printf("  IPC                = %.3f\n",
+             _currCycle == 0 ? 0.0 : (double)_numRetired / (double)_currCycle);
+      printf("  idleCycles         = %lu\n", (unsigned long)_numIdleCycles);
+      printf("  loadUseStallCycles = %lu\n", (unsigned long)_numLoadUseStallCycles);
+#endif
+#ifdef ENABLE_HOST_PROFILER
+      _hostProfiler.printReport();
+#endif
+#ifdef ENABLE_PROFILER
+      _profiler.printReport();
+      _profiler.writeCSV();
+#endif
+#ifdef ENABLE_PIPEVIEW
+      if (_pipeView != nullptr) {
+        _pipeView->printWindow();
+      }
+#endif
     }
 
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
@@ -0,0 +1,288 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef PROFILE_FILE_PREFIX
+#define PROFILE_FILE_PREFIX "profile" // <-- the machine-readable profile goes to <prefix>.pcs.csv and <prefix>.blocks.csv
+#endif
+
+#ifndef PROFILE_REPORT_LINES
+#define PROFILE_REPORT_LINES 20 // <-- the number of instructions and blocks shown in the report
+#endif
+
+class Profiler {
+
+  public:
+
+    enum Stage { IF, ID, EX, MEM, WB, NumStages };
+    enum StallCause { LoadUse, Branch, DataMemory, NumStallCauses };
+
+    // void Profiler::fetch()
+    //   - records the instruction at 'pc' when it is fetched
+    void fetch(std::uint32_t pc, std::uint32_t instruction) {
+      _pcs[pc].instruction = instruction;
+    }
+
+    // void Profiler::occupy()
+    //   - the instruction at 'pc' has spent the current cycle in 'stage'
+    void occupy(Stage stage, std::uint32_t pc) {
+      _pcs[pc].stageCycles[stage] += 1;
+    }
+
+    // void Profiler::stall()
+    //   - charges 'cycles' lost pipeline slots to the instruction at 'pc'
+    //     (e.g., the consumer of a load, or a taken branch)
+    void stall(std::uint32_t pc, StallCause cause, std::uint64_t cycles = 1) {
+      _pcs[pc].stallCycles[cause] += cycles;
+    }
+
+    // void Profiler::retire()
+    //   - the instruction at 'pc' has left the WB stage; a basic block
+    //     starts wherever the retired PCs are not consecutive
+    void retire(std::uint32_t pc) {
+      _pcs[pc].retired += 1;
+      if (!_anyRetired || pc != _lastRetiredPC + 4) {
+        _pcs[pc].leader = true;
+        if (_anyRetired) {
+          _pcs[_lastRetiredPC].ender = true;
+        }
+      }
+      _anyRetired = true;
+      _lastRetiredPC = pc;
+      _numRetired += 1;
+    }
+
+    // void Profiler::charge()
+    //   - charges the current cycle to the instruction at 'pc', i.e., the one
+    //     retiring, or else the oldest one in flight; the cycles charged add
+    //     up to the total number of cycles, as in 'perf annotate'
+    void charge(std::uint32_t pc) {
+      _pcs[pc].cycles += 1;
+      _numCycles += 1;
+    }
+
+    // void Profiler::chargeIdle()
+    //   - the current cycle has no instruction in flight
+    void chargeIdle() {
+      _numIdleCycles += 1;
+      _numCycles += 1;
+    }
+
+    void printReport() {
+      std::vector<Block> blocks = _findBlocks();
+
+      std::vector<std::uint32_t> pcs;
+      for (auto &pc : _pcs) {
+        pcs.push_back(pc.first);
+      }
+      std::stable_sort(pcs.begin(), pcs.end(), [this](std::uint32_t a, std::uint32_t b) {
+        return _pcs[a].cycles > _pcs[b].cycles;
+      });
+
+      printf("Profile (%lu cycles, %lu retired, %lu idle cycles):\n",
+             (unsigned long)_numCycles, (unsigned long)_numRetired, (unsigned long)_numIdleCycles);
+      printf("  %6s  %-10s  %-10s  %-22s %8s %8s %8s %8s %8s\n", "cycles", "pc", "inst", "",
+             "retired", "loadUse", "branch", "memory", "CPI");
+      for (size_t i = 0; i < pcs.size() && i < PROFILE_REPORT_LINES; i++) {
+        const PCProfile &p = _pcs[pcs[i]];
+        printf("  %5.1f%%  0x%08lx  0x%08lx  %-22s %8lu %8lu %8lu %8lu %8.2f\n",
+               _percent(p.cycles), (unsigned long)pcs[i], (unsigned long)p.instruction,
+               disassemble(p.instruction).c_str(), (unsigned long)p.retired,
+               (unsigned long)p.stallCycles[LoadUse], (unsigned long)p.stallCycles[Branch],
+               (unsigned long)p.stallCycles[DataMemory],
+               p.retired == 0 ? 0.0 : (double)p.cycles / (double)p.retired);
+      }
+
+      std::stable_sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) {
+        return a.cycles > b.cycles;
+      });
+      printf("Hot Basic Blocks:\n");
+      printf("  %6s  %-24s %6s %10s %10s\n", "cycles", "range", "insts", "executions", "stalls");
+      for (size_t i = 0; i < blocks.size() && i < PROFILE_REPORT_LINES; i++) {
+        printf("  %5.1f%%  0x%08lx..0x%08lx %6lu %10lu %10lu\n", _percent(blocks[i].cycles),
+               (unsigned long)blocks[i].first, (unsigned long)blocks[i].last,
+               (unsigned long)((blocks[i].last - blocks[i].first) / 4 + 1),
+               (unsigned long)blocks[i].executions, (unsigned long)blocks[i].stallCycles);
+      }
+    }
+
+    // void Profiler::writeCSV()
+    //   - writes one row per instruction into '<prefix>.pcs.csv' and one row
+    //     per basic block into '<prefix>.blocks.csv'
+    void writeCSV(const std::string &prefix = PROFILE_FILE_PREFIX) {
+      std::vector<Block> blocks = _findBlocks();
+
+      std::string fileName = prefix + ".pcs.csv";
+      FILE *file = fopen(fileName.c_str(), "w");
+      if (file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName.c_str());
+        assert(false);
+      }
+      fprintf(file, "pc,instruction,disassembly,block,retired,cycles,"
+                    "ifCycles,idCycles,exCycles,memCycles,wbCycles,"
+                    "loadUseStalls,branchStalls,memoryStalls\n");
+      size_t block = 0;
+      for (auto &pc : _pcs) {
+        while (block < blocks.size() && blocks[block].last < pc.first) {
+          block += 1;
+        }
+        const PCProfile &p = pc.second;
+        fprintf(file, "0x%08lx,0x%08lx,\"%s\",%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                (unsigned long)pc.first, (unsigned long)p.instruction,
+                disassemble(p.instruction).c_str(), (unsigned long)block,
+                (unsigned long)p.retired, (unsigned long)p.cycles,
+                (unsigned long)p.stageCycles[IF], (unsigned long)p.stageCycles[ID],
+                (unsigned long)p.stageCycles[EX], (unsigned long)p.stageCycles[MEM],
+                (unsigned long)p.stageCycles[WB], (unsigned long)p.stallCycles[LoadUse],
+                (unsigned long)p.stallCycles[Branch], (unsigned long)p.stallCycles[DataMemory]);
+      }
+      fclose(file);
+
+      fileName = prefix + ".blocks.csv";
+      file = fopen(fileName.c_str(), "w");
+      if (file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName.c_str());
+        assert(false);
+      }
+      fprintf(file, "block,first,last,instructions,executions,cycles,stalls\n");
+      for (size_t i = 0; i < blocks.size(); i++) {
+        fprintf(file, "%lu,0x%08lx,0x%08lx,%lu,%lu,%lu,%lu\n", (unsigned long)i,
+                (unsigned long)blocks[i].first, (unsigned long)blocks[i].last,
+                (unsigned long)((blocks[i].last - blocks[i].first) / 4 + 1),
+                (unsigned long)blocks[i].executions, (unsigned long)blocks[i].cycles,
+                (unsigned long)blocks[i].stallCycles);
+      }
+      fclose(file);
+    }
+
+    // std::string Profiler::disassemble()
+    //   - the assembly of the instructions the Control unit understands
+    static std::string disassemble(std::uint32_t instruction) {
+      const unsigned opcode = instruction >> 26;
+      const unsigned rs = (instruction >> 21) & 0x1F;
+      const unsigned rt = (instruction >> 16) & 0x1F;
+      const unsigned rd = (instruction >> 11) & 0x1F;
+      const int immediate = (std::int16_t)(instruction & 0xFFFF);
+      char text[64];
+      if (instruction == 0x00000000) {
+        snprintf(text, sizeof(text), "nop");
+      } else if (opcode == 0b000000) {
+        const char *name = nullptr;
+        switch (instruction & 0x3F) {
+          case 0x20: name = "add"; break;
+          case 0x22: name = "sub"; break;
+          case 0x24: name = "and"; break;
+          case 0x25: name = "or"; break;
+          case 0x2a: name = "slt"; break;
+        }
+        if (name != nullptr) {
+          snprintf(text, sizeof(text), "%s $%u, $%u, $%u", name, rd, rs, rt);
+#ifdef ENABLE_MULT_DIV
+        } else if ((instruction & 0x3F) == 0x10 || (instruction & 0x3F) == 0x12) {
+          snprintf(text, sizeof(text), "%s $%u", (instruction & 0x3F) == 0x10 ? "mfhi" : "mflo", rd);
+        } else if ((instruction & 0x3C) == 0x18) {
+          static const char *names[] = { "mult", "multu", "div", "divu" };
+          snprintf(text, sizeof(text), "%s $%u, $%u", names[instruction & 0x3], rs, rt);
+#endif
+#ifdef ENABLE_JUMPS
+        } else if ((instruction & 0x3F) == 0x08) {
+          snprintf(text, sizeof(text), "jr $%u", rs);
+#endif
+        } else {
+          snprintf(text, sizeof(text), ".word 0x%08lx", (unsigned long)instruction);
+        }
+      } else if (opcode == 0b001000) {
+        snprintf(text, sizeof(text), "addi $%u, $%u, %d", rt, rs, immediate);
+      } else if (opcode == 0b100011) {
+        snprintf(text, sizeof(text), "lw $%u, %d($%u)", rt, immediate, rs);
+      } else if (opcode == 0b101011) {
+        snprintf(text, sizeof(text), "sw $%u, %d($%u)", rt, immediate, rs);
+      } else if (opcode == 0b000100) {
+        snprintf(text, sizeof(text), "beq $%u, $%u, %d", rs, rt, immediate);
+#ifdef ENABLE_JUMPS
+      } else if (opcode == 0b000010 || opcode == 0b000011) {
+        // the upper 4 bits of the target are those of the jump's own PC
+        snprintf(text, sizeof(text), "%s 0x%07lx", opcode == 0b000010 ? "j" : "jal",
+                 (unsigned long)((instruction & 0x03FFFFFF) << 2));
+#endif
+      } else {
+        snprintf(text, sizeof(text), ".word 0x%08lx", (unsigned long)instruction);
+      }
+      return text;
+    }
+
+  private:
+
+    typedef struct {
+      std::uint32_t instruction = 0; // the instruction last fetched from the PC
+      std::uint64_t retired = 0; // the number of times it has left the WB stage
+      std::uint64_t cycles = 0; // the cycles charged by charge()
+      std::uint64_t stageCycles[NumStages] = {}; // the cycles spent in each stage
+      std::uint64_t stallCycles[NumStallCauses] = {}; // the pipeline slots lost, by cause
+      bool leader = false; // true if a basic block starts here
+      bool ender = false; // true if a basic block ends here
+    } PCProfile;
+
+    typedef struct {
+      std::uint32_t first; // the PC of the first instruction
+      std::uint32_t last; // the PC of the last instruction
+      std::uint64_t executions; // the number of times the first instruction has retired
+      std::uint64_t cycles; // the cycles charged to its instructions
+      std::uint64_t stallCycles; // the pipeline slots lost by its instructions
+    } Block;
+
+    // std::vector<Block> Profiler::_findBlocks()
+    //   - splits the retired PCs, in address order, into runs of consecutive
+    //     instructions that start at a leader and end at an ender
+    std::vector<Block> _findBlocks() {
+      std::vector<Block> blocks;
+      bool open = false;
+      std::uint32_t previous = 0;
+      for (auto &pc : _pcs) {
+        const PCProfile &p = pc.second;
+        if (p.retired == 0) {
+          continue;
+        }
+        if (!open || p.leader || pc.first != previous + 4) {
+          Block block = { pc.first, pc.first, p.retired, 0, 0 };
+          blocks.push_back(block);
+        }
+        Block &block = blocks.back();
+        block.last = pc.first;
+        block.cycles += p.cycles;
+        for (size_t c = 0; c < NumStallCauses; c++) {
+          block.stallCycles += p.stallCycles[c];
+        }
+        open = !p.ender;
+        previous = pc.first;
+      }
+      return blocks;
+    }
+
+    double _percent(std::uint64_t cycles) const {
+      return _numCycles == 0 ? 0.0 : 100.0 * (double)cycles / (double)_numCycles;
+    }
+
+    std::map<std::uint32_t, PCProfile> _pcs; // the profile of each PC, in address order
+    bool _anyRetired = false;
+    std::uint32_t _lastRetiredPC = 0;
+    std::uint64_t _numRetired = 0;
+    std::uint64_t _numCycles = 0;
+    std::uint64_t _numIdleCycles = 0;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
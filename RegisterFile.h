@@ -2,10 +2,15 @@
 #define __REGISTER_FILE_HPP__
 
 #include "DigitalCircuit.h"
+#include "OutputRecord.h"
+#include "StateDigest.h"
+#include "SimulatorNamespace.h"
 
 #include <cassert>
 #include <cstdio>
 
+SIMULATOR_NAMESPACE_BEGIN
+
 class RegisterFile : public DigitalCircuit {
 
   public:
@@ -56,19 +61,78 @@ class RegisterFile : public DigitalCircuit {
       }
     }
 
-    virtual void advanceCycle() {
-      std::uint8_t readReg1 = _iReadRegister1->to_ulong(); // $rs
-      std::uint8_t readReg2 = _iReadRegister2->to_ulong(); // $rt
-      *_oReadData1 = _registers[readReg1].to_ulong();
-      *_oReadData2 = _registers[readReg2].to_ulong();
+    // void RegisterFile::captureRegisters()
+    //   - appends the registers to 'record', to be printed later by
+    //     formatRegisters() exactly as printRegisters() would print them now
+    void captureRegisters(OutputRecord &record) const {
+      for (size_t i = 0; i < 32; i++) {
+        record.push_back(_registers[i].to_ulong());
+      }
+    }
+
+    static void formatRegisters(OutputRecordReader &reader, std::string &out) {
+      for (size_t i = 0; i < 32; i++) {
+        std::uint32_t value = reader.get();
+        if (value != 0) {
+          appendf(out, "  $%02lu = 0x%08lx\n", i, (unsigned long)value);
+        }
+      }
+    }
+
+    std::uint32_t getRegister(size_t i) const {
+      assert(i < 32);
+      return _registers[i].to_ulong();
+    }
+
+    // void RegisterFile::setRegister()
+    //   - writes register 'i' directly, i.e., not through the write port;
+    //     $0 stays zero
+    void setRegister(size_t i, std::uint32_t value) {
+      assert(i < 32);
+      if (i == 0) {
+        return;
+      }
+      if (_digest != nullptr) {
+        _digest->update(_digestRegion, i, _registers[i].to_ulong(), value);
+      }
+      _registers[i] = value;
+    }
+
+    // void RegisterFile::clear()
+    //   - zeroes all the registers
+    void clear() {
+      for (size_t i = 1; i < 32; i++) {
+        setRegister(i, 0);
+      }
+    }
+
+    // void RegisterFile::attachDigest()
+    //   - folds the registers into 'digest' now and on every write from now on
+    void attachDigest(StateDigest *digest, std::uint32_t region = StateDigest::Registers) {
+      _digest = digest;
+      _digestRegion = region;
+      for (size_t i = 0; i < 32; i++) {
+        _digest->update(_digestRegion, i, 0, _registers[i].to_ulong());
+      }
+    }
 
+    virtual void advanceCycle() {
+      // the write happens in the first half of the cycle, so a read of the
+      // same register sees the new value
       if (_iRegWrite->test(0)) {
         std::uint8_t writeReg = _iWriteRegister->to_ulong();
-        std::uint32_t writeData = _iWriteData->to_ulong();
-        if (writeReg != 0 && writeData != 0) {
+        if (writeReg != 0) {
+          if (_digest != nullptr) {
+            _digest->update(_digestRegion, writeReg, _registers[writeReg].to_ulong(), _iWriteData->to_ulong());
+          }
           _registers[writeReg] = _iWriteData->to_ulong();
         }
       }
+
+      std::uint8_t readReg1 = _iReadRegister1->to_ulong(); // $rs
+      std::uint8_t readReg2 = _iReadRegister2->to_ulong(); // $rt
+      *_oReadData1 = _registers[readReg1].to_ulong();
+      *_oReadData2 = _registers[readReg2].to_ulong();
     }
 
   private:
@@ -83,6 +147,11 @@ class RegisterFile : public DigitalCircuit {
 
     std::bitset<32> _registers[32];
 
+    StateDigest *_digest = nullptr; // the digest kept up to date on writes, if any
+    std::uint32_t _digestRegion = StateDigest::Registers;
+
 };
 
+SIMULATOR_NAMESPACE_END
+
 #endif
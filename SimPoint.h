@@ -0,0 +1,336 @@
+#ifndef __SIMPOINT_H__
+#define __SIMPOINT_H__
+
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef SIMPOINT_PROJECTED_DIMENSIONS
+#define SIMPOINT_PROJECTED_DIMENSIONS 15 // <-- the dimensions the basic block vectors are randomly projected to
+#endif
+
+#ifndef SIMPOINT_KMEANS_SEEDS
+#define SIMPOINT_KMEANS_SEEDS 5 // <-- the k-means runs, from different random centers, per value of k
+#endif
+
+#ifndef SIMPOINT_KMEANS_ITERATIONS
+#define SIMPOINT_KMEANS_ITERATIONS 100 // <-- the limit on the iterations of one k-means run
+#endif
+
+#ifndef SIMPOINT_BIC_THRESHOLD
+#define SIMPOINT_BIC_THRESHOLD 0.9 // <-- the smallest k whose BIC score reaches this fraction of the best one's range is chosen
+#endif
+
+// SimPoint
+//   - collects one basic block vector (BBV) per interval of executed
+//     instructions, i.e., the number of instructions executed in each basic
+//     block, and picks the intervals that represent the whole run
+//   - the BBVs are normalized, randomly projected to a few dimensions, and
+//     clustered with k-means; k is chosen with the Bayesian information
+//     criterion, and each cluster is represented by the interval closest
+//     to its center, weighted by the cluster's share of the instructions
+class SimPoint {
+
+  public:
+
+    typedef struct {
+      std::uint64_t interval; // the index of the representative interval
+      std::uint64_t firstInstruction; // the number of instructions executed before it
+      std::uint64_t numInstructions; // the length of the interval
+      std::uint32_t pc; // the address of its first instruction
+      double weight; // the share of all the instructions its cluster has
+      std::uint64_t clusterIntervals; // the number of intervals it represents
+    } Representative;
+
+    SimPoint(std::uint64_t seed = 1) : _seed(seed) {
+    }
+
+    // void SimPoint::retire()
+    //   - records the instruction at 'pc' as the next one executed; a basic
+    //     block starts wherever the executed PCs are not consecutive
+    void retire(std::uint32_t pc) {
+      if (!_anyRetired || pc != _lastPC + 4) {
+        _blockPC = pc;
+      }
+      _anyRetired = true;
+      _lastPC = pc;
+      if (_current.numInstructions == 0) {
+        _current.pc = pc;
+      }
+      _current.blocks[_blockPC] += 1;
+      _current.numInstructions += 1;
+    }
+
+    // void SimPoint::endInterval()
+    //   - closes the current interval; the caller decides where the
+    //     boundaries are (e.g., every N instructions, but never in the delay
+    //     slots of a taken branch)
+    void endInterval() {
+      if (_current.numInstructions == 0) {
+        return;
+      }
+      _current.firstInstruction = _numInstructions;
+      _numInstructions += _current.numInstructions;
+      _intervals.push_back(_project(_current));
+      _current = Interval();
+    }
+
+    size_t getNumIntervals() const {
+      return _intervals.size();
+    }
+
+    std::uint64_t getNumInstructions() const {
+      return _numInstructions;
+    }
+
+    // std::vector<Representative> SimPoint::cluster()
+    //   - clusters the intervals for every k up to 'maxK' and returns the
+    //     representatives of the chosen clustering, by interval
+    std::vector<Representative> cluster(size_t maxK) {
+      assert(!_intervals.empty());
+      maxK = std::max<size_t>(1, std::min(maxK, _intervals.size()));
+
+      std::vector<Clustering> clusterings;
+      double minBIC = std::numeric_limits<double>::infinity();
+      double maxBIC = -std::numeric_limits<double>::infinity();
+      for (size_t k = 1; k <= maxK; k++) {
+        Clustering best;
+        for (size_t s = 0; s < SIMPOINT_KMEANS_SEEDS; s++) {
+          Clustering clustering = _kmeans(k, _seed * 1000 + k * SIMPOINT_KMEANS_SEEDS + s);
+          if (s == 0 || clustering.distortion < best.distortion) {
+            best = clustering;
+          }
+        }
+        best.bic = _bic(best);
+        minBIC = std::min(minBIC, best.bic);
+        maxBIC = std::max(maxBIC, best.bic);
+        clusterings.push_back(best);
+      }
+
+      const Clustering *chosen = &clusterings.back();
+      for (const Clustering &clustering : clusterings) {
+        if (maxBIC == minBIC || (clustering.bic - minBIC) >= SIMPOINT_BIC_THRESHOLD * (maxBIC - minBIC)) {
+          chosen = &clustering;
+          break;
+        }
+      }
+      _chosenK = chosen->centers.size();
+      return _representatives(*chosen);
+    }
+
+    // size_t SimPoint::getChosenK()
+    //   - the number of clusters the last cluster() chose
+    size_t getChosenK() const {
+      return _chosenK;
+    }
+
+  private:
+
+    typedef std::vector<double> Point;
+
+    typedef struct {
+      std::uint64_t firstInstruction = 0;
+      std::uint64_t numInstructions = 0;
+      std::uint32_t pc = 0;
+      std::unordered_map<std::uint32_t, std::uint64_t> blocks; // the instructions executed per basic block
+    } Interval;
+
+    typedef struct {
+      std::uint64_t firstInstruction;
+      std::uint64_t numInstructions;
+      std::uint32_t pc;
+      Point point; // the projected, normalized BBV
+    } ProjectedInterval;
+
+    typedef struct {
+      std::vector<Point> centers;
+      std::vector<size_t> assignment; // the cluster of each interval
+      double distortion; // the sum of the squared distances to the centers
+      double bic;
+    } Clustering;
+
+    // the random projection matrix is never stored: the entry for a basic
+    // block and a dimension is a hash of the two, uniform in [-1, 1]
+    double _projection(std::uint32_t pc, size_t dimension) const {
+      std::uint64_t x = _seed ^ ((std::uint64_t)pc << 8) ^ dimension;
+      x += 0x9e3779b97f4a7c15ULL;
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      x = x ^ (x >> 31);
+      return (double)(x >> 11) / (double)(1ULL << 52) - 1.0;
+    }
+
+    ProjectedInterval _project(const Interval &interval) const {
+      ProjectedInterval projected;
+      projected.firstInstruction = interval.firstInstruction;
+      projected.numInstructions = interval.numInstructions;
+      projected.pc = interval.pc;
+      projected.point.assign(SIMPOINT_PROJECTED_DIMENSIONS, 0.0);
+      for (auto &block : interval.blocks) {
+        const double share = (double)block.second / (double)interval.numInstructions;
+        for (size_t d = 0; d < SIMPOINT_PROJECTED_DIMENSIONS; d++) {
+          projected.point[d] += share * _projection(block.first, d);
+        }
+      }
+      return projected;
+    }
+
+    static double _distance2(const Point &a, const Point &b) {
+      double sum = 0.0;
+      for (size_t d = 0; d < a.size(); d++) {
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+      }
+      return sum;
+    }
+
+    // k-means from 'k' distinct intervals picked at random as the centers
+    Clustering _kmeans(size_t k, std::uint64_t seed) const {
+      std::mt19937_64 random(seed);
+      std::vector<size_t> order(_intervals.size());
+      for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+      }
+      std::shuffle(order.begin(), order.end(), random);
+
+      Clustering clustering;
+      for (size_t c = 0; c < k; c++) {
+        clustering.centers.push_back(_intervals[order[c]].point);
+      }
+      clustering.assignment.assign(_intervals.size(), 0);
+
+      for (size_t iteration = 0; iteration < SIMPOINT_KMEANS_ITERATIONS; iteration++) {
+        bool changed = (iteration == 0);
+        for (size_t i = 0; i < _intervals.size(); i++) {
+          size_t nearest = 0;
+          double nearestDistance = std::numeric_limits<double>::infinity();
+          for (size_t c = 0; c < k; c++) {
+            double distance = _distance2(_intervals[i].point, clustering.centers[c]);
+            if (distance < nearestDistance) {
+              nearest = c;
+              nearestDistance = distance;
+            }
+          }
+          if (clustering.assignment[i] != nearest) {
+            clustering.assignment[i] = nearest;
+            changed = true;
+          }
+        }
+        if (!changed) {
+          break;
+        }
+
+        std::vector<size_t> sizes(k, 0);
+        for (size_t c = 0; c < k; c++) {
+          clustering.centers[c].assign(SIMPOINT_PROJECTED_DIMENSIONS, 0.0);
+        }
+        for (size_t i = 0; i < _intervals.size(); i++) {
+          Point &center = clustering.centers[clustering.assignment[i]];
+          for (size_t d = 0; d < SIMPOINT_PROJECTED_DIMENSIONS; d++) {
+            center[d] += _intervals[i].point[d];
+          }
+          sizes[clustering.assignment[i]] += 1;
+        }
+        for (size_t c = 0; c < k; c++) {
+          if (sizes[c] == 0) {
+            // an empty cluster restarts from a random interval
+            clustering.centers[c] = _intervals[random() % _intervals.size()].point;
+            continue;
+          }
+          for (size_t d = 0; d < SIMPOINT_PROJECTED_DIMENSIONS; d++) {
+            clustering.centers[c][d] /= (double)sizes[c];
+          }
+        }
+      }
+
+      clustering.distortion = 0.0;
+      for (size_t i = 0; i < _intervals.size(); i++) {
+        clustering.distortion += _distance2(_intervals[i].point, clustering.centers[clustering.assignment[i]]);
+      }
+      return clustering;
+    }
+
+    // the BIC of a clustering under the identical spherical Gaussian
+    // assumption of X-means (Pelleg and Moore), as SimPoint uses it
+    double _bic(const Clustering &clustering) const {
+      const double R = (double)_intervals.size();
+      const double M = (double)SIMPOINT_PROJECTED_DIMENSIONS;
+      const double K = (double)clustering.centers.size();
+      std::vector<double> sizes(clustering.centers.size(), 0.0);
+      for (size_t i = 0; i < _intervals.size(); i++) {
+        sizes[clustering.assignment[i]] += 1.0;
+      }
+
+      double variance = (R > K) ? clustering.distortion / (M * (R - K)) : 0.0;
+      variance = std::max(variance, 1e-12);
+      double logLikelihood = 0.0;
+      for (double Rn : sizes) {
+        if (Rn > 0.0) {
+          logLikelihood += Rn * std::log(Rn) - Rn * std::log(R)
+                           - Rn * M / 2.0 * std::log(2.0 * M_PI * variance)
+                           - (Rn - 1.0) * M / 2.0;
+        }
+      }
+      const double numParameters = (K - 1.0) + M * K + 1.0;
+      return logLikelihood - numParameters / 2.0 * std::log(R);
+    }
+
+    std::vector<Representative> _representatives(const Clustering &clustering) const {
+      std::vector<Representative> representatives;
+      for (size_t c = 0; c < clustering.centers.size(); c++) {
+        size_t nearest = _intervals.size();
+        double nearestDistance = std::numeric_limits<double>::infinity();
+        std::uint64_t numInstructions = 0, numIntervals = 0;
+        for (size_t i = 0; i < _intervals.size(); i++) {
+          if (clustering.assignment[i] != c) {
+            continue;
+          }
+          numInstructions += _intervals[i].numInstructions;
+          numIntervals += 1;
+          double distance = _distance2(_intervals[i].point, clustering.centers[c]);
+          if (distance < nearestDistance) {
+            nearest = i;
+            nearestDistance = distance;
+          }
+        }
+        if (nearest == _intervals.size()) {
+          continue;
+        }
+        Representative representative;
+        representative.interval = nearest;
+        representative.firstInstruction = _intervals[nearest].firstInstruction;
+        representative.numInstructions = _intervals[nearest].numInstructions;
+        representative.pc = _intervals[nearest].pc;
+        representative.weight = (double)numInstructions / (double)_numInstructions;
+        representative.clusterIntervals = numIntervals;
+        representatives.push_back(representative);
+      }
+      std::sort(representatives.begin(), representatives.end(),
+                [](const Representative &a, const Representative &b) { return a.interval < b.interval; });
+      return representatives;
+    }
+
+    std::uint64_t _seed;
+    bool _anyRetired = false;
+    std::uint32_t _lastPC = 0;
+    std::uint32_t _blockPC = 0; // the leader of the basic block being executed
+    Interval _current; // the interval being collected
+    std::uint64_t _numInstructions = 0; // the instructions in the closed intervals
+    std::vector<ProjectedInterval> _intervals;
+    size_t _chosenK = 0;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
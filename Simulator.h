@@ -0,0 +1,100 @@
+#ifndef __SIMULATOR_H__
+#define __SIMULATOR_H__
+
+// Simulator.h
+//   - the interface of libsimulator.a, a PipelinedCPU (with data forwarding
+//     and hazard detection) that can be embedded in another program and
+//     driven cycle by cycle, from C++ or from C
+//   - a simulator owns 64 MB of simulated memory, of which the host only
+//     backs what the programs touch; create one per thread and reuse it
+//     with reset() for every program
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+// Simulator
+//   - 'initialPC' is the address of the first instruction, and the memories
+//     and the registers are empty until the program is loaded
+class Simulator {
+
+  public:
+
+    Simulator(uint32_t initialPC, bool bigEndian = false);
+    ~Simulator();
+
+    // void Simulator::reset()
+    //   - empties the registers and the memories and restarts from
+    //     'initialPC', without allocating anything
+    void reset(uint32_t initialPC);
+
+    // void Simulator::loadInstructions(), loadData()
+    //   - stores 'count' 32-bit words from 'address' on, as the lines of an
+    //     initialization file would (i.e., in the memory's endianness)
+    void loadInstructions(uint32_t address, const uint32_t *words, size_t count);
+    void loadData(uint32_t address, const uint32_t *words, size_t count);
+
+    void setRegister(unsigned i, uint32_t value);
+    uint32_t getRegister(unsigned i) const;
+    uint32_t readMemory(uint32_t address) const;
+
+    // void Simulator::step()
+    //   - simulates 'cycles' cycles
+    void step(uint64_t cycles = 1);
+
+    // uint64_t Simulator::run()
+    //   - simulates until the program has run off the end of its code (see
+    //     isHalted()), or for at most 'maxCycles' cycles; returns the number
+    //     of cycles simulated
+    uint64_t run(uint64_t maxCycles = UINT64_MAX);
+
+    // bool Simulator::isHalted()
+    //   - true once the next fetch is from an address no instruction was
+    //     loaded to, and every loaded instruction in flight has retired
+    bool isHalted() const;
+
+    uint64_t getNumCycles() const;
+    uint64_t getNumRetired() const;
+
+    // void Simulator::printState()
+    //   - prints the program-visible state, as testAssn4 does every cycle
+    void printState();
+
+  private:
+
+    struct Core;
+    Core *_core;
+
+    Simulator(const Simulator &) = delete;
+    Simulator &operator=(const Simulator &) = delete;
+
+};
+
+extern "C" {
+#else
+typedef struct Simulator Simulator;
+#endif
+
+// the C interface: the same operations on a Simulator created by
+// simulator_create(); bigEndian and the returned flags are 0 or 1
+Simulator *simulator_create(uint32_t initialPC, int bigEndian);
+void simulator_destroy(Simulator *simulator);
+void simulator_reset(Simulator *simulator, uint32_t initialPC);
+void simulator_load_instructions(Simulator *simulator, uint32_t address, const uint32_t *words, size_t count);
+void simulator_load_data(Simulator *simulator, uint32_t address, const uint32_t *words, size_t count);
+void simulator_set_register(Simulator *simulator, unsigned i, uint32_t value);
+uint32_t simulator_get_register(const Simulator *simulator, unsigned i);
+uint32_t simulator_read_memory(const Simulator *simulator, uint32_t address);
+void simulator_step(Simulator *simulator, uint64_t cycles);
+uint64_t simulator_run(Simulator *simulator, uint64_t maxCycles);
+int simulator_is_halted(const Simulator *simulator);
+uint64_t simulator_get_num_cycles(const Simulator *simulator);
+uint64_t simulator_get_num_retired(const Simulator *simulator);
+void simulator_print_state(Simulator *simulator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
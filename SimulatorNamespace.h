@@ -0,0 +1,21 @@
+#ifndef __SIMULATOR_NAMESPACE_H__
+#define __SIMULATOR_NAMESPACE_H__
+
+// SIMULATOR_NAMESPACE
+//   - the namespace the components of the simulator are declared in; e.g.,
+//     each variant of the sweep is compiled with its own, so that the
+//     variants (built with different ENABLE_* options) can be linked into
+//     one program
+//   - every header of the simulator includes its standard headers first,
+//     then puts its declarations between SIMULATOR_NAMESPACE_BEGIN and
+//     SIMULATOR_NAMESPACE_END, which are empty (the global namespace) when
+//     SIMULATOR_NAMESPACE is not defined
+#ifdef SIMULATOR_NAMESPACE
+#define SIMULATOR_NAMESPACE_BEGIN namespace SIMULATOR_NAMESPACE {
+#define SIMULATOR_NAMESPACE_END } // namespace SIMULATOR_NAMESPACE
+#else
+#define SIMULATOR_NAMESPACE_BEGIN
+#define SIMULATOR_NAMESPACE_END
+#endif
+
+#endif
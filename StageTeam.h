@@ -0,0 +1,86 @@
+#ifndef __STAGE_TEAM_H__
+#define __STAGE_TEAM_H__
+
+#include "SimulatorNamespace.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+class StageTeam {
+
+  public:
+
+    typedef std::function<void()> Task;
+
+    // StageTeam::StageTeam()
+    //   - a team of host threads, one per task but the first, which the
+    //     calling thread runs itself; run() runs every task once and returns
+    //     when all of them are done
+    //   - the threads wait for the next run() without taking any lock, so a
+    //     run costs little more than its longest task when the host has a
+    //     core per task
+    StageTeam(const std::vector<Task> &tasks) {
+      assert(!tasks.empty());
+      _tasks = tasks;
+      _generation = 0;
+      _numDone = 0;
+      _stop = false;
+      for (size_t i = 1; i < _tasks.size(); i++) {
+        _threads.push_back(std::thread(&StageTeam::_run, this, i));
+      }
+    }
+
+    void run() {
+      _numDone.store(0, std::memory_order_relaxed);
+      _generation.fetch_add(1, std::memory_order_release);
+      _tasks[0]();
+      while (_numDone.load(std::memory_order_acquire) != _threads.size()) {
+        std::this_thread::yield();
+      }
+    }
+
+    ~StageTeam() {
+      _stop.store(true, std::memory_order_release);
+      for (std::thread &thread : _threads) {
+        thread.join();
+      }
+    }
+
+  private:
+
+    void _run(size_t i) {
+      std::uint64_t generation = 0;
+      while (true) {
+        std::uint64_t next;
+        while ((next = _generation.load(std::memory_order_acquire)) == generation) {
+          if (_stop.load(std::memory_order_acquire)) {
+            return;
+          }
+          std::this_thread::yield();
+        }
+        generation = next;
+        _tasks[i]();
+        _numDone.fetch_add(1, std::memory_order_release);
+      }
+    }
+
+    std::vector<Task> _tasks;
+    std::vector<std::thread> _threads;
+    std::atomic<std::uint64_t> _generation; // the number of run() calls so far
+    std::atomic<size_t> _numDone; // the threads done with the current run()
+    std::atomic<bool> _stop;
+
+    StageTeam(const StageTeam &) = delete;
+    StageTeam &operator=(const StageTeam &) = delete;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef __STATE_DIGEST_H__
+#define __STATE_DIGEST_H__
+
+#include "Memory.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+// StateDigest
+//   - a 64-bit digest of a set of (region, index) -> 32-bit value locations,
+//     kept up to date on every write in O(1): it is the XOR of a hash of
+//     each non-zero location, so a write takes the old value's hash out and
+//     puts the new one's in
+//   - the digest depends only on the current values, not on the order of
+//     the writes, so two runs with the same state have the same digest
+class StateDigest {
+
+  public:
+
+    enum Region { Registers, DataMemory, InstMemory, NumRegions };
+
+    // void StateDigest::update()
+    //   - the location 'index' of 'region' changes from 'oldValue' to 'newValue'
+    void update(std::uint32_t region, std::uint32_t index, std::uint32_t oldValue, std::uint32_t newValue) {
+      _digest ^= _hash(region, index, oldValue) ^ _hash(region, index, newValue);
+    }
+
+    // void StateDigest::watch()
+    //   - folds the words of 'memory' in as the locations of 'region' now,
+    //     and keeps them up to date on every write from now on
+    void watch(Memory *memory, std::uint32_t region) {
+      memory->forEachLoadedWord([this, region](std::uint32_t i, std::uint32_t value) {
+        update(region, i, 0, value);
+      });
+      memory->setWriteHook([this, region](std::uint32_t i, std::uint32_t oldValue, std::uint32_t newValue) {
+        update(region, i, oldValue, newValue);
+      });
+    }
+
+    std::uint64_t get() const {
+      return _digest;
+    }
+
+    // std::uint64_t StateDigest::mix()
+    //   - folds 'value' into the running hash 'seed' (the splitmix64 finalizer)
+    static std::uint64_t mix(std::uint64_t seed, std::uint64_t value) {
+      std::uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+
+  private:
+
+    // zero is the value of every location never written, so it hashes to 0
+    static std::uint64_t _hash(std::uint32_t region, std::uint32_t index, std::uint32_t value) {
+      if (value == 0) {
+        return 0;
+      }
+      return mix(mix(region, index), value);
+    }
+
+    std::uint64_t _digest = 0;
+
+};
+
+// StateDigestFile
+//   - the golden digests of a run, one line per sampled cycle:
+//       # state digest v1, every <period> cycles
+//       <cycle> <16-digit hexadecimal digest>
+//   - in the Record mode, sample() appends a line; in the Check mode, it
+//     compares the digest with the golden one and returns false at the
+//     first difference, so the run can stop right at the divergent cycle
+class StateDigestFile {
+
+  public:
+
+    enum Mode { Record, Check };
+
+    StateDigestFile(const char *fileName, Mode mode, std::uint64_t period = 1) {
+      _mode = mode;
+      _period = period;
+      _file = fopen(fileName, mode == Record ? "w" : "r");
+      if (_file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, fileName);
+        assert(false);
+      }
+      if (_mode == Record) {
+        assert(_period > 0);
+        fprintf(_file, "# state digest v1, every %lu cycles\n", (unsigned long)_period);
+      } else {
+        unsigned long period;
+        if (fscanf(_file, "# state digest v1, every %lu cycles", &period) != 1 || period == 0) {
+          fprintf(stderr, "[%s] ERROR: %s is not a state digest file\n", __func__, fileName);
+          assert(false);
+        }
+        _period = period;
+      }
+    }
+
+    // bool StateDigestFile::isSampled()
+    //   - true if the digest of 'cycle' goes into the file
+    bool isSampled(std::uint64_t cycle) const {
+      return cycle % _period == 0;
+    }
+
+    bool sample(std::uint64_t cycle, std::uint64_t digest) {
+      if (_mode == Record) {
+        fprintf(_file, "%lu %016llx\n", (unsigned long)cycle, (unsigned long long)digest);
+        _numSamples += 1;
+        return true;
+      }
+      unsigned long goldenCycle;
+      unsigned long long goldenDigest;
+      if (fscanf(_file, " %lu %llx", &goldenCycle, &goldenDigest) != 2) {
+        _endOfFile = true;
+        return false;
+      }
+      _goldenDigest = goldenDigest;
+      if (goldenCycle != cycle) {
+        fprintf(stderr, "[%s] ERROR: the golden file has cycle %lu where cycle %lu was expected\n",
+                __func__, goldenCycle, (unsigned long)cycle);
+        assert(false);
+      }
+      if (goldenDigest != digest) {
+        return false;
+      }
+      _numSamples += 1;
+      return true;
+    }
+
+    // true if the last sample() failed because the golden run was shorter
+    bool isEndOfFile() const {
+      return _endOfFile;
+    }
+
+    std::uint64_t getGoldenDigest() const {
+      return _goldenDigest;
+    }
+
+    std::uint64_t getNumSamples() const {
+      return _numSamples;
+    }
+
+    ~StateDigestFile() {
+      fclose(_file);
+    }
+
+  private:
+
+    Mode _mode;
+    std::uint64_t _period; // the cycles between two samples
+    FILE *_file;
+    bool _endOfFile = false;
+    std::uint64_t _goldenDigest = 0; // the golden digest last read
+    std::uint64_t _numSamples = 0; // the digests recorded or matched
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef __STORE_BUFFER_H__
+#define __STORE_BUFFER_H__
+
+#include "DigitalCircuit.h"
+#include "OutputRecord.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef STORE_BUFFER_SIZE
+#define STORE_BUFFER_SIZE 8 // <-- the number of store buffer entries
+#endif
+
+#ifndef STORE_BUFFER_DRAIN_LATENCY
+#define STORE_BUFFER_DRAIN_LATENCY 4 // <-- the cycles it takes to write one entry into the data memory
+#endif
+
+class StoreBuffer : public DigitalCircuit {
+
+  public:
+
+    // StoreBuffer::StoreBuffer()
+    //   - sits between the MEM stage and the data memory; the first six wires
+    //     are the MEM-stage side (same meaning as the ones of Memory), and the
+    //     'mem*' wires are the port of 'memory', which the store buffer drives
+    //     by itself whenever it reads from or drains into the data memory
+    //   - 'memory' is the data memory itself if 'memStall' is nullptr, and
+    //     otherwise another unit in front of it, which asserts 'memStall'
+    //     while an access must wait: that unit takes one access per cycle
+    //     (and is evaluated every cycle, with no access if there is none),
+    //     and an access it stalls is offered again, before any other, every
+    //     cycle until it is done
+    StoreBuffer(const std::string &name,
+                const Wire<32> *iAddress,
+                const Wire<32> *iWriteData,
+                const Wire<1> *iMemRead,
+                const Wire<1> *iMemWrite,
+                Wire<32> *oReadData,
+                Wire<1> *oStall,
+                DigitalCircuit *memory,
+                Wire<32> *memAddress,
+                Wire<32> *memWriteData,
+                Wire<1> *memRead,
+                Wire<1> *memWrite,
+                const Wire<32> *memReadData,
+                const Wire<1> *memStall,
+                const size_t size = STORE_BUFFER_SIZE,
+                const size_t drainLatency = STORE_BUFFER_DRAIN_LATENCY)
+      : DigitalCircuit(name) {
+      _iAddress = iAddress;
+      _iWriteData = iWriteData;
+      _iMemRead = iMemRead;
+      _iMemWrite = iMemWrite;
+      _oReadData = oReadData;
+      _oStall = oStall;
+      _memory = memory;
+      _memAddress = memAddress;
+      _memWriteData = memWriteData;
+      _memRead = memRead;
+      _memWrite = memWrite;
+      _memReadData = memReadData;
+      _memStall = memStall;
+
+      assert(size > 0);
+      assert(drainLatency > 0);
+      _size = size;
+      _drainLatency = drainLatency;
+      _drainCyclesLeft = 0;
+      _inFlight = None;
+
+      _occupancyHistogram.assign(_size + 1, 0);
+    }
+
+    void printStoreBuffer() {
+      for (size_t i = 0; i < _entries.size(); i++) {
+        printf("  entry[%lu]: memory[0x%08lx..0x%08lx] <-- 0x%08lx\n", i,
+               (unsigned long)(_entries[i].address + 3),
+               (unsigned long)_entries[i].address,
+               (unsigned long)_entries[i].data);
+      }
+    }
+
+    // void StoreBuffer::captureStoreBuffer()
+    //   - appends the entries to 'record', to be printed later by
+    //     formatStoreBuffer() exactly as printStoreBuffer() would print them now
+    void captureStoreBuffer(OutputRecord &record) const {
+      record.push_back(_entries.size());
+      for (size_t i = 0; i < _entries.size(); i++) {
+        record.push_back(_entries[i].address);
+        record.push_back(_entries[i].data);
+      }
+    }
+
+    static void formatStoreBuffer(OutputRecordReader &reader, std::string &out) {
+      std::uint32_t count = reader.get();
+      for (size_t i = 0; i < count; i++) {
+        std::uint32_t address = reader.get();
+        std::uint32_t data = reader.get();
+        appendf(out, "  entry[%lu]: memory[0x%08lx..0x%08lx] <-- 0x%08lx\n", i,
+                (unsigned long)(address + 3), (unsigned long)address,
+                (unsigned long)data);
+      }
+    }
+
+    bool isEmpty() const {
+      return _entries.empty();
+    }
+
+    // void StoreBuffer::reset()
+    //   - drops the pending stores without writing them, and the statistics
+    void reset() {
+      _entries.clear();
+      _drainCyclesLeft = 0;
+      _inFlight = None;
+      _numStores = 0;
+      _numCoalescedStores = 0;
+      _numDrainedStores = 0;
+      _numLoads = 0;
+      _numForwardedLoads = 0;
+      _numFullStallCycles = 0;
+      _numOverlapStallCycles = 0;
+      _maxOccupancy = 0;
+      _occupancyHistogram.assign(_size + 1, 0);
+    }
+
+    void printStats() {
+      std::uint64_t cycles = 0, occupancySum = 0;
+      for (size_t i = 0; i <= _size; i++) {
+        cycles += _occupancyHistogram[i];
+        occupancySum += _occupancyHistogram[i] * i;
+      }
+      printf("Store Buffer Statistics (%lu entries, drain latency %lu):\n",
+             (unsigned long)_size, (unsigned long)_drainLatency);
+      printf("  stores             = %lu\n", (unsigned long)_numStores);
+      printf("  coalescedStores    = %lu\n", (unsigned long)_numCoalescedStores);
+      printf("  drainedStores      = %lu\n", (unsigned long)_numDrainedStores);
+      printf("  loads              = %lu\n", (unsigned long)_numLoads);
+      printf("  forwardedLoads     = %lu\n", (unsigned long)_numForwardedLoads);
+      printf("  fullStallCycles    = %lu\n", (unsigned long)_numFullStallCycles);
+      printf("  overlapStallCycles = %lu\n", (unsigned long)_numOverlapStallCycles);
+      printf("  avgOccupancy       = %.2f\n",
+             cycles == 0 ? 0.0 : (double)occupancySum / (double)cycles);
+      printf("  maxOccupancy       = %lu\n", (unsigned long)_maxOccupancy);
+      for (size_t i = 0; i <= _size; i++) {
+        printf("  occupancy[%2lu]      = %lu cycles\n", (unsigned long)i,
+               (unsigned long)_occupancyHistogram[i]);
+      }
+    }
+
+    virtual void advanceCycle() {
+      *_oStall = 0;
+      _accessed = false;
+
+      // Background drain: the oldest entry is written into the data memory
+      // '_drainLatency' cycles after it has reached the head of the FIFO.
+      if (!_entries.empty()) {
+        if (_drainCyclesLeft == 0) {
+          _drainCyclesLeft = _drainLatency;
+        }
+        _drainCyclesLeft -= 1;
+        if (_drainCyclesLeft == 0) {
+          if (_access(Drain, _entries.front().address, _entries.front().data)) {
+            _entries.pop_front();
+            _numDrainedStores += 1;
+          } else {
+            // the entry is drained again next cycle
+            _drainCyclesLeft = 1;
+          }
+        }
+      }
+
+      if (_iMemRead->test(0)) {
+        std::uint32_t address = _iAddress->to_ulong();
+        bool overlap = false;
+        int match = -1;
+        for (int i = (int)_entries.size() - 1; i >= 0; i--) {
+          if (_entries[i].address == address) {
+            match = i;
+            break;
+          }
+          if (_overlaps(_entries[i].address, address)) {
+            overlap = true;
+            break;
+          }
+        }
+        if (match >= 0) {
+          *_oReadData = _entries[match].data;
+          _numLoads += 1;
+          _numForwardedLoads += 1;
+        } else if (overlap) {
+          // A partially-overlapping store cannot be forwarded; the load waits
+          // until the conflicting entries have been drained.
+          *_oStall = 1;
+          _numOverlapStallCycles += 1;
+        } else if (_access(Load, address, 0)) {
+          *_oReadData = *_memReadData;
+          _numLoads += 1;
+        } else {
+          // the unit behind is busy with a drain, or stalls the load itself
+          *_oStall = 1;
+        }
+      }
+
+      if (_iMemWrite->test(0)) {
+        std::uint32_t address = _iAddress->to_ulong();
+        std::uint32_t data = _iWriteData->to_ulong();
+        bool coalesced = false;
+        // A store is merged into the youngest entry with the same address,
+        // unless a younger entry partially overlaps it (merging would then
+        // reorder the two overlapping writes).
+        for (int i = (int)_entries.size() - 1; i >= 0; i--) {
+          if (_entries[i].address == address) {
+            _entries[i].data = data;
+            coalesced = true;
+            _numStores += 1;
+            _numCoalescedStores += 1;
+            break;
+          }
+          if (_overlaps(_entries[i].address, address)) {
+            break;
+          }
+        }
+        if (!coalesced) {
+          if (_entries.size() < _size) {
+            Entry entry = { address, data };
+            _entries.push_back(entry);
+            _numStores += 1;
+          } else {
+            *_oStall = 1;
+            _numFullStallCycles += 1;
+          }
+        }
+      }
+
+      if (_memStall != nullptr && !_accessed) {
+        *_memRead = 0;
+        *_memWrite = 0;
+        _memory->advanceCycle();
+      }
+
+      _occupancyHistogram[_entries.size()] += 1;
+      if (_entries.size() > _maxOccupancy) {
+        _maxOccupancy = _entries.size();
+      }
+    }
+
+  private:
+
+    typedef enum {
+      None,
+      Load, // the load in MEM1 reads 'memory'
+      Drain // the oldest entry is written into 'memory'
+    } Access;
+
+    // bool StoreBuffer::_access()
+    //   - reads or writes 'memory' at 'address'; true once the access is
+    //     done, and false while the unit behind the store buffer stalls it
+    //     or is still busy with the other access
+    bool _access(const Access access, const std::uint32_t address, const std::uint32_t data) {
+      if (_memStall != nullptr) {
+        if (_accessed || (_inFlight != None && _inFlight != access)) {
+          return false;
+        }
+        _accessed = true;
+      }
+      *_memAddress = address;
+      if (access == Drain) {
+        *_memWriteData = data;
+      }
+      *_memRead = (access == Load);
+      *_memWrite = (access == Drain);
+      _memory->advanceCycle();
+      *_memRead = 0;
+      *_memWrite = 0;
+      if (_memStall != nullptr && _memStall->test(0)) {
+        _inFlight = access;
+        return false;
+      }
+      _inFlight = None;
+      return true;
+    }
+
+    static bool _overlaps(std::uint32_t a, std::uint32_t b) {
+      return (a < b + 4) && (b < a + 4);
+    }
+
+    typedef struct {
+      std::uint32_t address; // the starting address of the 32-bit data
+      std::uint32_t data; // the 32-bit data to be written
+    } Entry;
+
+    const Wire<32> *_iAddress;
+    const Wire<32> *_iWriteData;
+    const Wire<1> *_iMemRead;
+    const Wire<1> *_iMemWrite;
+    Wire<32> *_oReadData;
+    Wire<1> *_oStall;
+
+    DigitalCircuit *_memory;
+    Wire<32> *_memAddress;
+    Wire<32> *_memWriteData;
+    Wire<1> *_memRead;
+    Wire<1> *_memWrite;
+    const Wire<32> *_memReadData;
+    const Wire<1> *_memStall; // nullptr if '_memory' is the data memory
+
+    size_t _size;
+    size_t _drainLatency;
+    size_t _drainCyclesLeft;
+    std::deque<Entry> _entries; // the FIFO, oldest entry first
+    Access _inFlight; // the access the unit behind has stalled, offered again until it is done
+    bool _accessed; // true once the unit behind has been evaluated this cycle
+
+    // Statistics
+    std::uint64_t _numStores = 0;
+    std::uint64_t _numCoalescedStores = 0;
+    std::uint64_t _numDrainedStores = 0;
+    std::uint64_t _numLoads = 0;
+    std::uint64_t _numForwardedLoads = 0;
+    std::uint64_t _numFullStallCycles = 0;
+    std::uint64_t _numOverlapStallCycles = 0;
+    size_t _maxOccupancy = 0;
+    std::vector<std::uint64_t> _occupancyHistogram;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef __STRIDE_PREFETCHER_H__
+#define __STRIDE_PREFETCHER_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef DATA_MEMORY_LATENCY
+#define DATA_MEMORY_LATENCY 8 // <-- the cycles a load that misses the prefetch buffer spends in MEM1 (1 for no stall)
+#endif
+
+#ifndef PREFETCH_TABLE_ENTRIES
+#define PREFETCH_TABLE_ENTRIES 16 // <-- the entries of the direct-mapped, PC-indexed stride table
+#endif
+
+#ifndef PREFETCH_DEGREE
+#define PREFETCH_DEGREE 2 // <-- the prefetches issued per load with a steady stride (0 turns the prefetcher off)
+#endif
+
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 4 // <-- how many strides ahead of the load the first prefetch goes
+#endif
+
+#ifndef PREFETCH_BUFFER_ENTRIES
+#define PREFETCH_BUFFER_ENTRIES 8 // <-- the blocks the prefetch buffer holds (a block a load has used is replaced first, then the oldest)
+#endif
+
+#ifndef PREFETCH_BLOCK_BYTES
+#define PREFETCH_BLOCK_BYTES 16 // <-- the bytes of a prefetched block (a power of two, at least 4)
+#endif
+
+class StridePrefetcher : public DigitalCircuit {
+
+  public:
+
+    // StridePrefetcher::StridePrefetcher()
+    //   - sits between the MEM stage and the data memory, which it gives a
+    //     latency: a load waits 'latency' cycles in MEM1 unless its block
+    //     has been prefetched, and less if the prefetch is still on its way
+    //   - the first six wires are the MEM-stage side (same meaning as the
+    //     ones of StoreBuffer), 'iPCPlus4' is the PC+4 of the instruction in
+    //     MEM1, and the 'mem*' wires are the port of 'memory'
+    //   - each load trains the entry of its PC in the stride table; once the
+    //     same stride is seen twice in a row, the load prefetches the blocks
+    //     'distance' to 'distance + degree - 1' strides ahead of its address
+    //   - the prefetch buffer holds the addresses of the blocks and the cycle
+    //     they arrive, not their data: a load always reads the data memory,
+    //     and a store writes it at once, so a prefetched block is never stale
+    //   - the data memory is pipelined, so the prefetches never delay the
+    //     loads or each other
+    //   - 'memory' is the data memory itself if 'memStall' is nullptr, and
+    //     otherwise another unit in front of it (see StoreBuffer), whose
+    //     stalls add to the latency
+    StridePrefetcher(const std::string &name,
+                     const Wire<32> *iAddress,
+                     const Wire<32> *iWriteData,
+                     const Wire<1> *iMemRead,
+                     const Wire<1> *iMemWrite,
+                     const Wire<32> *iPCPlus4,
+                     Wire<32> *oReadData,
+                     Wire<1> *oStall,
+                     DigitalCircuit *memory,
+                     Wire<32> *memAddress,
+                     Wire<32> *memWriteData,
+                     Wire<1> *memRead,
+                     Wire<1> *memWrite,
+                     const Wire<32> *memReadData,
+                     const Wire<1> *memStall,
+                     const size_t latency = DATA_MEMORY_LATENCY,
+                     const size_t tableEntries = PREFETCH_TABLE_ENTRIES,
+                     const size_t degree = PREFETCH_DEGREE,
+                     const size_t distance = PREFETCH_DISTANCE,
+                     const size_t bufferEntries = PREFETCH_BUFFER_ENTRIES,
+                     const size_t blockBytes = PREFETCH_BLOCK_BYTES)
+      : DigitalCircuit(name) {
+      _iAddress = iAddress;
+      _iWriteData = iWriteData;
+      _iMemRead = iMemRead;
+      _iMemWrite = iMemWrite;
+      _iPCPlus4 = iPCPlus4;
+      _oReadData = oReadData;
+      _oStall = oStall;
+      _memory = memory;
+      _memAddress = memAddress;
+      _memWriteData = memWriteData;
+      _memRead = memRead;
+      _memWrite = memWrite;
+      _memReadData = memReadData;
+      _memStall = memStall;
+
+      assert(latency > 0);
+      assert(tableEntries > 0);
+      assert(distance > 0);
+      assert(bufferEntries > 0);
+      assert(blockBytes >= 4 && (blockBytes & (blockBytes - 1)) == 0);
+      _latency = latency;
+      _degree = degree;
+      _distance = distance;
+      _blockBytes = blockBytes;
+      _table.resize(tableEntries);
+      _buffer.resize(bufferEntries);
+
+      reset();
+    }
+
+    // bool StridePrefetcher::isIdle()
+    //   - true unless a load is waiting for the data memory
+    bool isIdle() const {
+      return !_pending;
+    }
+
+    // void StridePrefetcher::configure()
+    //   - issues 'degree' prefetches from 'distance' strides ahead from now
+    //     on, and resets the prefetcher
+    void configure(const size_t degree, const size_t distance) {
+      assert(distance > 0);
+      _degree = degree;
+      _distance = distance;
+      reset();
+    }
+
+    // void StridePrefetcher::reset()
+    //   - empties the stride table and the prefetch buffer, and drops the
+    //     load in flight and the statistics
+    void reset() {
+      for (TableEntry &entry : _table) {
+        entry = TableEntry();
+      }
+      for (BufferEntry &entry : _buffer) {
+        entry = BufferEntry();
+      }
+      _cycle = 0;
+      _pending = false;
+      _readyCycle = 0;
+      _numLoads = 0;
+      _numTimelyHits = 0;
+      _numLateHits = 0;
+      _numMisses = 0;
+      _numPrefetches = 0;
+      _numRedundantPrefetches = 0;
+      _numUsefulPrefetches = 0;
+      _numUselessPrefetches = 0;
+      _numStallCycles = 0;
+    }
+
+    void printStats() {
+      printf("Stride Prefetcher Statistics (%lu table entries, degree %lu, distance %lu, %lu blocks of %lu bytes, latency %lu):\n",
+             (unsigned long)_table.size(), (unsigned long)_degree, (unsigned long)_distance,
+             (unsigned long)_buffer.size(), (unsigned long)_blockBytes, (unsigned long)_latency);
+      printf("  loads              = %lu\n", (unsigned long)_numLoads);
+      printf("  timelyHits         = %lu\n", (unsigned long)_numTimelyHits);
+      printf("  lateHits           = %lu\n", (unsigned long)_numLateHits);
+      printf("  misses             = %lu\n", (unsigned long)_numMisses);
+      printf("  prefetches         = %lu\n", (unsigned long)_numPrefetches);
+      printf("  redundantPrefetches = %lu\n", (unsigned long)_numRedundantPrefetches);
+      printf("  usefulPrefetches   = %lu\n", (unsigned long)_numUsefulPrefetches);
+      printf("  uselessPrefetches  = %lu\n", (unsigned long)_numUselessPrefetches);
+      printf("  stallCycles        = %lu\n", (unsigned long)_numStallCycles);
+      // coverage: the loads served by a prefetch, out of all the loads (each
+      // of which would have missed without the prefetcher); accuracy: the
+      // prefetched blocks a load used; timeliness: the hits that did not wait
+      printf("  coverage           = %.2f%%\n",
+             _numLoads == 0 ? 0.0 : 100.0 * (double)(_numTimelyHits + _numLateHits) / (double)_numLoads);
+      printf("  accuracy           = %.2f%%\n",
+             _numPrefetches == 0 ? 0.0 : 100.0 * (double)_numUsefulPrefetches / (double)_numPrefetches);
+      printf("  timeliness         = %.2f%%\n",
+             _numTimelyHits + _numLateHits == 0 ? 0.0
+               : 100.0 * (double)_numTimelyHits / (double)(_numTimelyHits + _numLateHits));
+    }
+
+    virtual void advanceCycle() {
+      _cycle += 1;
+      *_oStall = 0;
+
+      if (_iMemRead->test(0)) {
+        if (!_pending) {
+          // the first cycle of the load in MEM1
+          const std::uint32_t address = _iAddress->to_ulong();
+          _numLoads += 1;
+          BufferEntry *entry = _find(_blockOf(address));
+          if (entry == nullptr) {
+            _readyCycle = _cycle + _latency - 1;
+            _numMisses += 1;
+          } else {
+            if (!entry->used) {
+              _numUsefulPrefetches += 1;
+              entry->used = true;
+            }
+            _readyCycle = entry->readyCycle > _cycle ? entry->readyCycle : _cycle;
+            if (_readyCycle > _cycle) {
+              _numLateHits += 1;
+            } else {
+              _numTimelyHits += 1;
+            }
+          }
+          _pending = true;
+          _train(_iPCPlus4->to_ulong() - 4, address);
+        }
+        if (_cycle < _readyCycle) {
+          *_oStall = 1;
+          _numStallCycles += 1;
+          _tick();
+          return;
+        }
+        *_memAddress = _iAddress->to_ulong();
+        *_memRead = 1;
+        *_memWrite = 0;
+        _memory->advanceCycle();
+        *_memRead = 0;
+        if (_memStall != nullptr && _memStall->test(0)) {
+          *_oStall = 1;
+          _numStallCycles += 1;
+          return;
+        }
+        *_oReadData = *_memReadData;
+        _pending = false;
+      } else if (_iMemWrite->test(0)) {
+        *_memAddress = _iAddress->to_ulong();
+        *_memWriteData = _iWriteData->to_ulong();
+        *_memRead = 0;
+        *_memWrite = 1;
+        _memory->advanceCycle();
+        *_memWrite = 0;
+        if (_memStall != nullptr && _memStall->test(0)) {
+          *_oStall = 1;
+          _numStallCycles += 1;
+        }
+      } else {
+        _tick();
+      }
+    }
+
+  private:
+
+    // a unit behind the prefetcher is evaluated every cycle, even with no
+    // access
+    void _tick() {
+      if (_memStall != nullptr) {
+        *_memRead = 0;
+        *_memWrite = 0;
+        _memory->advanceCycle();
+      }
+    }
+
+    typedef struct {
+      bool valid = false;
+      std::uint32_t pc = 0;
+      std::uint32_t lastAddress = 0;
+      std::int32_t stride = 0;
+      bool steady = false; // true once the same nonzero stride has been seen twice in a row
+    } TableEntry;
+
+    typedef struct {
+      bool valid = false;
+      std::uint32_t block = 0; // the address of the first byte of the block
+      std::uint64_t readyCycle = 0; // the cycle the block arrives from the data memory
+      std::uint64_t issueCycle = 0; // the cycle it was prefetched
+      bool used = false; // true once a load has hit it
+    } BufferEntry;
+
+    std::uint32_t _blockOf(const std::uint32_t address) const {
+      return address & ~(std::uint32_t)(_blockBytes - 1);
+    }
+
+    BufferEntry *_find(const std::uint32_t block) {
+      for (BufferEntry &entry : _buffer) {
+        if (entry.valid && entry.block == block) {
+          return &entry;
+        }
+      }
+      return nullptr;
+    }
+
+    // the load at 'pc' accesses 'address': its entry learns the stride, and
+    // prefetches along it once it is steady
+    void _train(const std::uint32_t pc, const std::uint32_t address) {
+      TableEntry &entry = _table[(pc >> 2) % _table.size()];
+      if (!entry.valid || entry.pc != pc) {
+        entry = TableEntry();
+        entry.valid = true;
+        entry.pc = pc;
+        entry.lastAddress = address;
+        return;
+      }
+      const std::int32_t stride = (std::int32_t)(address - entry.lastAddress);
+      entry.steady = (stride != 0 && stride == entry.stride);
+      entry.stride = stride;
+      entry.lastAddress = address;
+      if (!entry.steady) {
+        return;
+      }
+      for (size_t i = 0; i < _degree; i++) {
+        _prefetch(_blockOf(address + (std::uint32_t)stride * (std::uint32_t)(_distance + i)));
+      }
+    }
+
+    void _prefetch(const std::uint32_t block) {
+      if (_find(block) != nullptr) {
+        _numRedundantPrefetches += 1;
+        return;
+      }
+      // a stream uses each block once, so the blocks already used make room
+      // before the ones still ahead of the loads
+      BufferEntry *victim = &_buffer[0];
+      for (BufferEntry &entry : _buffer) {
+        if (!entry.valid) {
+          victim = &entry;
+          break;
+        }
+        if (entry.used != victim->used ? entry.used : entry.issueCycle < victim->issueCycle) {
+          victim = &entry;
+        }
+      }
+      if (victim->valid && !victim->used) {
+        _numUselessPrefetches += 1;
+      }
+      victim->valid = true;
+      victim->block = block;
+      victim->readyCycle = _cycle + _latency - 1;
+      victim->issueCycle = _cycle;
+      victim->used = false;
+      _numPrefetches += 1;
+    }
+
+    const Wire<32> *_iAddress;
+    const Wire<32> *_iWriteData;
+    const Wire<1> *_iMemRead;
+    const Wire<1> *_iMemWrite;
+    const Wire<32> *_iPCPlus4;
+    Wire<32> *_oReadData;
+    Wire<1> *_oStall;
+
+    DigitalCircuit *_memory;
+    Wire<32> *_memAddress;
+    Wire<32> *_memWriteData;
+    Wire<1> *_memRead;
+    Wire<1> *_memWrite;
+    const Wire<32> *_memReadData;
+    const Wire<1> *_memStall; // nullptr if '_memory' is the data memory
+
+    size_t _latency;
+    size_t _degree;
+    size_t _distance;
+    size_t _blockBytes;
+    std::vector<TableEntry> _table; // by PC modulo the entries
+    std::vector<BufferEntry> _buffer;
+
+    std::uint64_t _cycle; // the cycles the prefetcher has seen
+    bool _pending; // true from the first cycle of a load in MEM1 until it reads the data memory
+    std::uint64_t _readyCycle; // the cycle the pending load reads the data memory
+
+    // Statistics
+    std::uint64_t _numLoads;
+    std::uint64_t _numTimelyHits; // the loads whose block had arrived
+    std::uint64_t _numLateHits; // the loads whose block was still on its way
+    std::uint64_t _numMisses;
+    std::uint64_t _numPrefetches;
+    std::uint64_t _numRedundantPrefetches; // the prefetches of blocks already in the buffer, not issued
+    std::uint64_t _numUsefulPrefetches; // the prefetched blocks hit at least once
+    std::uint64_t _numUselessPrefetches; // the prefetched blocks replaced before any hit
+    std::uint64_t _numStallCycles;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __SWEEP_VARIANT_H__
+#define __SWEEP_VARIANT_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SweepJob
+//   - one run of the design-space sweep: a program and the run-time settings
+typedef struct {
+  std::string program; // the common prefix of the program's files (e.g., "tests/ex1")
+  std::uint32_t initialPC; // the initial PC, as given to testAssn4
+  bool bigEndian; // true for a big-endian data and instruction memory
+  std::uint64_t maxCycles; // the most cycles to simulate, if the program has not halted by then
+  unsigned rasDepth; // the RAS entries of the jump predictor (variants with jumpPrediction)
+  unsigned itcEntries; // the ITC entries of the jump predictor (variants with jumpPrediction)
+  unsigned prefetchDegree; // the prefetches per load (variants with prefetcher)
+  unsigned prefetchDistance; // the strides ahead of the first prefetch (variants with prefetcher)
+} SweepJob;
+
+typedef struct {
+  bool halted; // true if the program halted (see PipelinedCPU::isHalted()), false if the run hit maxCycles
+  std::uint64_t cycles; // the number of simulated cycles
+  std::uint64_t retired; // the number of instructions that have left the WB stage
+  double hostSeconds; // the host time spent on the job, including the set-up
+  double cycleTimeNs; // the minimum cycle time of the variant (see TimingModel)
+} SweepResult;
+
+// SweepVariant
+//   - a PipelinedCPU compiled with one set of compile-time options; each one
+//     is built from sweepVariant.cc into its own namespace, so that all of
+//     them can live in the same binary
+typedef struct {
+  bool dataForwarding; // ENABLE_DATA_FORWARDING
+  bool hazardDetection; // ENABLE_HAZARD_DETECTION
+  unsigned ifStages; // PIPELINE_IF_STAGES
+  unsigned memStages; // PIPELINE_MEM_STAGES
+  bool jumpPrediction; // ENABLE_JUMP_PREDICTION (every variant has ENABLE_JUMPS)
+  bool prefetcher; // ENABLE_PREFETCHER
+  SweepResult (*run)(const SweepJob &job); // simulates 'job' on this variant
+} SweepVariant;
+
+inline std::vector<SweepVariant> &sweepVariants() {
+  static std::vector<SweepVariant> variants;
+  return variants;
+}
+
+// SweepVariantRegistrar
+//   - adds a variant to sweepVariants() during static initialization
+class SweepVariantRegistrar {
+  public:
+    SweepVariantRegistrar(const SweepVariant &variant) {
+      sweepVariants().push_back(variant);
+    }
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef __TIMING_MODEL_H__
+#define __TIMING_MODEL_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+// the delays of the components, in picoseconds
+#ifndef TIMING_LATCH_PS
+#define TIMING_LATCH_PS 50 // <-- the clock-to-output plus setup time of a pipeline latch, added to every stage
+#endif
+#ifndef TIMING_GATE_PS
+#define TIMING_GATE_PS 15 // <-- a single gate (e.g., the AND of 'Branch' and 'Zero')
+#endif
+#ifndef TIMING_MUX2_PS
+#define TIMING_MUX2_PS 30 // <-- MUX2
+#endif
+#ifndef TIMING_MUX3_PS
+#define TIMING_MUX3_PS 40 // <-- MUX3
+#endif
+#ifndef TIMING_MUX4_PS
+#define TIMING_MUX4_PS 45 // <-- MUX4
+#endif
+#ifndef TIMING_ADDER_BIT_PS
+#define TIMING_ADDER_BIT_PS 10 // <-- one bit of the ripple-carry Adder<N>, which takes N times as long
+#endif
+#ifndef TIMING_ALU_PS
+#define TIMING_ALU_PS 400 // <-- the ALU, with its own carry chain and the 'Zero' detection
+#endif
+#ifndef TIMING_ALU_CONTROL_PS
+#define TIMING_ALU_CONTROL_PS 40 // <-- the ALU Control unit
+#endif
+#ifndef TIMING_CONTROL_PS
+#define TIMING_CONTROL_PS 80 // <-- the Control unit
+#endif
+#ifndef TIMING_SIGN_EXTEND_PS
+#define TIMING_SIGN_EXTEND_PS 10 // <-- SignExtend
+#endif
+#ifndef TIMING_REGISTER_FILE_READ_PS
+#define TIMING_REGISTER_FILE_READ_PS 200 // <-- a read port of the register file
+#endif
+#ifndef TIMING_REGISTER_FILE_WRITE_PS
+#define TIMING_REGISTER_FILE_WRITE_PS 150 // <-- the write port of the register file
+#endif
+#ifndef TIMING_MEMORY_PS
+#define TIMING_MEMORY_PS 600 // <-- an access to the instruction or the data memory
+#endif
+#ifndef TIMING_FORWARDING_UNIT_PS
+#define TIMING_FORWARDING_UNIT_PS 90 // <-- the Forwarding unit (register number comparators and priority)
+#endif
+#ifndef TIMING_HAZARD_DETECTION_PS
+#define TIMING_HAZARD_DETECTION_PS 90 // <-- the Hazard Detection unit, and the stall check of the multiply/divide unit
+#endif
+#ifndef TIMING_MUL_DIV_STEP_PS
+#define TIMING_MUL_DIV_STEP_PS 400 // <-- one cycle of the iterative multiply/divide unit
+#endif
+#ifndef TIMING_BUFFER_LOOKUP_PS
+#define TIMING_BUFFER_LOOKUP_PS 150 // <-- a search of the store buffer, the prefetch buffer, the fetch queue, or a TLB
+#endif
+#ifndef TIMING_SYNC_PS
+#define TIMING_SYNC_PS 60 // <-- the handoff of the memory bridge to a synchronizing latch
+#endif
+
+// TimingModel
+//   - a static timing analysis of the datapath: the components are the
+//     nodes of a graph, each with the stage it belongs to and its delay, and
+//     the wires between them are its edges
+//   - a component is added with the wires it reads and drives (those of a
+//     DigitalCircuit come from the circuit itself), in the order the stage
+//     evaluates them; an input is driven by the last component added before
+//     it that drives the same wire, and a wire no earlier component drives
+//     holds its value from the last cycle (e.g., the PC), so the edges
+//     follow the real connections and the graph has no cycles
+//   - a stage starts at the latches before it, so only the edges between
+//     two components of the same stage are followed; the delay of a stage is
+//     its longest path plus the overhead of a latch, and the slowest stage
+//     of the core clock sets the minimum cycle time
+//   - a stage off the core clock (e.g., the data memory in a clock domain of
+//     its own) is reported, but does not count towards the cycle time
+class TimingModel {
+
+  public:
+
+    // double TimingModel::adderDelay()
+    //   - a ripple-carry adder of 'numBits' bits
+    static double adderDelay(const size_t numBits) {
+      return (double)numBits * TIMING_ADDER_BIT_PS;
+    }
+
+    // double TimingModel::comparatorDelay()
+    //   - an equality comparator of 'numBits' bits: a level of XORs and a
+    //     tree of 2-input ORs
+    static double comparatorDelay(const size_t numBits) {
+      size_t numLevels = 1;
+      for (size_t n = 1; n < numBits; n *= 2) {
+        numLevels += 1;
+      }
+      return (double)numLevels * TIMING_GATE_PS;
+    }
+
+    // void TimingModel::addStage()
+    //   - the stages are reported in the order they are added
+    void addStage(const std::string &stage, const bool coreClock = true) {
+      assert(_stageOf(stage) == _stages.size());
+      Stage_t entry = { stage, coreClock, 0.0, {} };
+      _stages.push_back(entry);
+      _analyzed = false;
+    }
+
+    typedef std::vector<const void *> Signals; // the wires (or registers) a component reads or drives
+
+    // void TimingModel::add()
+    //   - a component of 'stage' whose 'outputs' settle 'delay' ps after the
+    //     last of its 'inputs'
+    void add(const std::string &stage, const std::string &name, const double delay,
+             const Signals &inputs, const Signals &outputs) {
+      assert(_stageOf(stage) < _stages.size());
+      Node_t node = { name, _stageOf(stage), delay, inputs, outputs };
+      _nodes.push_back(node);
+      _analyzed = false;
+    }
+
+    //   - a circuit, with the wires it was constructed with
+    void add(const std::string &stage, const std::string &name, const double delay, const DigitalCircuit *circuit) {
+      assert(circuit != nullptr);
+      Signals inputs, outputs;
+      circuit->getPorts(inputs, outputs);
+      add(stage, name, delay, inputs, outputs);
+    }
+
+    // double TimingModel::getMinCycleTime()
+    //   - in picoseconds
+    double getMinCycleTime() {
+      _analyze();
+      double cycleTime = 0.0;
+      for (const Stage_t &stage : _stages) {
+        if (stage.coreClock) {
+          cycleTime = std::max(cycleTime, stage.delay);
+        }
+      }
+      return cycleTime;
+    }
+
+    // void TimingModel::printStats()
+    //   - the critical path of each stage, and the execution time of
+    //     'numCycles' cycles at the minimum cycle time
+    void printStats(const std::uint64_t numCycles) {
+      _analyze();
+      const double cycleTime = getMinCycleTime();
+      printf("Timing Statistics (latch overhead %d ps):\n", TIMING_LATCH_PS);
+      std::string criticalStage;
+      for (const Stage_t &stage : _stages) {
+        std::string path;
+        for (const size_t n : stage.path) {
+          char step[96];
+          snprintf(step, sizeof(step), "%s%s %.0f", path.empty() ? "" : " -> ", _nodes[n].name.c_str(), _nodes[n].delay);
+          path += step;
+        }
+        printf("  %-18s = %.0f ps (%s)%s\n", stage.name.c_str(), stage.delay,
+               path.empty() ? "latches only" : path.c_str(), stage.coreClock ? "" : ", off the core clock");
+        if (stage.coreClock && stage.delay == cycleTime && criticalStage.empty()) {
+          criticalStage = stage.name;
+        }
+      }
+      printf("  criticalStage      = %s\n", criticalStage.c_str());
+      printf("  minCycleTime       = %.3f ns\n", cycleTime / 1000.0);
+      printf("  maxFrequency       = %.1f MHz\n", cycleTime == 0.0 ? 0.0 : 1e6 / cycleTime);
+      printf("  cycles             = %lu\n", (unsigned long)numCycles);
+      printf("  estimatedTime      = %.1f ns\n", (double)numCycles * cycleTime / 1000.0);
+    }
+
+  private:
+
+    typedef struct {
+      std::string name;
+      bool coreClock;
+      double delay; // the longest path, with the latch overhead
+      std::vector<size_t> path; // the nodes on it, first to last
+    } Stage_t;
+
+    typedef struct {
+      std::string name;
+      size_t stage;
+      double delay;
+      Signals inputs;
+      Signals outputs;
+    } Node_t;
+
+    size_t _stageOf(const std::string &name) const {
+      for (size_t s = 0; s < _stages.size(); s++) {
+        if (_stages[s].name == name) {
+          return s;
+        }
+      }
+      return _stages.size();
+    }
+
+    // the node that drives 'signal' for node 'n': the last one before it
+    // that drives the wire, if any
+    size_t _driverOf(const void *signal, const size_t n) const {
+      for (size_t m = n; m-- > 0;) {
+        if (std::find(_nodes[m].outputs.begin(), _nodes[m].outputs.end(), signal) != _nodes[m].outputs.end()) {
+          return m;
+        }
+      }
+      return _nodes.size();
+    }
+
+    // the drivers come before the nodes they drive, so the arrival time of
+    // each node's output is known once those of its inputs are
+    void _analyze() {
+      if (_analyzed) {
+        return;
+      }
+      std::vector<double> arrival(_nodes.size(), 0.0);
+      std::vector<size_t> critical(_nodes.size(), _nodes.size()); // the input on the longest path to the node
+      for (size_t n = 0; n < _nodes.size(); n++) {
+        double start = 0.0;
+        for (const void *signal : _nodes[n].inputs) {
+          const size_t input = _driverOf(signal, n);
+          if (input < _nodes.size() && _nodes[input].stage == _nodes[n].stage && arrival[input] > start) {
+            start = arrival[input];
+            critical[n] = input;
+          }
+        }
+        arrival[n] = start + _nodes[n].delay;
+      }
+      for (size_t s = 0; s < _stages.size(); s++) {
+        Stage_t &stage = _stages[s];
+        size_t last = _nodes.size();
+        for (size_t n = 0; n < _nodes.size(); n++) {
+          if (_nodes[n].stage == s && (last == _nodes.size() || arrival[n] > arrival[last])) {
+            last = n;
+          }
+        }
+        stage.delay = TIMING_LATCH_PS + (last == _nodes.size() ? 0.0 : arrival[last]);
+        stage.path.clear();
+        for (size_t n = last; n < _nodes.size(); n = critical[n]) {
+          stage.path.insert(stage.path.begin(), n);
+        }
+      }
+      _analyzed = true;
+    }
+
+    std::vector<Stage_t> _stages;
+    std::vector<Node_t> _nodes; // in the order they were added
+    bool _analyzed = false;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
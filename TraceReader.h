@@ -0,0 +1,188 @@
+#ifndef __TRACE_READER_H__
+#define __TRACE_READER_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <zlib.h>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 4096 // <-- the number of trace records buffered in memory
+#endif
+
+#ifndef TRACE_REWIND_LIMIT
+#define TRACE_REWIND_LIMIT 4 // <-- the number of consumed records that can be handed back
+#endif
+
+class TraceReader : public DigitalCircuit {
+
+  public:
+
+    // TraceReader::TraceReader()
+    //   - streams an instruction trace, plain or gzip-compressed; each line
+    //     of the trace file consists of:
+    //       - the hexadecimal address of the instruction
+    //       - the eight-digit hexadecimal value of the instruction
+    //       - (optional) the hexadecimal effective address of a load or a
+    //         store, or the target address of a taken branch
+    //     e.g., "1004 8d0a0004 2004" is a load from 0x2004 at 0x1004, and a
+    //     line starting with '#' is a comment
+    //   - only 'size' records are kept in memory at any time, so the length
+    //     of the trace is not limited by the host memory
+    TraceReader(const std::string &name,
+                const char *traceFileName,
+                Wire<32> *oPC,
+                Wire<32> *oInstruction,
+                Wire<32> *oAddress,
+                Wire<1> *oAddressValid,
+                Wire<1> *oValid,
+                const size_t size = TRACE_BUFFER_SIZE)
+      : DigitalCircuit(name) {
+      _oPC = oPC;
+      _oInstruction = oInstruction;
+      _oAddress = oAddress;
+      _oAddressValid = oAddressValid;
+      _oValid = oValid;
+
+      assert(size > TRACE_REWIND_LIMIT);
+      _records.resize(size);
+      _head = 0;
+      _count = 0;
+      _history = 0;
+
+      _traceFile = gzopen(traceFileName, "rb");
+      if (_traceFile == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open the trace file %s\n", __func__, traceFileName);
+        assert(false);
+      }
+      gzbuffer(_traceFile, 128 * 1024);
+      _lineNumber = 0;
+      _endOfTrace = false;
+    }
+
+    // void TraceReader::advanceCycle()
+    //   - outputs the next record of the trace; 'oValid' is 0 once the trace
+    //     has been exhausted
+    virtual void advanceCycle() {
+      if (_count == 0) {
+        _refill();
+      }
+      if (_count == 0) {
+        *_oPC = 0;
+        *_oInstruction = 0;
+        *_oAddress = 0;
+        *_oAddressValid = 0;
+        *_oValid = 0;
+        return;
+      }
+
+      const Record &record = _records[_head];
+      *_oPC = record.pc;
+      *_oInstruction = record.instruction;
+      *_oAddress = record.address;
+      *_oAddressValid = record.addressValid;
+      *_oValid = 1;
+
+      _head = (_head + 1) % _records.size();
+      _count -= 1;
+      _history = std::min(_history + 1, (size_t)TRACE_REWIND_LIMIT);
+      _numRecords += 1;
+    }
+
+    // void TraceReader::rewind()
+    //   - hands the last 'n' records back, so that they are output again
+    //     (e.g., after the fetch stages holding them have been flushed)
+    void rewind(size_t n) {
+      assert(n <= _history);
+      _head = (_head + _records.size() - n) % _records.size();
+      _count += n;
+      _history -= n;
+      _numRecords -= n;
+    }
+
+    std::uint64_t getNumRecords() const {
+      return _numRecords;
+    }
+
+    ~TraceReader() {
+      gzclose(_traceFile);
+    }
+
+  private:
+
+    // void TraceReader::_refill()
+    //   - reads records into the free part of the ring buffer, keeping the
+    //     last TRACE_REWIND_LIMIT consumed records intact
+    void _refill() {
+      char line[256];
+      while (!_endOfTrace && _count + TRACE_REWIND_LIMIT < _records.size()) {
+        if (gzgets(_traceFile, line, sizeof(line)) == NULL) {
+          int error;
+          const char *message = gzerror(_traceFile, &error);
+          if (error != Z_OK && error != Z_STREAM_END) {
+            fprintf(stderr, "[%s] ERROR: cannot read the trace (%s)\n", __func__, message);
+            assert(false);
+          }
+          _endOfTrace = true;
+          break;
+        }
+        _lineNumber += 1;
+
+        unsigned int pc, instruction, address;
+        char first = ' ';
+        if (sscanf(line, " %c", &first) != 1 || first == '#') {
+          continue;
+        }
+        int n = sscanf(line, " %x %x %x", &pc, &instruction, &address);
+        if (n < 2) {
+          fprintf(stderr, "[%s] ERROR: malformed trace record at line %lu\n", __func__,
+                  (unsigned long)_lineNumber);
+          assert(false);
+        }
+
+        Record &record = _records[(_head + _count) % _records.size()];
+        record.pc = pc;
+        record.instruction = instruction;
+        record.address = (n == 3) ? address : 0;
+        record.addressValid = (n == 3);
+        _count += 1;
+      }
+    }
+
+    typedef struct {
+      std::uint32_t pc; // the address of the instruction
+      std::uint32_t instruction; // the 32-bit instruction
+      std::uint32_t address; // the effective address, or the taken-branch target
+      bool addressValid; // true if the record has the third field
+    } Record;
+
+    Wire<32> *_oPC;
+    Wire<32> *_oInstruction;
+    Wire<32> *_oAddress;
+    Wire<1> *_oAddressValid;
+    Wire<1> *_oValid;
+
+    gzFile _traceFile;
+    std::uint64_t _lineNumber;
+    bool _endOfTrace;
+
+    std::vector<Record> _records; // the ring buffer
+    size_t _head; // the index of the next record to output
+    size_t _count; // the number of buffered records not yet output
+    size_t _history; // the number of consumed records that can be rewound
+
+    std::uint64_t _numRecords = 0; // the number of records output so far
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef __VCD_WRITER_H__
+#define __VCD_WRITER_H__
+
+#include "WireRegistry.h"
+#include "SimulatorNamespace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef VCD_BUFFER_SIZE
+#define VCD_BUFFER_SIZE (1024 * 1024) // <-- the bytes buffered before a write to the VCD file
+#endif
+
+class VCDWriter {
+
+  public:
+
+    // VCDWriter::VCDWriter()
+    //   - writes the signals in 'registry' to a Value Change Dump (VCD) file,
+    //     one time unit per cycle, for the cycles in [startCycle, endCycle]
+    //   - the '.'-separated names of the registry become nested scopes under
+    //     'topName', so the hierarchy shows up in waveform viewers (e.g.,
+    //     GTKWave)
+    VCDWriter(const char *fileName,
+              const WireRegistry *registry,
+              const std::string &topName,
+              const std::uint64_t startCycle = 0,
+              const std::uint64_t endCycle = UINT64_MAX) {
+      _registry = registry;
+      _startCycle = startCycle;
+      _endCycle = endCycle;
+      _dumped = false;
+
+      _file = fopen(fileName, "w");
+      if (_file == NULL) {
+        fprintf(stderr, "[%s] ERROR: cannot open the VCD file %s\n", __func__, fileName);
+        assert(false);
+      }
+      _buffer.reserve(VCD_BUFFER_SIZE + 256);
+
+      _ids.resize(_registry->size());
+      _values.assign(_registry->size(), 0);
+      for (size_t i = 0; i < _registry->size(); i++) {
+        // the identifier codes use the printable characters '!' to '~'
+        size_t n = i;
+        do {
+          _ids[i] += (char)('!' + n % 94);
+          n /= 94;
+        } while (n > 0);
+      }
+
+      _writeHeader(topName);
+    }
+
+    // void VCDWriter::sample()
+    //   - records the signals at the end of 'cycle'; only the signals whose
+    //     values have changed since the last sample are written
+    void sample(const std::uint64_t cycle) {
+      if (cycle < _startCycle || cycle > _endCycle) {
+        return;
+      }
+
+      _buffer += '#';
+      _buffer += std::to_string(cycle);
+      _buffer += '\n';
+      if (!_dumped) {
+        _buffer += "$dumpvars\n";
+      }
+      for (size_t i = 0; i < _registry->size(); i++) {
+        std::uint32_t value = _registry->read(i);
+        if (_dumped && value == _values[i]) {
+          continue;
+        }
+        _values[i] = value;
+        _writeValue(i, value);
+      }
+      if (!_dumped) {
+        _buffer += "$end\n";
+        _dumped = true;
+      }
+
+      if (_buffer.size() >= VCD_BUFFER_SIZE) {
+        _flush();
+      }
+    }
+
+    ~VCDWriter() {
+      _flush();
+      fclose(_file);
+    }
+
+  private:
+
+    void _writeHeader(const std::string &topName) {
+      _buffer += "$timescale 1ns $end\n";
+      _buffer += "$scope module " + topName + " $end\n";
+
+      // the entries are sorted by name, so each scope is opened only once
+      std::vector<size_t> order(_registry->size());
+      for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return (*_registry)[a].name < (*_registry)[b].name;
+      });
+
+      std::vector<std::string> scopes; // the currently open scopes
+      for (size_t i : order) {
+        const WireRegistry::Entry &entry = (*_registry)[i];
+        std::vector<std::string> path;
+        size_t begin = 0, end;
+        while ((end = entry.name.find('.', begin)) != std::string::npos) {
+          path.push_back(entry.name.substr(begin, end - begin));
+          begin = end + 1;
+        }
+        std::string leaf = entry.name.substr(begin);
+
+        size_t common = 0;
+        while (common < scopes.size() && common < path.size() && scopes[common] == path[common]) {
+          common += 1;
+        }
+        while (scopes.size() > common) {
+          _buffer += "$upscope $end\n";
+          scopes.pop_back();
+        }
+        while (scopes.size() < path.size()) {
+          _buffer += "$scope module " + path[scopes.size()] + " $end\n";
+          scopes.push_back(path[scopes.size()]);
+        }
+        _buffer += "$var wire " + std::to_string(entry.width) + " " + _ids[i] + " " + leaf + " $end\n";
+      }
+      while (!scopes.empty()) {
+        _buffer += "$upscope $end\n";
+        scopes.pop_back();
+      }
+
+      _buffer += "$upscope $end\n";
+      _buffer += "$enddefinitions $end\n";
+    }
+
+    void _writeValue(size_t i, std::uint32_t value) {
+      size_t width = (*_registry)[i].width;
+      if (width == 1) {
+        _buffer += (char)('0' + (value & 1));
+      } else {
+        // leading zeros are left out, as the VCD format allows
+        _buffer += 'b';
+        int msb = (int)width - 1;
+        while (msb > 0 && ((value >> msb) & 1) == 0) {
+          msb -= 1;
+        }
+        for (int b = msb; b >= 0; b--) {
+          _buffer += (char)('0' + ((value >> b) & 1));
+        }
+        _buffer += ' ';
+      }
+      _buffer += _ids[i];
+      _buffer += '\n';
+    }
+
+    void _flush() {
+      fwrite(_buffer.data(), 1, _buffer.size(), _file);
+      _buffer.clear();
+    }
+
+    const WireRegistry *_registry;
+    std::uint64_t _startCycle;
+    std::uint64_t _endCycle;
+    bool _dumped; // true once the initial values have been written
+
+    FILE *_file;
+    std::string _buffer;
+    std::vector<std::string> _ids; // the VCD identifier code of each signal
+    std::vector<std::uint32_t> _values; // the last value written for each signal
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
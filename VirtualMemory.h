@@ -0,0 +1,293 @@
+#ifndef __VIRTUAL_MEMORY_H__
+#define __VIRTUAL_MEMORY_H__
+
+#include "Memory.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+#ifndef VM_PAGE_BYTES
+#define VM_PAGE_BYTES 4096 // <-- the bytes of a page (a power of two, at least 4)
+#endif
+
+#ifndef ITLB_ENTRIES
+#define ITLB_ENTRIES 16 // <-- the entries of the iTLB
+#endif
+
+#ifndef ITLB_WAYS
+#define ITLB_WAYS 4 // <-- the associativity of the iTLB (ITLB_ENTRIES for a fully associative one)
+#endif
+
+#ifndef DTLB_ENTRIES
+#define DTLB_ENTRIES 32 // <-- the entries of the dTLB
+#endif
+
+#ifndef DTLB_WAYS
+#define DTLB_WAYS 4 // <-- the associativity of the dTLB (DTLB_ENTRIES for a fully associative one)
+#endif
+
+#ifndef VM_WALK_LATENCY
+#define VM_WALK_LATENCY 20 // <-- the cycles a TLB miss stalls its stage: the refill handler and its read of the page table
+#endif
+
+#ifndef VM_PAGE_TABLE_BASE
+#define VM_PAGE_TABLE_BASE (MEMORY_SIZE - MEMORY_SIZE / VM_PAGE_BYTES * 4) // <-- the address of the page table in the data memory (at its top, by default)
+#endif
+
+// TLB
+//   - a set-associative cache of translations from virtual page numbers to
+//     page frames, with LRU replacement in each set
+class TLB {
+
+  public:
+
+    TLB(const size_t numEntries, const size_t numWays) {
+      assert(numWays > 0 && numEntries % numWays == 0);
+      _numWays = numWays;
+      _numSets = numEntries / numWays;
+      _entries.resize(numEntries);
+      flush();
+    }
+
+    // bool TLB::lookup()
+    //   - the frame of the page 'vpn', if the TLB holds it; a hit makes the
+    //     entry the most recently used of its set
+    bool lookup(const std::uint32_t vpn, std::uint32_t &frame) {
+      Entry_t *set = &_entries[(vpn % _numSets) * _numWays];
+      for (size_t w = 0; w < _numWays; w++) {
+        if (set[w].valid && set[w].vpn == vpn) {
+          set[w].lastUse = ++_useCounter;
+          frame = set[w].frame;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // void TLB::fill()
+    //   - the translation of 'vpn' takes an invalid entry of its set, or
+    //     else the least recently used one
+    void fill(const std::uint32_t vpn, const std::uint32_t frame) {
+      Entry_t *set = &_entries[(vpn % _numSets) * _numWays];
+      Entry_t *victim = &set[0];
+      for (size_t w = 0; w < _numWays; w++) {
+        if (!set[w].valid) {
+          victim = &set[w];
+          break;
+        }
+        if (set[w].lastUse < victim->lastUse) {
+          victim = &set[w];
+        }
+      }
+      victim->valid = true;
+      victim->vpn = vpn;
+      victim->frame = frame;
+      victim->lastUse = ++_useCounter;
+    }
+
+    void flush() {
+      for (Entry_t &entry : _entries) {
+        entry = Entry_t();
+      }
+      _useCounter = 0;
+    }
+
+    size_t getNumEntries() const {
+      return _entries.size();
+    }
+
+    size_t getNumWays() const {
+      return _numWays;
+    }
+
+  private:
+
+    typedef struct {
+      bool valid = false;
+      std::uint32_t vpn = 0;
+      std::uint32_t frame = 0; // the address of the first byte of the page frame
+      std::uint64_t lastUse = 0;
+    } Entry_t;
+
+    size_t _numWays;
+    size_t _numSets;
+    std::vector<Entry_t> _entries; // set by set
+    std::uint64_t _useCounter;
+
+};
+
+// VirtualMemory
+//   - translates the addresses of the instruction fetches and of the loads
+//     and the stores through an iTLB and a dTLB; a miss is refilled, as by
+//     the software handler of a MIPS TLB miss, from a linear page table in
+//     the data memory, and stalls the stage that missed for 'walkLatency'
+//     cycles
+//   - a page table entry (PTE) is the address of the page frame with bit 0
+//     set if it is valid; the walk maps a page whose PTE is not valid onto
+//     the frame of the same address and writes the PTE, as an OS would have
+//     before the run, so a program runs the same as without translation
+//     unless its data memory file sets PTEs of its own
+//   - each port has a walk of its own; a walk whose access has gone away
+//     (e.g., a fetch a taken branch redirects) is dropped
+class VirtualMemory {
+
+  public:
+
+    enum Port { Fetch, Data, NumPorts };
+
+    VirtualMemory(Memory *pageTableMemory,
+                  const size_t pageBytes = VM_PAGE_BYTES,
+                  const size_t iTLBEntries = ITLB_ENTRIES,
+                  const size_t iTLBWays = ITLB_WAYS,
+                  const size_t dTLBEntries = DTLB_ENTRIES,
+                  const size_t dTLBWays = DTLB_WAYS,
+                  const size_t walkLatency = VM_WALK_LATENCY,
+                  const std::uint32_t pageTableBase = VM_PAGE_TABLE_BASE)
+      : _ports{ { TLB(iTLBEntries, iTLBWays), false, 0, 0, 0, 0, 0 },
+                { TLB(dTLBEntries, dTLBWays), false, 0, 0, 0, 0, 0 } } {
+      assert(pageBytes >= 4 && (pageBytes & (pageBytes - 1)) == 0);
+      assert(walkLatency > 0);
+      assert((pageTableBase & 3) == 0 && pageTableBase <= MEMORY_SIZE - MEMORY_SIZE / pageBytes * 4);
+      _memory = pageTableMemory;
+      _pageBytes = pageBytes;
+      _walkLatency = walkLatency;
+      _pageTableBase = pageTableBase;
+      reset();
+    }
+
+    // bool VirtualMemory::translate()
+    //   - the physical address of 'address' in 'physical' if the TLB of
+    //     'port' holds its page, or once the walk its miss started is done;
+    //     false while the stage must stall
+    //   - the stage calls it in every 'cycle' the access waits
+    bool translate(const Port port, const std::uint32_t address, const std::uint64_t cycle, std::uint32_t &physical) {
+      Port_t &p = _ports[port];
+      const std::uint32_t vpn = address / _pageBytes;
+      const std::uint32_t offset = address & (_pageBytes - 1);
+      std::uint32_t frame;
+      if (p.walking && p.walkVPN == vpn) {
+        if (cycle < p.walkDoneCycle) {
+          p.numWalkCycles += 1;
+          return false;
+        }
+        p.walking = false;
+        frame = _walk(vpn);
+        p.tlb.fill(vpn, frame);
+        physical = frame | offset;
+        return true;
+      }
+      p.walking = false;
+      p.numAccesses += 1;
+      if (p.tlb.lookup(vpn, frame)) {
+        physical = frame | offset;
+        return true;
+      }
+      p.numMisses += 1;
+      p.numWalkCycles += 1;
+      p.walking = true;
+      p.walkVPN = vpn;
+      p.walkDoneCycle = cycle + _walkLatency;
+      return false;
+    }
+
+    // std::uint32_t VirtualMemory::probe()
+    //   - the physical address translate() would give for 'address', with
+    //     neither the TLBs nor the timing, and without mapping the page; an
+    //     address outside the memory is its own
+    std::uint32_t probe(const std::uint32_t address) const {
+      const std::uint32_t vpn = address / _pageBytes;
+      if (vpn >= MEMORY_SIZE / _pageBytes) {
+        return address;
+      }
+      const std::uint32_t pte = _memory->readWord(_pageTableBase + 4 * vpn);
+      const std::uint32_t frame = (pte & 1) ? (pte & ~(std::uint32_t)(_pageBytes - 1)) : vpn * (std::uint32_t)_pageBytes;
+      return frame | (address & (_pageBytes - 1));
+    }
+
+    // void VirtualMemory::reset()
+    //   - flushes the TLBs, and drops the walks and the statistics; the page
+    //     table is in the data memory, which is cleared on its own
+    void reset() {
+      for (Port_t &p : _ports) {
+        p.tlb.flush();
+        p.walking = false;
+        p.walkVPN = 0;
+        p.walkDoneCycle = 0;
+        p.numAccesses = 0;
+        p.numMisses = 0;
+        p.numWalkCycles = 0;
+      }
+      _numPagesMapped = 0;
+    }
+
+    void printStats() {
+      const Port_t &i = _ports[Fetch], &d = _ports[Data];
+      printf("Virtual Memory Statistics (%lu-byte pages, iTLB %lu entries %lu-way, dTLB %lu entries %lu-way, walk latency %lu):\n",
+             (unsigned long)_pageBytes, (unsigned long)i.tlb.getNumEntries(), (unsigned long)i.tlb.getNumWays(),
+             (unsigned long)d.tlb.getNumEntries(), (unsigned long)d.tlb.getNumWays(), (unsigned long)_walkLatency);
+      // reach: the bytes the TLB maps at once
+      printf("  iTLBReach          = %lu\n", (unsigned long)(i.tlb.getNumEntries() * _pageBytes));
+      printf("  iTLBAccesses       = %lu\n", (unsigned long)i.numAccesses);
+      printf("  iTLBMisses         = %lu\n", (unsigned long)i.numMisses);
+      printf("  iTLBMissRate       = %.2f%%\n",
+             i.numAccesses == 0 ? 0.0 : 100.0 * (double)i.numMisses / (double)i.numAccesses);
+      printf("  iTLBWalkCycles     = %lu\n", (unsigned long)i.numWalkCycles);
+      printf("  dTLBReach          = %lu\n", (unsigned long)(d.tlb.getNumEntries() * _pageBytes));
+      printf("  dTLBAccesses       = %lu\n", (unsigned long)d.numAccesses);
+      printf("  dTLBMisses         = %lu\n", (unsigned long)d.numMisses);
+      printf("  dTLBMissRate       = %.2f%%\n",
+             d.numAccesses == 0 ? 0.0 : 100.0 * (double)d.numMisses / (double)d.numAccesses);
+      printf("  dTLBWalkCycles     = %lu\n", (unsigned long)d.numWalkCycles);
+      printf("  pagesMapped        = %lu\n", (unsigned long)_numPagesMapped);
+    }
+
+  private:
+
+    typedef struct {
+      TLB tlb;
+      bool walking; // true from a miss until its walk is done or dropped
+      std::uint32_t walkVPN; // the page being walked
+      std::uint64_t walkDoneCycle; // the cycle the walk refills the TLB
+
+      // Statistics
+      std::uint64_t numAccesses; // the lookups, each access counted once however long it waits
+      std::uint64_t numMisses;
+      std::uint64_t numWalkCycles; // the cycles the stage stalled for the walks
+    } Port_t;
+
+    // the frame of page 'vpn', from its PTE (which is written first if it
+    // is not valid)
+    std::uint32_t _walk(const std::uint32_t vpn) {
+      if (vpn >= MEMORY_SIZE / _pageBytes) {
+        fprintf(stderr, "[%s] ERROR: page 0x%lx is outside the memory\n", __func__, (unsigned long)vpn);
+        assert(false);
+      }
+      const std::uint32_t pteAddress = _pageTableBase + 4 * vpn;
+      std::uint32_t pte = _memory->readWord(pteAddress);
+      if ((pte & 1) == 0) {
+        pte = vpn * (std::uint32_t)_pageBytes | 1;
+        _memory->writeWord(pteAddress, pte);
+        _numPagesMapped += 1;
+      }
+      return pte & ~(std::uint32_t)(_pageBytes - 1);
+    }
+
+    Memory *_memory; // the data memory, which holds the page table
+    size_t _pageBytes;
+    size_t _walkLatency;
+    std::uint32_t _pageTableBase;
+    Port_t _ports[NumPorts];
+
+    // Statistics
+    std::uint64_t _numPagesMapped; // the PTEs the walks have written
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
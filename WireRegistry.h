@@ -0,0 +1,62 @@
+#ifndef __WIRE_REGISTRY_H__
+#define __WIRE_REGISTRY_H__
+
+#include "DigitalCircuit.h"
+#include "SimulatorNamespace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+SIMULATOR_NAMESPACE_BEGIN
+
+class WireRegistry {
+
+  public:
+
+    typedef struct {
+      std::string name; // the hierarchical name, with '.' between the levels
+      size_t width; // the number of bits
+      const void *signal; // the Wire<width> or Register<width> itself
+      std::uint32_t (*read)(const void *signal); // reads the current value
+    } Entry;
+
+    // void WireRegistry::add()
+    //   - registers a wire or a register under the hierarchical 'name'
+    //     (e.g., "latchIDEX.ctrlWB.regWrite"); the value is read through the
+    //     pointer whenever it is needed, so it must outlive the registry
+    template<size_t N>
+    void add(const std::string &name, const Wire<N> *signal) {
+      static_assert(N <= 32, "the registry reads values as 32-bit integers");
+      assert(signal != nullptr);
+      Entry entry = { name, N, signal, &_read<N> };
+      _entries.push_back(entry);
+    }
+
+    size_t size() const {
+      return _entries.size();
+    }
+
+    const Entry &operator[](size_t i) const {
+      return _entries[i];
+    }
+
+    std::uint32_t read(size_t i) const {
+      return _entries[i].read(_entries[i].signal);
+    }
+
+  private:
+
+    template<size_t N>
+    static std::uint32_t _read(const void *signal) {
+      return (std::uint32_t)static_cast<const Wire<N> *>(signal)->to_ulong();
+    }
+
+    std::vector<Entry> _entries;
+
+};
+
+SIMULATOR_NAMESPACE_END
+
+#endif
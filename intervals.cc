@@ -0,0 +1,264 @@
+// intervals.cc
+//   - runs a program on FunctionalCPU and takes an in-memory checkpoint
+//     every N instructions (a little before, with a warm-up)
+//   - simulates every interval on PipelinedCPU from its checkpoint, on a
+//     pool of host threads with a PipelinedCPU each, and adds up the cycles
+//     of the intervals
+//   - unless --no-serial is given, also simulates the whole run on one
+//     PipelinedCPU and reports the error of the sum
+
+#include "FunctionalCPU.h"
+#include "PipelinedCPU.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef ENABLE_HAZARD_DETECTION
+#error "the interval simulation needs the hazard detection, or the detailed results would depend on the timing"
+#endif
+
+// the default number of host threads: one per core, but no more
+// PipelinedCPUs at once than the free host memory holds, were their
+// memories all touched
+static size_t defaultNumThreads() {
+  std::uint64_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  const long numFreePages = sysconf(_SC_AVPHYS_PAGES);
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  if (numFreePages > 0 && pageSize > 0) {
+    const std::uint64_t numFitting = (std::uint64_t)numFreePages * (std::uint64_t)pageSize / (2 * (std::uint64_t)MEMORY_SIZE);
+    numThreads = std::max<std::uint64_t>(1, std::min(numThreads, numFitting));
+  }
+  return (size_t)numThreads;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "[%s] Usage: %s [options] program[@initialPC]\n"
+    "  program is the common prefix of its files (e.g., tests/ex1 for\n"
+    "  tests/ex1_regFile, tests/ex1_instMemFile, and tests/ex1_dataMemFile)\n"
+    "  options:\n"
+    "    --instructions N    the instructions of the whole run (default: 100000)\n"
+    "    --interval N        the instructions per interval (default: 10000)\n"
+    "    --warm-up N         the instructions simulated before each interval (default: 100)\n"
+    "    --threads N         the host threads (default: the cores of the host, as\n"
+    "                        long as the free memory holds as many PipelinedCPUs)\n"
+    "    --endianness E      little or big (default: little)\n"
+    "    --no-serial         do not simulate the whole run on a single thread\n",
+    __func__, name);
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+typedef struct {
+  std::uint64_t firstInstruction; // the index of the first instruction of the interval
+  std::uint64_t numInstructions;
+  std::uint64_t checkpointInstruction; // the index of the instruction the checkpoint was taken before
+  FunctionalCPU::Checkpoint_t checkpoint;
+  std::uint64_t cycles; // the cycles of the interval, from the detailed run
+  std::uint64_t totalCycles; // the cycles of the detailed run, with the warm-up
+} Interval_t;
+
+// the detailed run of an interval: the warm-up instructions fill the pipeline
+// (and whatever else a variant keeps), and the cycles of the interval are
+// counted from the retirement of the last of them; without a warm-up, they
+// are counted from the cycle before the first retirement, except for the
+// first interval, which has the fill of the whole run
+//   - 'cpu' is reset, rather than created anew, as its memories are large
+static void simulate(PipelinedCPU *cpu, Interval_t &interval, const size_t index,
+                     const std::vector<std::pair<std::uint32_t, std::uint32_t>> &instructionWords) {
+  FunctionalCPU::restoreCheckpoint(cpu, interval.checkpoint, instructionWords);
+  const std::uint64_t numWarmUp = interval.firstInstruction - interval.checkpointInstruction;
+  std::uint64_t startCycle = 0;
+  bool started = (index == 0);
+  while (cpu->getNumRetired() < numWarmUp + interval.numInstructions) {
+    cpu->advanceCycle();
+    if (!started && cpu->getNumRetired() >= numWarmUp && cpu->getNumRetired() > 0) {
+      startCycle = cpu->getNumCycles() - (numWarmUp == 0 ? 1 : 0);
+      started = true;
+    }
+  }
+  interval.cycles = cpu->getNumCycles() - startCycle;
+  interval.totalCycles = cpu->getNumCycles();
+}
+
+int main(int argc, char **argv) {
+  std::uint64_t numInstructions = 100000;
+  std::uint64_t intervalLength = 10000;
+  std::uint64_t warmUp = 100;
+  size_t numThreads = defaultNumThreads();
+  Memory::Endianness endianness = Memory::LittleEndian;
+  bool runSerial = true;
+  const char *program = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = (i + 1 < argc);
+    if (strcmp(argv[i], "--instructions") == 0 && hasValue) {
+      numInstructions = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--interval") == 0 && hasValue) {
+      intervalLength = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--warm-up") == 0 && hasValue) {
+      warmUp = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+      numThreads = (size_t)strtoul(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--endianness") == 0 && hasValue) {
+      if (strcmp(argv[i + 1], "little") == 0) {
+        endianness = Memory::LittleEndian;
+      } else if (strcmp(argv[i + 1], "big") == 0) {
+        endianness = Memory::BigEndian;
+      } else {
+        fprintf(stderr, "[%s] ERROR: bad endianness '%s'\n", __func__, argv[i + 1]);
+        return 1;
+      }
+      i++;
+    } else if (strcmp(argv[i], "--no-serial") == 0) {
+      runSerial = false;
+    } else if (argv[i][0] == '-' || program != nullptr) {
+      usage(argv[0]);
+      return 1;
+    } else {
+      program = argv[i];
+    }
+  }
+  if (program == nullptr || numInstructions == 0 || intervalLength == 0 || numThreads == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::string prefix = program;
+  std::uint32_t initialPC = 0;
+  size_t at = prefix.find('@');
+  if (at != std::string::npos) {
+    initialPC = (std::uint32_t)strtoul(prefix.c_str() + at + 1, nullptr, 0);
+    prefix = prefix.substr(0, at);
+  }
+  const std::string regFileName = prefix + "_regFile";
+  const std::string instMemFileName = prefix + "_instMemFile";
+  const std::string dataMemFileName = prefix + "_dataMemFile";
+
+  // the report goes to the standard output, without the INFO messages of
+  // the simulators
+  FILE *output = fdopen(dup(fileno(stdout)), "w");
+  if (freopen("/dev/null", "w", stdout) == NULL) {
+    fprintf(stderr, "[%s] ERROR: cannot silence the standard output\n", __func__);
+    return 1;
+  }
+
+  // 1) the functional run: the checkpoint of interval i is taken 'warmUp'
+  //    instructions before it starts; neither a checkpoint nor a boundary
+  //    falls into the delay slots of a taken branch, so some warm-ups are a
+  //    little shorter and some intervals a little longer
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Interval_t> intervals;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> instructionWords;
+  {
+    FunctionalCPU cpu("FunctionalCPU", initialPC - 4, endianness,
+                      regFileName.c_str(), instMemFileName.c_str(), dataMemFileName.c_str());
+    Interval_t next = {};
+    bool checkpointed = false;
+    while (true) {
+      const std::uint64_t boundary = intervals.size() * intervalLength;
+      const std::uint64_t retired = cpu.getNumRetired();
+      if (!cpu.isBranchPending()) {
+        if (!checkpointed && retired + warmUp >= boundary) {
+          cpu.takeCheckpoint(next.checkpoint);
+          next.checkpointInstruction = retired;
+          checkpointed = true;
+        }
+        if (checkpointed && retired >= boundary) {
+          next.firstInstruction = retired;
+          if (!intervals.empty()) {
+            intervals.back().numInstructions = retired - intervals.back().firstInstruction;
+          }
+          intervals.push_back(next);
+          checkpointed = false;
+        }
+      }
+      if (retired >= numInstructions) {
+        break;
+      }
+      cpu.advanceCycle();
+    }
+    intervals.back().numInstructions = cpu.getNumRetired() - intervals.back().firstInstruction;
+    if (intervals.size() > 1 && intervals.back().numInstructions == 0) {
+      intervals.pop_back();
+    }
+    instructionWords = cpu.getInstructionWords();
+  }
+  const double functionalSeconds = secondsSince(start);
+
+  // 2) the detailed runs of the intervals, each thread taking the next one
+  //    not taken yet
+  start = std::chrono::steady_clock::now();
+  std::atomic<size_t> nextInterval(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < std::min(numThreads, intervals.size()); t++) {
+    threads.push_back(std::thread([&]() {
+      PipelinedCPU *cpu = new PipelinedCPU("PipelinedCPU", 0, endianness, nullptr, nullptr, nullptr);
+      size_t i;
+      while ((i = nextInterval.fetch_add(1)) < intervals.size()) {
+        simulate(cpu, intervals[i], i, instructionWords);
+      }
+      delete cpu;
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const double parallelSeconds = secondsSince(start);
+
+  std::uint64_t cycles = 0, simulatedCycles = 0, instructions = 0;
+  fprintf(output, "Intervals (%lu intervals of %lu instructions, warm-up %lu, %lu threads):\n",
+          (unsigned long)intervals.size(), (unsigned long)intervalLength, (unsigned long)warmUp,
+          (unsigned long)std::min(numThreads, intervals.size()));
+  fprintf(output, "  %8s %12s %8s %8s %10s %8s\n", "interval", "first", "insts", "warm-up", "cycles", "CPI");
+  for (size_t i = 0; i < intervals.size(); i++) {
+    const Interval_t &interval = intervals[i];
+    fprintf(output, "  %8lu %12lu %8lu %8lu %10lu %8.4f\n", (unsigned long)i,
+            (unsigned long)interval.firstInstruction, (unsigned long)interval.numInstructions,
+            (unsigned long)(interval.firstInstruction - interval.checkpointInstruction),
+            (unsigned long)interval.cycles,
+            interval.numInstructions == 0 ? 0.0 : (double)interval.cycles / (double)interval.numInstructions);
+    cycles += interval.cycles;
+    simulatedCycles += interval.totalCycles;
+    instructions += interval.numInstructions;
+  }
+  fprintf(output, "Parallel: %lu cycles (CPI %.4f, %lu cycles simulated, functional %.3f s, detailed %.3f s)\n",
+          (unsigned long)cycles, (double)cycles / (double)instructions, (unsigned long)simulatedCycles,
+          functionalSeconds, parallelSeconds);
+  fflush(output);
+
+  // 3) the reference: the whole run in detail, on a single thread
+  if (runSerial) {
+    start = std::chrono::steady_clock::now();
+    PipelinedCPU *cpu = new PipelinedCPU(
+      "PipelinedCPU", initialPC - 4, endianness,
+      regFileName.c_str(), instMemFileName.c_str(), dataMemFileName.c_str());
+    while (cpu->getNumRetired() < instructions) {
+      cpu->advanceCycle();
+    }
+    const std::uint64_t serialCycles = cpu->getNumCycles();
+    delete cpu;
+    const double serialSeconds = secondsSince(start);
+    fprintf(output, "Serial: %lu cycles (CPI %.4f, %.3f s)\n", (unsigned long)serialCycles,
+            (double)serialCycles / (double)instructions, serialSeconds);
+    fprintf(output, "Error: %+.2f%% (speedup %.1fx, %.1fx with the functional run)\n",
+            100.0 * ((double)cycles - (double)serialCycles) / (double)serialCycles,
+            parallelSeconds > 0.0 ? serialSeconds / parallelSeconds : 0.0,
+            serialSeconds / (functionalSeconds + parallelSeconds));
+  }
+
+  fclose(output);
+  return 0;
+}
@@ -0,0 +1,50 @@
+// pipeview.cc
+//   - draws the pipeline diagram of a window of cycles from the file that
+//     PipelinedCPU::openPipeView() writes (see PipeView.h)
+
+#include "PipeView.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char **argv) {
+  if (argc != 2 && argc != 4) {
+    fprintf(stderr, "[%s] Usage: %s pipeViewFileName [startCycle endCycle]\n", __func__, argv[0]);
+    return 1;
+  }
+  const std::uint64_t startCycle = (argc == 4) ? strtoull(argv[2], nullptr, 10) : 1;
+  const std::uint64_t endCycle = (argc == 4) ? strtoull(argv[3], nullptr, 10) : PIPEVIEW_WINDOW_CYCLES;
+  if (startCycle == 0 || startCycle > endCycle) {
+    fprintf(stderr, "[%s] ERROR: bad window [%s, %s]\n", __func__, argv[2], argv[3]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "r");
+  if (file == NULL) {
+    fprintf(stderr, "[%s] ERROR: cannot open '%s'\n", __func__, argv[1]);
+    return 1;
+  }
+  char line[512];
+  size_t numIFStages = 0, numMEMStages = 0;
+  if (fgets(line, sizeof(line), file) == NULL || !PipeView::parseHeader(line, numIFStages, numMEMStages)) {
+    fprintf(stderr, "[%s] ERROR: '%s' is not a pipeline view\n", __func__, argv[1]);
+    fclose(file);
+    return 1;
+  }
+  // only the records in the window are kept, as the file has one per
+  // instruction of the whole run
+  std::vector<PipeView::Record_t> records;
+  PipeView::Record_t record;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (PipeView::parse(line, record) && PipeView::isInWindow(record, startCycle, endCycle)) {
+      records.push_back(record);
+    }
+  }
+  fclose(file);
+
+  printf("Pipeline Diagram (cycles %lu to %lu):\n", (unsigned long)startCycle, (unsigned long)endCycle);
+  PipeView::render(stdout, records, startCycle, endCycle, numIFStages, numMEMStages);
+  return 0;
+}
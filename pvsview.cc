@@ -0,0 +1,72 @@
+// pvsview.cc
+//   - prints the PVS of a cycle, or of a range of cycles, from the archive
+//     that PipelinedCPU::openPVSArchive() writes (see PVSArchive.h), exactly
+//     as printPVS() would have printed it; without a cycle, it prints what
+//     the archive holds
+
+#include "PVSArchive.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "[%s] Usage: %s pvsArchiveFileName [startCycle [endCycle]]\n", __func__, argv[0]);
+    return 1;
+  }
+  PVSArchiveReader archive;
+  if (!archive.open(argv[1])) {
+    return 1;
+  }
+  const std::vector<PVSArchive::IndexEntry_t> &index = archive.getIndex();
+
+  if (argc == 2) {
+    std::uint64_t numRecords = 0, numCompressedBytes = 0, numRawBytes = 0;
+    for (const PVSArchive::IndexEntry_t &entry : index) {
+      numRecords += entry.numRecords;
+      numCompressedBytes += entry.compressedSize;
+      numRawBytes += entry.rawSize;
+    }
+    printf("PVS Archive (keyframe every %lu records):\n", (unsigned long)archive.getKeyframeInterval());
+    printf("  chunks             = %lu\n", (unsigned long)index.size());
+    printf("  records            = %lu\n", (unsigned long)numRecords);
+    printf("  firstCycle         = %lu\n", index.empty() ? 0UL : (unsigned long)index.front().firstCycle);
+    printf("  lastCycle          = %lu\n", index.empty() ? 0UL : (unsigned long)index.back().lastCycle);
+    printf("  chunkBytes         = %lu (%lu uncompressed)\n", (unsigned long)numCompressedBytes,
+           (unsigned long)numRawBytes);
+    return 0;
+  }
+
+  const std::uint64_t startCycle = strtoull(argv[2], nullptr, 10);
+  const std::uint64_t endCycle = (argc == 4) ? strtoull(argv[3], nullptr, 10) : startCycle;
+  if (startCycle > endCycle) {
+    fprintf(stderr, "[%s] ERROR: bad range [%s, %s]\n", __func__, argv[2], argv[3]);
+    return 1;
+  }
+  // the cycles the archive has no record of (e.g., past the end of the
+  // run) are skipped
+  OutputRecord record;
+  std::string text;
+  std::uint64_t numPrinted = 0;
+  for (std::uint64_t cycle = startCycle; cycle <= endCycle; cycle++) {
+    if (!archive.read(cycle, record)) {
+      if (index.empty() || cycle > index.back().lastCycle) {
+        break;
+      }
+      continue;
+    }
+    OutputRecordReader reader(record.data());
+    text.clear();
+    archive.getLayout().format(reader, text);
+    fwrite(text.data(), 1, text.size(), stdout);
+    numPrinted += 1;
+  }
+  if (numPrinted == 0) {
+    fprintf(stderr, "[%s] ERROR: '%s' has no record of cycles %lu to %lu\n", __func__, argv[1],
+            (unsigned long)startCycle, (unsigned long)endCycle);
+    return 1;
+  }
+  return 0;
+}
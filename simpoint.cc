@@ -0,0 +1,212 @@
+// simpoint.cc
+//   - runs a program on FunctionalCPU, collects a basic block vector per
+//     interval of instructions, and picks the representative intervals
+//   - simulates only those intervals on one PipelinedCPU, reset to the
+//     in-memory checkpoints FunctionalCPU takes at their starts, and
+//     extrapolates the cycles of the whole run
+//   - unless --no-full is given, also simulates the whole run on
+//     PipelinedCPU and reports the error of the extrapolation
+
+#include "FunctionalCPU.h"
+#include "SimPoint.h"
+#include "PipelinedCPU.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef ENABLE_HAZARD_DETECTION
+#error "SimPoint needs the hazard detection, or the detailed results would depend on the timing"
+#endif
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "[%s] Usage: %s [options] program[@initialPC]\n"
+    "  program is the common prefix of its files (e.g., tests/ex1 for\n"
+    "  tests/ex1_regFile, tests/ex1_instMemFile, and tests/ex1_dataMemFile)\n"
+    "  options:\n"
+    "    --instructions N    the instructions of the whole run (default: 100000)\n"
+    "    --interval N        the instructions per interval (default: 1000)\n"
+    "    --max-k N           the largest number of clusters tried (default: 10)\n"
+    "    --seed N            the seed of the projection and of k-means (default: 1)\n"
+    "    --endianness E      little or big (default: little)\n"
+    "    --no-full           do not simulate the whole run in detail\n",
+    __func__, name);
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  std::uint64_t numInstructions = 100000;
+  std::uint64_t intervalLength = 1000;
+  size_t maxK = 10;
+  std::uint64_t seed = 1;
+  Memory::Endianness endianness = Memory::LittleEndian;
+  bool runFull = true;
+  const char *program = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = (i + 1 < argc);
+    if (strcmp(argv[i], "--instructions") == 0 && hasValue) {
+      numInstructions = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--interval") == 0 && hasValue) {
+      intervalLength = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--max-k") == 0 && hasValue) {
+      maxK = (size_t)strtoul(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+      seed = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--endianness") == 0 && hasValue) {
+      if (strcmp(argv[i + 1], "little") == 0) {
+        endianness = Memory::LittleEndian;
+      } else if (strcmp(argv[i + 1], "big") == 0) {
+        endianness = Memory::BigEndian;
+      } else {
+        fprintf(stderr, "[%s] ERROR: bad endianness '%s'\n", __func__, argv[i + 1]);
+        return 1;
+      }
+      i++;
+    } else if (strcmp(argv[i], "--no-full") == 0) {
+      runFull = false;
+    } else if (argv[i][0] == '-' || program != nullptr) {
+      usage(argv[0]);
+      return 1;
+    } else {
+      program = argv[i];
+    }
+  }
+  if (program == nullptr || numInstructions == 0 || intervalLength == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::string prefix = program;
+  std::uint32_t initialPC = 0;
+  size_t at = prefix.find('@');
+  if (at != std::string::npos) {
+    initialPC = (std::uint32_t)strtoul(prefix.c_str() + at + 1, nullptr, 0);
+    prefix = prefix.substr(0, at);
+  }
+  const std::string regFileName = prefix + "_regFile";
+  const std::string instMemFileName = prefix + "_instMemFile";
+  const std::string dataMemFileName = prefix + "_dataMemFile";
+
+  // the report goes to the standard output, without the INFO messages of
+  // the simulators
+  FILE *output = fdopen(dup(fileno(stdout)), "w");
+  if (freopen("/dev/null", "w", stdout) == NULL) {
+    fprintf(stderr, "[%s] ERROR: cannot silence the standard output\n", __func__);
+    return 1;
+  }
+
+  // 1) the functional run: one BBV per interval; a boundary never falls into
+  //    the delay slots of a taken branch, so some intervals are a little longer
+  auto start = std::chrono::steady_clock::now();
+  SimPoint simPoint(seed);
+  FunctionalCPU::Checkpoint_t initialState;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> instructionWords;
+  {
+    FunctionalCPU cpu("FunctionalCPU", initialPC - 4, endianness,
+                      regFileName.c_str(), instMemFileName.c_str(), dataMemFileName.c_str());
+    cpu.takeCheckpoint(initialState);
+    instructionWords = cpu.getInstructionWords();
+    std::uint64_t inInterval = 0;
+    while (cpu.getNumRetired() < numInstructions) {
+      simPoint.retire(cpu.getPC());
+      cpu.advanceCycle();
+      inInterval += 1;
+      if (inInterval >= intervalLength && !cpu.isBranchPending()) {
+        simPoint.endInterval();
+        inInterval = 0;
+      }
+    }
+    simPoint.endInterval();
+  }
+  const double profileSeconds = secondsSince(start);
+
+  std::vector<SimPoint::Representative> representatives = simPoint.cluster(maxK);
+  fprintf(output, "SimPoints (%lu instructions, %lu intervals, k = %lu, %.3f s):\n",
+          (unsigned long)simPoint.getNumInstructions(), (unsigned long)simPoint.getNumIntervals(),
+          (unsigned long)simPoint.getChosenK(), profileSeconds);
+  fprintf(output, "  %8s %12s %8s %10s %8s %10s\n", "interval", "first", "insts", "pc", "weight", "intervals");
+  for (const SimPoint::Representative &r : representatives) {
+    fprintf(output, "  %8lu %12lu %8lu 0x%08lx %8.4f %10lu\n", (unsigned long)r.interval,
+            (unsigned long)r.firstInstruction, (unsigned long)r.numInstructions,
+            (unsigned long)r.pc, r.weight, (unsigned long)r.clusterIntervals);
+  }
+  fflush(output);
+
+  // 2) the checkpoints at the start of the representative intervals, kept
+  //    in memory
+  std::vector<FunctionalCPU::Checkpoint_t> checkpoints(representatives.size());
+  {
+    FunctionalCPU cpu("FunctionalCPU", initialPC - 4, endianness,
+                      regFileName.c_str(), instMemFileName.c_str(), dataMemFileName.c_str());
+    for (size_t i = 0; i < representatives.size(); i++) {
+      while (cpu.getNumRetired() < representatives[i].firstInstruction) {
+        cpu.advanceCycle();
+      }
+      assert(cpu.getPC() == representatives[i].pc);
+      cpu.takeCheckpoint(checkpoints[i]);
+    }
+  }
+
+  // 3) the detailed runs of the representative intervals, on one
+  //    PipelinedCPU reset to each checkpoint in turn; the pipeline starts
+  //    empty, so the cycles are counted from the first retirement
+  start = std::chrono::steady_clock::now();
+  PipelinedCPU *cpu = new PipelinedCPU("PipelinedCPU", 0, endianness, nullptr, nullptr, nullptr);
+  double weightedCPI = 0.0;
+  std::uint64_t fillCycles = 0;
+  fprintf(output, "Detailed Intervals:\n");
+  fprintf(output, "  %8s %10s %8s\n", "interval", "cycles", "CPI");
+  for (size_t i = 0; i < representatives.size(); i++) {
+    const SimPoint::Representative &r = representatives[i];
+    FunctionalCPU::restoreCheckpoint(cpu, checkpoints[i], instructionWords);
+    std::uint64_t firstRetireCycle = 0;
+    while (cpu->getNumRetired() < r.numInstructions) {
+      cpu->advanceCycle();
+      if (firstRetireCycle == 0 && cpu->getNumRetired() > 0) {
+        firstRetireCycle = cpu->getNumCycles();
+      }
+    }
+    const std::uint64_t cycles = cpu->getNumCycles() - firstRetireCycle + 1;
+    const double cpi = (double)cycles / (double)r.numInstructions;
+    fillCycles = firstRetireCycle - 1;
+    weightedCPI += r.weight * cpi;
+    fprintf(output, "  %8lu %10lu %8.4f\n", (unsigned long)r.interval, (unsigned long)cycles, cpi);
+    fflush(output);
+  }
+  const double sampledSeconds = secondsSince(start);
+  const double estimatedCycles = (double)fillCycles + weightedCPI * (double)simPoint.getNumInstructions();
+  fprintf(output, "Estimated: %.0f cycles (CPI %.4f, %.3f s)\n", estimatedCycles, weightedCPI, sampledSeconds);
+
+  // 4) the reference: the whole run in detail, from the initial state
+  if (runFull) {
+    start = std::chrono::steady_clock::now();
+    FunctionalCPU::restoreCheckpoint(cpu, initialState, instructionWords);
+    while (cpu->getNumRetired() < simPoint.getNumInstructions()) {
+      cpu->advanceCycle();
+    }
+    const std::uint64_t cycles = cpu->getNumCycles();
+    const double fullSeconds = secondsSince(start);
+    fprintf(output, "Full: %lu cycles (CPI %.4f, %.3f s)\n", (unsigned long)cycles,
+            (double)cycles / (double)simPoint.getNumInstructions(), fullSeconds);
+    fprintf(output, "Error: %+.2f%% (speedup %.1fx)\n",
+            100.0 * (estimatedCycles - (double)cycles) / (double)cycles,
+            sampledSeconds > 0.0 ? fullSeconds / sampledSeconds : 0.0);
+  }
+
+  delete cpu;
+  fclose(output);
+  return 0;
+}
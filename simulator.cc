@@ -0,0 +1,149 @@
+// simulator.cc
+//   - libsimulator.a: the Simulator of Simulator.h on top of a PipelinedCPU
+//   - the simulator is declared in the namespace SimulatorCore (see
+//     SimulatorNamespace.h), so that a program linked with the library can
+//     still build its own PipelinedCPU with other compile-time options
+
+#include "Simulator.h"
+
+#define SIMULATOR_NAMESPACE SimulatorCore
+#include "PipelinedCPU.h"
+
+struct Simulator::Core {
+  SimulatorCore::PipelinedCPU cpu;
+
+  // the PipelinedCPU takes the address before the first instruction
+  Core(uint32_t initialPC, bool bigEndian)
+    : cpu("PipelinedCPU", initialPC - 4,
+          bigEndian ? SimulatorCore::Memory::BigEndian : SimulatorCore::Memory::LittleEndian,
+          nullptr, nullptr, nullptr) {
+  }
+};
+
+Simulator::Simulator(uint32_t initialPC, bool bigEndian) {
+  _core = new Core(initialPC, bigEndian);
+}
+
+Simulator::~Simulator() {
+  delete _core;
+}
+
+void Simulator::reset(uint32_t initialPC) {
+  _core->cpu.reset(initialPC - 4);
+}
+
+void Simulator::loadInstructions(uint32_t address, const uint32_t *words, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    _core->cpu.writeInstMemory(address + 4 * i, words[i]);
+  }
+}
+
+void Simulator::loadData(uint32_t address, const uint32_t *words, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    _core->cpu.writeDataMemory(address + 4 * i, words[i]);
+  }
+}
+
+void Simulator::setRegister(unsigned i, uint32_t value) {
+  _core->cpu.setRegister(i, value);
+}
+
+uint32_t Simulator::getRegister(unsigned i) const {
+  return _core->cpu.getRegister(i);
+}
+
+uint32_t Simulator::readMemory(uint32_t address) const {
+  return _core->cpu.readDataMemory(address);
+}
+
+void Simulator::step(uint64_t cycles) {
+  for (uint64_t i = 0; i < cycles; i++) {
+    _core->cpu.advanceCycle();
+  }
+}
+
+uint64_t Simulator::run(uint64_t maxCycles) {
+  uint64_t cycles = 0;
+  while (cycles < maxCycles && !_core->cpu.isHalted()) {
+    _core->cpu.advanceCycle();
+    cycles += 1;
+  }
+  return cycles;
+}
+
+bool Simulator::isHalted() const {
+  return _core->cpu.isHalted();
+}
+
+uint64_t Simulator::getNumCycles() const {
+  return _core->cpu.getNumCycles();
+}
+
+uint64_t Simulator::getNumRetired() const {
+  return _core->cpu.getNumRetired();
+}
+
+void Simulator::printState() {
+  _core->cpu.printPVS();
+  fflush(stdout);
+}
+
+extern "C" {
+
+Simulator *simulator_create(uint32_t initialPC, int bigEndian) {
+  return new Simulator(initialPC, bigEndian != 0);
+}
+
+void simulator_destroy(Simulator *simulator) {
+  delete simulator;
+}
+
+void simulator_reset(Simulator *simulator, uint32_t initialPC) {
+  simulator->reset(initialPC);
+}
+
+void simulator_load_instructions(Simulator *simulator, uint32_t address, const uint32_t *words, size_t count) {
+  simulator->loadInstructions(address, words, count);
+}
+
+void simulator_load_data(Simulator *simulator, uint32_t address, const uint32_t *words, size_t count) {
+  simulator->loadData(address, words, count);
+}
+
+void simulator_set_register(Simulator *simulator, unsigned i, uint32_t value) {
+  simulator->setRegister(i, value);
+}
+
+uint32_t simulator_get_register(const Simulator *simulator, unsigned i) {
+  return simulator->getRegister(i);
+}
+
+uint32_t simulator_read_memory(const Simulator *simulator, uint32_t address) {
+  return simulator->readMemory(address);
+}
+
+void simulator_step(Simulator *simulator, uint64_t cycles) {
+  simulator->step(cycles);
+}
+
+uint64_t simulator_run(Simulator *simulator, uint64_t maxCycles) {
+  return simulator->run(maxCycles);
+}
+
+int simulator_is_halted(const Simulator *simulator) {
+  return simulator->isHalted() ? 1 : 0;
+}
+
+uint64_t simulator_get_num_cycles(const Simulator *simulator) {
+  return simulator->getNumCycles();
+}
+
+uint64_t simulator_get_num_retired(const Simulator *simulator) {
+  return simulator->getNumRetired();
+}
+
+void simulator_print_state(Simulator *simulator) {
+  simulator->printState();
+}
+
+} // extern "C"
@@ -0,0 +1,292 @@
+// sweep.cc
+//   - runs every combination of the configurations and programs given on
+//     the command line, one PipelinedCPU per job, on a pool of host threads,
+//     and writes one CSV row per run
+
+#include "SweepVariant.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef SWEEP_RUN_BYTES
+#define SWEEP_RUN_BYTES (64ULL << 20) // <-- the most host memory a run takes: its instruction and data memories, if the program touches all of them
+#endif
+
+static std::vector<std::string> split(const std::string &list, char separator) {
+  std::vector<std::string> items;
+  size_t begin = 0, end;
+  while ((end = list.find(separator, begin)) != std::string::npos) {
+    items.push_back(list.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  items.push_back(list.substr(begin));
+  return items;
+}
+
+static std::vector<unsigned> parseValues(const char *option, const char *list) {
+  std::vector<unsigned> values;
+  for (const std::string &item : split(list, ',')) {
+    char *end;
+    unsigned long value = strtoul(item.c_str(), &end, 0);
+    if (item.empty() || *end != '\0') {
+      fprintf(stderr, "[%s] ERROR: bad value '%s' for %s\n", __func__, item.c_str(), option);
+      exit(1);
+    }
+    values.push_back((unsigned)value);
+  }
+  return values;
+}
+
+// the default number of host threads: one per core, but no more runs at
+// once than the free host memory holds
+static unsigned defaultNumThreads() {
+  std::uint64_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  const long numFreePages = sysconf(_SC_AVPHYS_PAGES);
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  if (numFreePages > 0 && pageSize > 0) {
+    const std::uint64_t numFitting = (std::uint64_t)numFreePages * (std::uint64_t)pageSize / SWEEP_RUN_BYTES;
+    numThreads = std::max<std::uint64_t>(1, std::min(numThreads, numFitting));
+  }
+  return (unsigned)numThreads;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "[%s] Usage: %s [options] program[@initialPC]...\n"
+    "  program is the common prefix of its files (e.g., tests/ex1 for\n"
+    "  tests/ex1_regFile, tests/ex1_instMemFile, and tests/ex1_dataMemFile)\n"
+    "  options (the lists are comma-separated):\n"
+    "    --forwarding LIST   data forwarding off/on (default: 0,1)\n"
+    "    --hazard LIST       hazard detection off/on (default: 0,1; needs forwarding)\n"
+    "    --if-stages LIST    the IF stages the instruction memory is spread over,\n"
+    "                        which shortens the cycle but lengthens the branch\n"
+    "                        delay (default: 1; 1 or 2)\n"
+    "    --mem-stages LIST   the MEM stages, i.e., the data memory latency (default: 1)\n"
+    "    --endianness LIST   little and/or big (default: little)\n"
+    "    --jump-prediction LIST    the return-address stack and the indirect\n"
+    "                        target cache off/on (default: 0; needs hazard detection)\n"
+    "    --ras-depth LIST    the RAS entries, with jump prediction (default: 8)\n"
+    "    --itc-entries LIST  the ITC entries, with jump prediction (default: 16)\n"
+    "    --prefetcher LIST   a data memory of 8-cycle latency behind the stride\n"
+    "                        prefetcher off/on (default: 0; needs hazard detection)\n"
+    "    --prefetch-degree LIST    the prefetches per load, with the prefetcher\n"
+    "                        (default: 2; 0 for the memory latency alone)\n"
+    "    --prefetch-distance LIST  the strides ahead of the first prefetch\n"
+    "                        (default: 4)\n"
+    "    --cycles N          the most cycles to simulate per run; a run stops\n"
+    "                        once its program halts (default: 1000000)\n"
+    "    --threads N         the host threads (default: the number of cores, as\n"
+    "                        long as the free memory holds as many runs)\n"
+    "    --output FILE       the CSV file (default: the standard output)\n",
+    __func__, name);
+}
+
+int main(int argc, char **argv) {
+  std::vector<unsigned> forwardings = { 0, 1 };
+  std::vector<unsigned> hazards = { 0, 1 };
+  std::vector<unsigned> ifStages = { 1 };
+  std::vector<unsigned> memStages = { 1 };
+  std::vector<std::string> endiannesses = { "little" };
+  std::vector<unsigned> jumpPredictions = { 0 };
+  std::vector<unsigned> rasDepths = { 8 };
+  std::vector<unsigned> itcEntries = { 16 };
+  std::vector<unsigned> prefetchers = { 0 };
+  std::vector<unsigned> prefetchDegrees = { 2 };
+  std::vector<unsigned> prefetchDistances = { 4 };
+  std::uint64_t maxCycles = 1000000;
+  unsigned numThreads = defaultNumThreads();
+  const char *outputFileName = nullptr;
+  std::vector<std::string> programs;
+
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = (i + 1 < argc);
+    if (strcmp(argv[i], "--forwarding") == 0 && hasValue) {
+      forwardings = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--hazard") == 0 && hasValue) {
+      hazards = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--if-stages") == 0 && hasValue) {
+      ifStages = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--mem-stages") == 0 && hasValue) {
+      memStages = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--endianness") == 0 && hasValue) {
+      endiannesses = split(argv[i + 1], ','); i++;
+    } else if (strcmp(argv[i], "--jump-prediction") == 0 && hasValue) {
+      jumpPredictions = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--ras-depth") == 0 && hasValue) {
+      rasDepths = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--itc-entries") == 0 && hasValue) {
+      itcEntries = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--prefetcher") == 0 && hasValue) {
+      prefetchers = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--prefetch-degree") == 0 && hasValue) {
+      prefetchDegrees = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--prefetch-distance") == 0 && hasValue) {
+      prefetchDistances = parseValues(argv[i], argv[i + 1]); i++;
+    } else if (strcmp(argv[i], "--cycles") == 0 && hasValue) {
+      maxCycles = strtoull(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+      numThreads = (unsigned)strtoul(argv[i + 1], nullptr, 0); i++;
+    } else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+      outputFileName = argv[i + 1]; i++;
+    } else if (argv[i][0] == '-') {
+      usage(argv[0]);
+      return 1;
+    } else {
+      programs.push_back(argv[i]);
+    }
+  }
+  if (programs.empty()) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (numThreads == 0) {
+    numThreads = 1;
+  }
+  for (const std::string &endianness : endiannesses) {
+    if (endianness != "little" && endianness != "big") {
+      fprintf(stderr, "[%s] ERROR: bad endianness '%s'\n", __func__, endianness.c_str());
+      return 1;
+    }
+  }
+  if (std::find(rasDepths.begin(), rasDepths.end(), 0u) != rasDepths.end()
+      || std::find(itcEntries.begin(), itcEntries.end(), 0u) != itcEntries.end()
+      || std::find(prefetchDistances.begin(), prefetchDistances.end(), 0u) != prefetchDistances.end()) {
+    fprintf(stderr, "[%s] ERROR: the RAS depth, the ITC entries, and the prefetch distance must be positive\n", __func__);
+    return 1;
+  }
+
+  FILE *output = stdout;
+  if (outputFileName != nullptr) {
+    output = fopen(outputFileName, "w");
+    if (output == NULL) {
+      fprintf(stderr, "[%s] ERROR: cannot open %s\n", __func__, outputFileName);
+      return 1;
+    }
+  } else {
+    // the simulator's own messages would be mixed into the CSV
+    output = fdopen(dup(fileno(stdout)), "w");
+  }
+  // the INFO messages of the simulators are not wanted
+  if (freopen("/dev/null", "w", stdout) == NULL) {
+    fprintf(stderr, "[%s] ERROR: cannot silence the standard output\n", __func__);
+    return 1;
+  }
+
+  typedef struct {
+    const SweepVariant *variant;
+    SweepJob job;
+    SweepResult result;
+  } Run;
+  std::vector<Run> runs;
+
+  // the configurations, each with its compiled-in variant
+  std::vector<const SweepVariant *> variants;
+  for (unsigned forwarding : forwardings) {
+    for (unsigned hazard : hazards) {
+      for (unsigned fetchStages : ifStages) {
+        for (unsigned stages : memStages) {
+          for (unsigned jumpPrediction : jumpPredictions) {
+            for (unsigned prefetcher : prefetchers) {
+              const SweepVariant *variant = nullptr;
+              for (const SweepVariant &v : sweepVariants()) {
+                if (v.dataForwarding == (forwarding != 0) && v.hazardDetection == (hazard != 0)
+                    && v.ifStages == fetchStages && v.memStages == stages
+                    && v.jumpPrediction == (jumpPrediction != 0) && v.prefetcher == (prefetcher != 0)) {
+                  variant = &v;
+                }
+              }
+              if (variant == nullptr) {
+                fprintf(stderr, "[%s] WARNING: no variant with forwarding=%u, hazard=%u, ifStages=%u, memStages=%u, jumpPrediction=%u, prefetcher=%u; skipped\n",
+                        __func__, forwarding, hazard, fetchStages, stages, jumpPrediction, prefetcher);
+                continue;
+              }
+              variants.push_back(variant);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // the grid: every configuration, times the settings of its jump predictor
+  // and prefetcher (those of a component it does not have make no
+  // difference, so they are not swept), times every program
+  const std::vector<unsigned> noSetting = { 0 };
+  for (const SweepVariant *variant : variants) {
+    for (unsigned rasDepth : variant->jumpPrediction ? rasDepths : noSetting) {
+      for (unsigned itc : variant->jumpPrediction ? itcEntries : noSetting) {
+        for (unsigned degree : variant->prefetcher ? prefetchDegrees : noSetting) {
+          for (unsigned distance : variant->prefetcher ? prefetchDistances : noSetting) {
+            for (const std::string &endianness : endiannesses) {
+              for (const std::string &program : programs) {
+                std::vector<std::string> parts = split(program, '@');
+                Run run;
+                run.variant = variant;
+                run.job.program = parts[0];
+                run.job.initialPC = (parts.size() > 1) ? (std::uint32_t)strtoul(parts[1].c_str(), nullptr, 0) : 0;
+                run.job.bigEndian = (endianness == "big");
+                run.job.maxCycles = maxCycles;
+                run.job.rasDepth = rasDepth;
+                run.job.itcEntries = itc;
+                run.job.prefetchDegree = degree;
+                run.job.prefetchDistance = distance;
+                runs.push_back(run);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  fprintf(output, "program,initialPC,forwarding,hazardDetection,ifStages,memStages,jumpPrediction,rasDepth,itcEntries,"
+                  "prefetcher,prefetchDegree,prefetchDistance,endianness,halted,cycles,retired,CPI,cycleTimeNs,estimatedNs,hostSeconds\n");
+  std::mutex outputMutex;
+  std::atomic<size_t> next(0);
+  size_t numDone = 0;
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next.fetch_add(1)) < runs.size()) {
+      Run &run = runs[i];
+      run.result = run.variant->run(run.job);
+      std::lock_guard<std::mutex> lock(outputMutex);
+      fprintf(output, "%s,%lu,%d,%d,%u,%u,%d,%u,%u,%d,%u,%u,%s,%d,%lu,%lu,%.4f,%.3f,%.1f,%.6f\n", run.job.program.c_str(),
+              (unsigned long)run.job.initialPC, (int)run.variant->dataForwarding,
+              (int)run.variant->hazardDetection, run.variant->ifStages, run.variant->memStages,
+              (int)run.variant->jumpPrediction, run.job.rasDepth, run.job.itcEntries,
+              (int)run.variant->prefetcher, run.job.prefetchDegree, run.job.prefetchDistance,
+              run.job.bigEndian ? "big" : "little", (int)run.result.halted, (unsigned long)run.result.cycles,
+              (unsigned long)run.result.retired,
+              run.result.retired == 0 ? 0.0 : (double)run.result.cycles / (double)run.result.retired,
+              run.result.cycleTimeNs, (double)run.result.cycles * run.result.cycleTimeNs,
+              run.result.hostSeconds);
+      fflush(output);
+      if (!run.result.halted) {
+        fprintf(stderr, "[sweep] WARNING: %s did not halt within %lu cycles; its CPI is that of the cycles run\n",
+                run.job.program.c_str(), (unsigned long)run.job.maxCycles);
+      }
+      numDone += 1;
+      fprintf(stderr, "[sweep] %lu/%lu runs done\n", (unsigned long)numDone, (unsigned long)runs.size());
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads && t < runs.size(); t++) {
+    threads.push_back(std::thread(worker));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  fclose(output);
+  return 0;
+}
@@ -0,0 +1,92 @@
+// sweepVariant.cc
+//   - compiled once per variant of the sweep, e.g.,
+//       g++ -c -DSWEEP_VARIANT=V3M2 -DENABLE_DATA_FORWARDING
+//           -DENABLE_HAZARD_DETECTION -DENABLE_JUMPS -DPIPELINE_MEM_STAGES=2
+//           sweepVariant.cc
+//   - the simulator is declared in the namespace SWEEP_VARIANT (see
+//     SimulatorNamespace.h), so the variants do not clash when they are
+//     linked together
+
+#ifndef SWEEP_VARIANT
+#error "SWEEP_VARIANT must name the variant (e.g., -DSWEEP_VARIANT=V3M1)"
+#endif
+
+#ifndef ENABLE_JUMPS
+#error "every variant of the sweep executes the jumps, so that a program runs the same with and without the jump prediction"
+#endif
+
+#include "SweepVariant.h"
+
+#define SIMULATOR_NAMESPACE SWEEP_VARIANT
+#include "PipelinedCPU.h"
+
+#include <chrono>
+#include <string>
+
+namespace SWEEP_VARIANT {
+
+static SweepResult run(const SweepJob &job) {
+  const auto start = std::chrono::steady_clock::now();
+
+  const std::string regFileName = job.program + "_regFile";
+  const std::string instMemFileName = job.program + "_instMemFile";
+  const std::string dataMemFileName = job.program + "_dataMemFile";
+  PipelinedCPU *cpu = new PipelinedCPU(
+    "PipelinedCPU",
+    job.initialPC - 4,
+    job.bigEndian ? Memory::BigEndian : Memory::LittleEndian,
+    regFileName.c_str(), instMemFileName.c_str(), dataMemFileName.c_str());
+#ifdef ENABLE_JUMP_PREDICTION
+  cpu->resizeJumpPredictor(job.rasDepth, job.itcEntries);
+#endif
+#ifdef ENABLE_PREFETCHER
+  cpu->configurePrefetcher(job.prefetchDegree, job.prefetchDistance);
+#endif
+  // past the end of its code, a program would fetch and retire the
+  // unwritten words as nops, so the run stops once the CPU halts
+  while (cpu->getNumCycles() < job.maxCycles && !cpu->isHalted()) {
+    cpu->advanceCycle();
+  }
+
+  SweepResult result;
+  result.halted = cpu->isHalted();
+  result.cycles = cpu->getNumCycles();
+  result.retired = cpu->getNumRetired();
+#ifdef ENABLE_TIMING_MODEL
+  result.cycleTimeNs = cpu->getMinCycleTimeNs();
+#else
+  result.cycleTimeNs = 0.0;
+#endif
+  delete cpu;
+
+  const auto end = std::chrono::steady_clock::now();
+  result.hostSeconds = std::chrono::duration<double>(end - start).count();
+  return result;
+}
+
+#ifdef ENABLE_DATA_FORWARDING
+#define SWEEP_DATA_FORWARDING true
+#else
+#define SWEEP_DATA_FORWARDING false
+#endif
+#ifdef ENABLE_HAZARD_DETECTION
+#define SWEEP_HAZARD_DETECTION true
+#else
+#define SWEEP_HAZARD_DETECTION false
+#endif
+#ifdef ENABLE_JUMP_PREDICTION
+#define SWEEP_JUMP_PREDICTION true
+#else
+#define SWEEP_JUMP_PREDICTION false
+#endif
+#ifdef ENABLE_PREFETCHER
+#define SWEEP_PREFETCHER true
+#else
+#define SWEEP_PREFETCHER false
+#endif
+
+static SweepVariantRegistrar registrar({
+  SWEEP_DATA_FORWARDING, SWEEP_HAZARD_DETECTION, PIPELINE_IF_STAGES, PIPELINE_MEM_STAGES,
+  SWEEP_JUMP_PREDICTION, SWEEP_PREFETCHER, &run });
+
+} // namespace SWEEP_VARIANT
@@ -1,10 +1,62 @@
+#ifdef ENABLE_OUT_OF_ORDER
+#include "OutOfOrderCPU.h"
+#else
 #include "PipelinedCPU.h"
+#endif
+
+#include <cstring>
+
+#if defined(ENABLE_VCD_DUMP) && defined(ENABLE_STATE_DIGEST)
+#error "the VCD dump and the state digest cannot be enabled together"
+#endif
+
+#if defined(ENABLE_PIPEVIEW) && (defined(ENABLE_VCD_DUMP) || defined(ENABLE_STATE_DIGEST))
+#error "the pipeline view takes the place of the VCD dump and the state digest on the command line"
+#endif
+
+#if defined(ENABLE_PVS_ARCHIVE) && (defined(ENABLE_VCD_DUMP) || defined(ENABLE_STATE_DIGEST) || defined(ENABLE_PIPEVIEW))
+#error "the PVS archive takes the place of the VCD dump, the state digest, and the pipeline view on the command line"
+#endif
 
 int main(int argc, char **argv) {
+#ifdef ENABLE_VCD_DUMP
+  if (argc != 7 && argc != 9) {
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName instMemFileName dataMemFileName numCycles vcdFileName [startCycle endCycle]\n", __func__, argv[0]);
+    fflush(stdout);
+    return 1;
+  }
+#elif defined(ENABLE_PIPEVIEW)
+  if (argc != 7 && argc != 9) {
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName instMemFileName dataMemFileName numCycles pipeViewFileName [startCycle endCycle]\n", __func__, argv[0]);
+    fflush(stdout);
+    return 1;
+  }
+#elif defined(ENABLE_PVS_ARCHIVE)
+  if (argc != 7) {
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName instMemFileName dataMemFileName numCycles pvsArchiveFileName\n", __func__, argv[0]);
+    fflush(stdout);
+    return 1;
+  }
+#elif defined(ENABLE_STATE_DIGEST)
+  if ((argc != 8 && argc != 9)
+      || (strcmp(argv[6], "record") != 0 && strcmp(argv[6], "check") != 0)) {
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName instMemFileName dataMemFileName numCycles record|check digestFileName [period]\n", __func__, argv[0]);
+    fflush(stdout);
+    return 1;
+  }
+#else
   if (argc != 6) {
+#ifdef ENABLE_TRACE_DRIVEN
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName traceFileName dataMemFileName numCycles\n", __func__, argv[0]);
+#elif defined(ENABLE_MULTITHREADING)
+    // a comma-separated list of files, one per thread, or one file for all of them
+    fprintf(stderr, "[%s] Usage: %s initialPC regFileName[,...] instMemFileName[,...] dataMemFileName[,...] numCycles\n", __func__, argv[0]);
+#else
     fprintf(stderr, "[%s] Usage: %s initialPC regFileName instMemFileName dataMemFileName numCycles\n", __func__, argv[0]);
+#endif
     fflush(stdout);
   }
+#endif
 
   const std::int32_t initialPC = (std::int32_t)(atoll(argv[1])) - 4;
   const char *regFileName = argv[2];
@@ -12,17 +64,77 @@ int main(int argc, char **argv) {
   const char *dataMemFileName = argv[4];
   const std::uint64_t numCycles = (std::uint64_t)atoll(argv[5]);
 
+#ifdef ENABLE_OUT_OF_ORDER
+  OutOfOrderCPU *cpu = new OutOfOrderCPU(
+    "OutOfOrderCPU",
+    initialPC,
+    Memory::LittleEndian,
+    regFileName, instMemFileName, dataMemFileName);
+#else
   PipelinedCPU *cpu = new PipelinedCPU(
     "PipelinedCPU",
     initialPC,
     Memory::LittleEndian,
     regFileName, instMemFileName, dataMemFileName);
+#endif
+
+#ifdef ENABLE_VCD_DUMP
+  if (argc == 9) {
+    cpu->openVCD(argv[6], (std::uint64_t)atoll(argv[7]), (std::uint64_t)atoll(argv[8]));
+  } else {
+    cpu->openVCD(argv[6]);
+  }
+#endif
+
+#ifdef ENABLE_PIPEVIEW
+  if (argc == 9) {
+    cpu->openPipeView(argv[6], (std::uint64_t)atoll(argv[7]), (std::uint64_t)atoll(argv[8]));
+  } else {
+    cpu->openPipeView(argv[6]);
+  }
+#endif
 
+#ifdef ENABLE_PVS_ARCHIVE
+  cpu->openPVSArchive(argv[6]);
+#endif
+
+#ifdef ENABLE_STATE_DIGEST
+  // only the digests are compared; the PVS is printed for the first
+  // divergent cycle alone
+  StateDigestFile digestFile(argv[7],
+    strcmp(argv[6], "record") == 0 ? StateDigestFile::Record : StateDigestFile::Check,
+    argc == 9 ? (std::uint64_t)atoll(argv[8]) : 1);
+  for (size_t i = 0; i <= numCycles; i++) {
+    if (i > 0) {
+      cpu->advanceCycle();
+    }
+    if (!digestFile.isSampled(i)) {
+      continue;
+    }
+    const std::uint64_t digest = cpu->getStateDigest();
+    if (!digestFile.sample(i, digest)) {
+      if (digestFile.isEndOfFile()) {
+        printf("INFO: the golden run ends before cycle %lu\n", (unsigned long)i);
+        break;
+      }
+      printf("ERROR: the state diverges at cycle %lu (digest 0x%016llx, golden 0x%016llx)\n",
+             (unsigned long)i, (unsigned long long)digest,
+             (unsigned long long)digestFile.getGoldenDigest());
+      cpu->printPVS();
+      delete cpu;
+      return 1;
+    }
+  }
+  printf("INFO: %lu digests %s\n", (unsigned long)digestFile.getNumSamples(),
+         strcmp(argv[6], "record") == 0 ? "recorded" : "matched");
+#else
   cpu->printPVS();
   for (size_t i = 0; i < numCycles; i++) {
     cpu->advanceCycle();
     cpu->printPVS();
   }
+#endif
+  cpu->printStats();
 
   delete cpu;
 